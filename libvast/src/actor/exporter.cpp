@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <iterator>
+
 #include "vast/event.hpp"
 #include "vast/logger.hpp"
 #include "vast/actor/atoms.hpp"
@@ -7,8 +10,8 @@
 #include "vast/concept/printable/vast/event.hpp"
 #include "vast/concept/printable/vast/error.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
+#include "vast/concept/printable/vast/json.hpp"
 #include "vast/concept/printable/vast/time.hpp"
-#include "vast/expr/evaluator.hpp"
 #include "vast/expr/resolver.hpp"
 #include "vast/util/assert.hpp"
 
@@ -16,55 +19,174 @@ using namespace std::string_literals;
 
 namespace vast {
 
+namespace {
+
+// Obtains the decoded events of a chunk from the cache. EXPORTER spawns a
+// decoder for each chunk it receives, so that several chunks decompress in
+// parallel on the workers of the scheduler.
+behavior decoder(event_based_actor* self, std::shared_ptr<chunk_cache> cache) {
+  return {
+    [=](chunk const& chk) {
+      auto rp = self->make_response_promise();
+      self->quit(exit::done);
+      auto events = cache->lookup(chk);
+      if (events)
+        rp.deliver(make_message(candidate_atom::value, chk.base(),
+                                std::move(*events)));
+      else
+        rp.deliver(make_message(std::move(events.error())));
+    }
+  };
+}
+
+// The minimum number of hits which a checker receives, so that the cost of
+// spawning a checker does not dominate the candidate checks.
+constexpr size_t min_range_size = 1024;
+
+// Performs the candidate check for a sequence of hits in a decoded chunk and
+// appends the events which pass to the results, stopping after *limit*
+// results. A checker for each type compiles lazily.
+trial<void> check(exporter::slot const& s, expression const& query,
+                  std::unordered_map<type, expr::checker>& checkers,
+                  std::vector<event_id> const& ids, uint64_t limit,
+                  std::vector<event>& results, uint64_t& candidates) {
+  for (auto id : ids) {
+    auto candidate = s.read(id);
+    ++candidates;
+    if (!candidate) {
+      if (candidate.empty())
+        return error{"failed to extract event ", id};
+      return error{"failed to extract event ", id, ": ", candidate.error()};
+    }
+    auto& t = candidate->type();
+    auto checker = checkers.find(t);
+    if (checker == checkers.end()) {
+      auto r = visit(expr::schema_resolver{t}, query);
+      if (!r)
+        return error{"failed to resolve ", to_string(query), ": ", r.error()};
+      auto resolved = visit(expr::type_resolver{t}, *r);
+      VAST_DEBUG("resolved AST for", t << ':', resolved);
+      checker = checkers.emplace(t, expr::checker{resolved, t}).first;
+    }
+    if (!checker->second(*candidate)) {
+      VAST_WARN("ignores false positive:", *candidate);
+      continue;
+    }
+    results.push_back(std::move(*candidate));
+    if (results.size() == limit)
+      break;
+  }
+  return nothing;
+}
+
+// Checks a contiguous range of the hits in a decoded chunk. EXPORTER spawns
+// a checker for each range, so that the ranges of a chunk get checked in
+// parallel on the workers of the scheduler.
+behavior candidate_checker(event_based_actor* self, exporter::slot s,
+                           interned_expression query,
+                           std::vector<event_id> ids, uint64_t limit) {
+  return {
+    [=](check_atom, uint64_t range) {
+      auto rp = self->make_response_promise();
+      self->quit(exit::done);
+      std::unordered_map<type, expr::checker> checkers;
+      std::vector<event> results;
+      auto candidates = uint64_t{0};
+      auto t = check(s, *query, checkers, ids, limit, results, candidates);
+      if (t)
+        rp.deliver(make_message(check_atom::value, range, std::move(results),
+                                candidates));
+      else
+        rp.deliver(make_message(std::move(t.error())));
+    }
+  };
+}
+
+} // namespace <anonymous>
+
+result<event> exporter::slot::read(event_id id) const {
+  auto& xs = events.get_as<std::vector<event>>(0);
+  auto i = std::lower_bound(
+    xs.begin(), xs.end(), id,
+    [](event const& e, event_id x) { return e.id() < x; });
+  if (i == xs.end() || i->id() != id)
+    return error{"no event with id ", id};
+  return *i;
+}
+
 exporter::state::state(local_actor* self)
   : basic_state{self, "exporter"},
     id{uuid::random()} {
+  // Prefetching repeatedly searches the unprocessed hits for the next chunk
+  // to fetch, which the directory turns into a logarithmic lookup.
+  unprocessed.attach_directory();
 }
 
 behavior exporter::make(stateful_actor<state>* self, expression expr,
-                        query_options opts) {
-  // Prefetches the next chunk and sets the "inflight" chunk status. If we
-  // don't have a chunk yet, we look for the chunk corresponding to the last
-  // unprocessed hit. If we have a chunk, we try to get the next chunk in the
-  // ID space. If no such chunk exists, we try to get a chunk located before
-  // the current one. If neither exist, we don't do anything.
-  auto prefetch = [=] {
-    if (self->state.inflight)
+                        query_options opts, size_t prefetch,
+                        size_t parallelism,
+                        std::shared_ptr<chunk_cache> cache,
+                        projection proj, std::shared_ptr<aggregation> agg) {
+  VAST_ASSERT(prefetch > 0);
+  VAST_ASSERT(parallelism > 0);
+  VAST_ASSERT(cache != nullptr);
+  self->state.prefetch = prefetch;
+  self->state.parallelism = parallelism;
+  self->state.cache = std::move(cache);
+  self->state.projection = std::move(proj);
+  self->state.aggregation = std::move(agg);
+  self->state.newest_first = has_newest_first_option(opts);
+  self->state.explain = has_explain_option(opts);
+  // We intern the query once so that neither the messages to INDEX nor the
+  // handlers below copy the expression tree.
+  self->state.query = interned_expression{std::move(expr)};
+  // Returns the chunk in the window to process next.
+  auto front = [=] {
+    auto& w = self->state.window;
+    return self->state.newest_first ? std::prev(w.end()) : w.begin();
+  };
+  // Requests the chunk for the first unprocessed hit which no chunk in the
+  // window covers, unless the window is full. We only learn the boundaries
+  // of a chunk as it arrives, so there exists at most one request in flight
+  // and we issue the next one when its chunk comes back. For newest-first
+  // queries, we go backwards from the last unprocessed hit.
+  auto prefetch_chunk = [=] {
+    if (self->state.inflight
+        || self->state.window.size() >= self->state.prefetch)
       return;
-    if (self->state.current_chunk.events() == 0) {
-      auto last = self->state.unprocessed.find_last();
-      if (last != bitstream_type::npos) {
-        VAST_DEBUG_AT(self, "prefetches chunk for ID", last);
-        for (auto& a : self->state.archives)
-          self->send(a, last);
-        self->state.inflight = true;
+    auto& unprocessed = self->state.unprocessed;
+    auto next = bitstream_type::npos;
+    if (self->state.newest_first) {
+      next = unprocessed.find_last();
+      for (auto x = self->state.window.rbegin();
+           x != self->state.window.rend(); ++x) {
+        if (next == bitstream_type::npos || next > x->second.last)
+          break;
+        if (next >= x->first)
+          next = unprocessed.find_prev(x->first);
       }
     } else {
-      VAST_DEBUG_AT(self, "looks for next unprocessed ID after",
-                 self->state.current_chunk.meta().ids.find_last());
-      auto next = self->state.unprocessed.find_next(
-        self->state.current_chunk.meta().ids.find_last());
-      if (next != bitstream_type::npos) {
-        VAST_DEBUG_AT(self, "prefetches chunk for next ID", next);
-        for (auto& a : self->state.archives)
-          self->send(a, next);
-        self->state.inflight = true;
-      } else {
-        auto prev = self->state.unprocessed.find_prev(
-          self->state.current_chunk.meta().ids.find_first());
-        if (prev != bitstream_type::npos) {
-          VAST_DEBUG_AT(self, "prefetches chunk for previous ID", prev);
-          for (auto& a : self->state.archives)
-            self->send(a, prev);
-          self->state.inflight = true;
-        }
+      next = unprocessed.find_first();
+      for (auto& x : self->state.window) {
+        if (next == bitstream_type::npos || next < x.first)
+          break;
+        if (next <= x.second.last)
+          next = unprocessed.find_next(x.second.last);
       }
     }
+    if (next == bitstream_type::npos)
+      return;
+    VAST_DEBUG_AT(self, "prefetches chunk for ID", next);
+    for (auto& a : self->state.archives)
+      self->send(a, next);
+    self->state.inflight = true;
   };
   // Integrate hits from INDEX.
   auto incorporate_hits = [=](bitstream_type const& hits) {
     auto now = time::snapshot();
     auto num_hits = hits.count();
+    if (self->state.total_hits == 0)
+      self->state.first_hit = now;
     if (self->state.accountant) {
       if (self->state.total_hits == 0)
         self->send(self->state.accountant, "exporter", "hits.first", now);
@@ -78,7 +200,87 @@ behavior exporter::make(stateful_actor<state>* self, expression expr,
     self->state.total_hits += num_hits;
     self->state.hits |= hits;
     self->state.unprocessed |= hits;
-    prefetch();
+    prefetch_chunk();
+  };
+  // Puts a chunk from ARCHIVE into the window and hands it to a decoder.
+  auto incorporate_chunk = [=](chunk const& chk) {
+    VAST_DEBUG_AT(self, "got chunk [" << chk.base() << ','
+                                   << (chk.base() + chk.events()) << ")");
+    self->state.inflight = false;
+    auto& s = self->state.window[chk.base()];
+    s.chk = chk;
+    s.last = chk.meta().ids.find_last();
+    self->send(self->spawn(decoder, self->state.cache), chk);
+    prefetch_chunk();
+  };
+  // Stores the decoded events of a chunk in the window.
+  auto incorporate_events = [=](candidate_atom, event_id base,
+                                message const& events) {
+    auto s = self->state.window.find(base);
+    VAST_ASSERT(s != self->state.window.end());
+    VAST_DEBUG_AT(self, "decoded chunk", base);
+    s->second.events = events;
+    s->second.decoded = true;
+  };
+  // Handle errors from decoders and checkers.
+  auto handle_error = [=](error const& e) {
+    VAST_ERROR_AT(self, "failed to process chunk:", e);
+    self->quit(exit::error);
+  };
+  // Sends results to SINKs, projected onto the requested fields, or adds
+  // them to the aggregation.
+  auto deliver = [=](std::vector<event> results) {
+    if (results.empty())
+      return;
+    if (self->state.total_results == 0 && self->state.accountant) {
+      auto now = time::snapshot();
+      self->send(self->state.accountant, "exporter", "taste", now);
+    }
+    self->state.total_results += results.size();
+    if (self->state.aggregation) {
+      for (auto& e : results)
+        self->state.aggregation->add(e);
+      return;
+    }
+    if (!self->state.projection.empty())
+      for (auto& e : results)
+        e = self->state.projection(e);
+    auto msg = make_message(self->state.id, std::move(results));
+    for (auto& s : self->state.sinks)
+      self->send(s, msg);
+  };
+  // Keeps a result of a newest-first query. Only the requested number of
+  // youngest results can make it to SINKs.
+  auto retain = [=](event e) {
+    auto& newest = self->state.newest;
+    auto k = std::make_pair(e.timestamp(), e.id());
+    newest.emplace(k, std::move(e));
+    if (newest.size() > self->state.requested)
+      newest.erase(newest.begin());
+  };
+  // Sends the retained results younger than the horizon of INDEX, youngest
+  // first. Before that, we must have checked all hits which INDEX delivered,
+  // as any of them may refer to a younger event. Returns `true` iff this
+  // completes the requested results.
+  auto release = [=] {
+    if (!self->state.newest_first || !self->state.unprocessed.all_zeros())
+      return false;
+    auto& newest = self->state.newest;
+    std::vector<event> results;
+    while (!newest.empty() && self->state.requested > 0) {
+      auto youngest = std::prev(newest.end());
+      if (!(self->state.horizon < youngest->first.first))
+        break;
+      results.push_back(std::move(youngest->second));
+      newest.erase(youngest);
+      --self->state.requested;
+    }
+    if (results.empty())
+      return false;
+    VAST_DEBUG_AT(self, "releases", results.size(), "results,",
+                  newest.size(), "retained");
+    deliver(std::move(results));
+    return self->state.requested == 0;
   };
   // Handle progress updates from INDEX.
   auto handle_progress =
@@ -88,23 +290,68 @@ behavior exporter::make(stateful_actor<state>* self, expression expr,
           self->send(s, self->state.id, progress_atom::value,
                      self->state.progress, self->state.total_hits);
     };
-  // Handle DOWN from source.
-  auto handle_down = [=](down_msg const& msg) {
-    VAST_DEBUG_AT("got DOWN from", msg.source);
-    if (self->state.archives.erase(actor_cast<archive::type>(msg.source)) > 0)
-      return;
-    if (self->state.indexes.erase(actor_cast<actor>(msg.source)) > 0)
-      return;
-    if (self->state.sinks.erase(actor_cast<actor>(msg.source)) > 0)
-      return;
+  // Collects the explanation of a query from INDEX.
+  auto handle_explain = [=](explain_atom, json& plan) {
+    VAST_DEBUG_AT(self, "got explanation from", self->current_sender());
+    self->state.plans.push_back(std::move(plan));
+  };
+  // Describes the execution of the query, in microseconds for all durations.
+  auto explain_query = [=](time::extent runtime) {
+    auto us = [](time::extent x) {
+      return time::duration_cast<time::microseconds>(x).count();
+    };
+    auto& st = self->state;
+    auto candidates = st.total_candidates + st.chunk_candidates;
+    auto false_positives = candidates - st.total_positives;
+    auto first_hit = st.total_hits == 0 ? time::extent::zero()
+                                        : st.first_hit - st.start_time;
+    json::object plan{
+      {"expression", to_string(*st.query)},
+      {"index", std::move(st.plans)},
+      {"hits", st.total_hits},
+      {"chunks", st.total_chunks},
+      {"candidates", candidates},
+      {"false_positives", false_positives},
+      {"false_positive_rate",
+       candidates == 0 ? 0.0 : double(false_positives) / candidates},
+      {"results", st.total_results},
+      {"time", json::object{
+        {"index", us(st.index_time)},
+        {"first_hit", us(first_hit)},
+        {"archive", us(st.total_wait + st.chunk_wait)},
+        {"check", us(st.check_time)},
+        {"total", us(runtime)}
+      }}
+    };
+    return to_string(json{std::move(plan)});
   };
   // Finish query execution.
   auto complete = [=] {
     auto now = time::snapshot();
     auto runtime = now - self->state.start_time;
+    if (self->state.aggregation) {
+      auto rows = self->state.aggregation->results();
+      if (self->state.accountant)
+        self->send(self->state.accountant, "exporter", "groups",
+                   uint64_t{rows.size()});
+      if (!rows.empty()) {
+        auto msg = make_message(self->state.id, std::move(rows));
+        for (auto& s : self->state.sinks)
+          self->send(s, msg);
+      }
+    }
+    if (self->state.explain) {
+      auto msg = make_message(self->state.id, explain_atom::value,
+                              explain_query(runtime));
+      for (auto& s : self->state.sinks)
+        self->send(s, msg);
+    }
     for (auto& s : self->state.sinks)
       self->send(s, self->state.id, done_atom::value, runtime);
-    VAST_VERBOSE_AT(self, "took", runtime, "for:", expr);
+    VAST_VERBOSE_AT(self, "took", runtime, "for:", self->state.query);
+    // INDEX may still be looking up hits for us, which we no longer need.
+    for (auto& i : self->state.indexes)
+      self->send(i, self->state.query, disable_atom::value);
     if (self->state.accountant) {
       self->send(self->state.accountant, "exporter", "end", now);
       self->send(self->state.accountant, "exporter", "hits",
@@ -113,35 +360,63 @@ behavior exporter::make(stateful_actor<state>* self, expression expr,
                  self->state.total_results);
       self->send(self->state.accountant, "exporter", "chunks",
                  self->state.total_chunks);
+      self->send(self->state.accountant, "exporter", "wait",
+                 self->state.total_wait);
       self->send(self->state.accountant, "exporter", "selectivity",
                  double(self->state.total_results) / self->state.total_hits);
     }
     self->quit(exit::done);
   };
+  // Handle DOWN from source.
+  auto handle_down = [=](down_msg const& msg) {
+    VAST_DEBUG_AT("got DOWN from", msg.source);
+    if (self->state.archives.erase(actor_cast<archive::type>(msg.source)) > 0)
+      return;
+    if (self->state.indexes.erase(actor_cast<actor>(msg.source)) > 0)
+      return;
+    if (self->state.sinks.erase(actor_cast<actor>(msg.source)) > 0) {
+      // Without SINKs, nobody needs our results anymore.
+      if (self->state.sinks.empty()) {
+        VAST_DEBUG_AT(self, "lost all sinks");
+        complete();
+      }
+      return;
+    }
+  };
+  // Handle the horizon of a newest-first query from INDEX.
+  auto handle_horizon = [=](historical_atom, time::point horizon) {
+    VAST_DEBUG_AT(self, "got horizon", horizon);
+    self->state.horizon = horizon;
+    if (release())
+      complete();
+  };
   auto extracting = std::make_shared<behavior>(); // break cyclic dependency
   // In "waiting" state, EXPORTER has submitted requests for specific IDs to
-  // ARCHIVE and waits for the corresponding chunks to return. As EXPORTER
-  // receives a chunk, it instantiates a chunk reader and transitions to
-  // "extracting" state.
+  // ARCHIVE and waits until the first chunk in the window has been decoded.
+  // Then it transitions to "extracting" state.
   behavior waiting = {
     handle_down,
     handle_progress,
+    handle_horizon,
+    handle_explain,
+    handle_error,
     incorporate_hits,
-    [=](chunk const& chk) {
-      VAST_DEBUG_AT(self, "got chunk [" << chk.base() << ','
-                                     << (chk.base() + chk.events()) << ")");
-      self->state.inflight = false;
-      self->state.current_chunk = chk;
-      VAST_ASSERT(!self->state.reader);
-      self->state.reader =
-        std::make_unique<chunk::reader>(self->state.current_chunk);
+    incorporate_chunk,
+    [=](candidate_atom, event_id base, message const& events) {
+      incorporate_events(candidate_atom::value, base, events);
+      if (!front()->second.decoded)
+        return;
+      self->state.chunk_wait += time::snapshot() - self->state.wait_start;
       VAST_DEBUG_AT(self, "becomes extracting");
       self->become(*extracting);
       if (self->state.requested > 0)
         self->send(self, extract_atom::value);
-      prefetch();
     }
   };
+  auto wait_for_chunks = [=] {
+    self->state.wait_start = time::snapshot();
+    self->become(waiting);
+  };
   // In "idle" state, EXPORTER has received the task from INDEX and hangs
   // around waiting for hits. If EXPORTER receives new hits, it asks ARCHIVE
   // for the corresponding chunks and enters "waiting" state. If INDEX returns
@@ -149,15 +424,19 @@ behavior exporter::make(stateful_actor<state>* self, expression expr,
   behavior idle = {
     handle_down,
     handle_progress,
+    handle_horizon,
+    handle_explain,
     [=](bitstream_type const& hits) {
       incorporate_hits(hits);
       if (self->state.inflight) {
         VAST_DEBUG_AT(self, "becomes waiting (pending in-flight chunks)");
-        self->become(waiting);
+        wait_for_chunks();
       }
     },
-    [=](done_atom, time::moment end, time::extent runtime, expression const&) {
+    [=](done_atom, time::moment end, time::extent runtime,
+        interned_expression const&) {
       VAST_VERBOSE_AT(self, "completed index interaction in", runtime);
+      self->state.index_time = runtime;
       if (self->state.accountant)
         self->send(self->state.accountant, "exporter", "hits.done", end);
       // If EXPORTER never leaves "idle" state, it hasn't received any hits,
@@ -168,17 +447,137 @@ behavior exporter::make(stateful_actor<state>* self, expression expr,
       // always cause prefetching of corresponding chunks, a transition back to
       // "idle" ipmlies that there exist no more in-flight chunks.
       // Consequently, there exist no more unprocessed hits and EXPORTER can
-      // terminate.
+      // terminate, after having sent the results of a newest-first query.
+      self->state.horizon = time::duration::min();
+      release();
+      complete();
+    }
+  };
+  // Records the results of checking the hits in *mask* of the chunk at
+  // *base*. If there are more results than requested, the hits after the
+  // last requested result remain unprocessed.
+  auto finish = [=](event_id base, std::vector<event> results,
+                    bitstream_type mask) {
+    auto current = self->state.window.find(base);
+    VAST_ASSERT(current != self->state.window.end());
+    auto extracted = uint64_t{0};
+    auto last = mask.find_last();
+    self->state.total_positives += results.size();
+    if (!self->state.newest_first
+        && results.size() >= self->state.requested) {
+      results.erase(results.begin() + self->state.requested, results.end());
+      last = results.back().id();
+    }
+    self->state.chunk_results += results.size();
+    if (self->state.newest_first) {
+      for (auto& e : results)
+        retain(std::move(e));
+    } else {
+      extracted = results.size();
+      deliver(std::move(results));
+    }
+    // Record processed events.
+    self->state.requested -= extracted;
+    bitstream_type partial{mask};
+    if (!self->state.newest_first)
+      partial &= bitstream_type{last + 1, true};
+    self->state.unprocessed -= partial;
+    mask -= partial;
+    VAST_DEBUG_AT(self, "extracted", extracted,
+               "events (" << partial.count() << '/' << mask.count(),
+               "processed/remaining hits in current chunk)");
+    if (!mask.all_zeros()) {
+      // We continue in "extracting" state until we have processed the
+      // current chunk in its entirety. But we only do work if the client
+      // requested it.
+      if (self->state.requested > 0)
+        self->send(self, extract_atom::value);
+    } else {
+      ++self->state.total_chunks;
+      if (self->state.accountant) {
+        auto now = time::snapshot();
+        self->send(self->state.accountant, "exporter", "chunk.done", now);
+        self->send(self->state.accountant, "exporter", "chunk.candidates",
+                   self->state.chunk_candidates);
+        self->send(self->state.accountant, "exporter", "chunk.results",
+                   self->state.chunk_results);
+        self->send(self->state.accountant, "exporter", "chunk.events",
+                   current->second.chk.events());
+        self->send(self->state.accountant, "exporter", "chunk.wait",
+                   self->state.chunk_wait);
+      }
+      self->state.window.erase(current);
+      self->state.total_wait += self->state.chunk_wait;
+      self->state.total_candidates += self->state.chunk_candidates;
+      self->state.chunk_wait = time::extent::zero();
+      self->state.chunk_candidates = 0;
+      self->state.chunk_results = 0;
+      // Removing the chunk frees a slot in the window.
+      prefetch_chunk();
+      if (release()) {
+        VAST_DEBUG_AT(self, "completes newest-first query");
+        complete();
+        return;
+      }
+      if (self->state.window.empty() && !self->state.inflight) {
+        // After having finished a chunk and having no more chunks in the
+        // window, we're transitioning back to *idle*.
+        VAST_DEBUG_AT(self, "becomes idle (no more in-flight chunks)");
+        self->become(idle);
+      } else if (self->state.window.empty() || !front()->second.decoded) {
+        VAST_DEBUG_AT(self, "becomes waiting (pending in-flight chunks)");
+        wait_for_chunks();
+      } else if (self->state.requested > 0) {
+        self->send(self, extract_atom::value);
+      }
+    }
+    if (self->state.requested == 0 && self->state.draining) {
+      VAST_DEBUG_AT(self, "stops after having drained all requested events");
       complete();
     }
   };
-  // In "extracting" state, EXPORTER has received at least one chunk from
-  // ARCHIVE that it can process and extract results from by peforming a
-  // candidate check against the hits.
+  // In "checking" state, checkers perform the candidate checks for the ranges
+  // of the hits in the chunk at *base*. After all of them have reported
+  // back, EXPORTER merges their results in ID order and returns to
+  // "extracting" state.
+  auto checking = [=](event_id base, bitstream_type mask) -> behavior {
+    return {
+      handle_down,
+      handle_progress,
+      handle_horizon,
+      handle_explain,
+      handle_error,
+      incorporate_hits,
+      incorporate_chunk,
+      incorporate_events,
+      [=](check_atom, uint64_t range, std::vector<event>& results,
+          uint64_t candidates) {
+        self->state.chunk_candidates += candidates;
+        self->state.ranges[range] = std::move(results);
+        if (--self->state.pending_ranges > 0)
+          return;
+        self->state.check_time += time::snapshot() - self->state.check_start;
+        std::vector<event> merged;
+        for (auto& r : self->state.ranges)
+          std::move(r.begin(), r.end(), std::back_inserter(merged));
+        self->state.ranges.clear();
+        self->become(*extracting);
+        finish(base, std::move(merged), mask);
+      }
+    };
+  };
+  // In "extracting" state, the first chunk in the window has been decoded and
+  // EXPORTER extracts results from it by peforming a candidate check against
+  // the hits.
   *extracting = {
     handle_down,
     handle_progress,
+    handle_horizon,
+    handle_explain,
+    handle_error,
     incorporate_hits,
+    incorporate_chunk,
+    incorporate_events,
     [=](stop_atom) {
       VAST_DEBUG_AT(self, "got request to drain and terminate");
       self->state.draining = true;
@@ -209,110 +608,56 @@ behavior exporter::make(stateful_actor<state>* self, expression expr,
     },
     [=](extract_atom) {
       VAST_ASSERT(self->state.requested > 0);
-      VAST_ASSERT(self->state.reader);
+      VAST_ASSERT(!self->state.window.empty());
+      auto& current = front()->second;
+      // A chunk with smaller IDs (or larger ones for newest-first queries)
+      // may have entered the window after the current one. We process it
+      // first to deliver results in ID order.
+      if (!current.decoded) {
+        VAST_DEBUG_AT(self, "becomes waiting (first chunk not yet decoded)");
+        wait_for_chunks();
+        return;
+      }
       // We construct a new mask for each extraction request, because hits may
       // continuously update in every state.
-      bitstream_type mask{self->state.current_chunk.meta().ids};
+      bitstream_type mask{current.chk.meta().ids};
       mask &= self->state.unprocessed;
       VAST_ASSERT(mask.count() > 0);
       // Go through the current chunk and perform a candidate check for each
-      // hit, relaying event to the sink on success.
-      auto extracted = uint64_t{0};
-      auto last = event_id{0};
-      std::vector<event> results;
-      for (auto id : mask) {
-        last = id;
-        auto candidate = self->state.reader->read(id);
-        ++self->state.chunk_candidates;
-        if (candidate) {
-          auto& checker = self->state.checkers[candidate->type()];
-          // Construct a candidate checker if we don't have one for this type.
-          if (is<none>(checker)) {
-            auto t = visit(expr::schema_resolver{candidate->type()}, expr);
-            if (!t) {
-              VAST_ERROR_AT(self, "failed to resolve", expr << ',', t.error());
-              self->quit(exit::error);
-              return;
-            }
-            checker = visit(expr::type_resolver{candidate->type()}, *t);
-            VAST_DEBUG_AT(self, "resolved AST for",
-                          candidate->type() << ':', checker);
-          }
-          // Perform candidate check and keep event as result on success.
-          if (visit(expr::event_evaluator{*candidate}, checker)) {
-            results.push_back(std::move(*candidate));
-            if (++extracted == self->state.requested)
-              break;
-          } else {
-            VAST_WARN(self, "ignores false positive:", *candidate);
-          }
-        } else {
-          if (candidate.empty())
-            VAST_ERROR_AT(self, "failed to extract event", id);
-          else
-            VAST_ERROR_AT(self, "failed to extract event", id << ':',
-                          candidate.error());
-          self->quit(exit::error);
+      // hit. Results of newest-first queries must wait until we know that no
+      // younger ones exist, so we go through the entire chunk.
+      std::vector<event_id> ids(mask.begin(), mask.end());
+      auto limit = self->state.newest_first ? max_events
+                                            : self->state.requested;
+      auto n = std::min(self->state.parallelism, ids.size() / min_range_size);
+      if (n <= 1) {
+        std::vector<event> results;
+        auto start = time::snapshot();
+        auto t = check(current, *self->state.query, self->state.checkers, ids,
+                       limit, results, self->state.chunk_candidates);
+        self->state.check_time += time::snapshot() - start;
+        if (!t) {
+          handle_error(t.error());
           return;
         }
+        finish(front()->first, std::move(results), std::move(mask));
+        return;
       }
-      // Send results to SINKs.
-      if (!results.empty()) {
-        auto msg = make_message(self->state.id, std::move(results));
-        for (auto& s : self->state.sinks)
-          self->send(s, msg);
-        if (self->state.total_results == 0 && self->state.accountant) {
-          auto now = time::snapshot();
-          self->send(self->state.accountant, "exporter", "taste", now);
-        }
-        self->state.total_results += extracted;
-        self->state.chunk_results += extracted;
-      }
-      // Record processed events.
-      self->state.requested -= extracted;
-      bitstream_type partial{last + 1, true};
-      partial &= mask;
-      self->state.unprocessed -= partial;
-      mask -= partial;
-      VAST_DEBUG_AT(self, "extracted", extracted,
-                 "events (" << partial.count() << '/' << mask.count(),
-                 "processed/remaining hits in current chunk)");
-      if (!mask.all_zeros()) {
-        // We continue in "extracting" state until we have processed the
-        // current chunk in its entirety. But we only do work if the client
-        // requested it.
-        if (self->state.requested > 0)
-          self->send(self, self->current_message());
-      } else {
-        ++self->state.total_chunks;
-        if (self->state.inflight) {
-          VAST_DEBUG_AT(self, "becomes waiting (pending in-flight chunks)");
-          self->become(waiting);
-        } else {
-          // After having finished a chunk and having no more in-flight chunks,
-          // we're transitioning back to *idle*.
-          VAST_DEBUG_AT(self, "becomes idle (no more in-flight chunks)");
-          self->become(idle);
-        }
-        if (self->state.accountant) {
-          auto now = time::snapshot();
-          self->send(self->state.accountant, "exporter", "chunk.done", now);
-          self->send(self->state.accountant, "exporter", "chunk.candidates",
-                     self->state.chunk_candidates);
-          self->send(self->state.accountant, "exporter", "chunk.results",
-                     self->state.chunk_results);
-          self->send(self->state.accountant, "exporter", "chunk.events",
-                     self->state.current_chunk.events());
-        }
-        self->state.reader.reset();
-        self->state.current_chunk = {};
-        self->state.chunk_candidates = 0;
-        self->state.chunk_results = 0;
-      }
-      if (self->state.requested == 0 && self->state.draining) {
-        VAST_DEBUG_AT(self, "stops after having drained all requested events");
-        complete();
+      // With many hits, we split them into contiguous ranges of equal size
+      // and check each range in parallel.
+      VAST_DEBUG_AT(self, "checks", ids.size(), "hits in", n, "ranges");
+      self->state.ranges.clear();
+      self->state.ranges.resize(n);
+      self->state.pending_ranges = n;
+      self->state.check_start = time::snapshot();
+      for (auto i = size_t{0}; i < n; ++i) {
+        auto first = ids.begin() + i * ids.size() / n;
+        auto last = ids.begin() + (i + 1) * ids.size() / n;
+        auto c = self->spawn(candidate_checker, current, self->state.query,
+                             std::vector<event_id>(first, last), limit);
+        self->send(c, check_atom::value, uint64_t{i});
       }
+      self->become(checking(front()->first, std::move(mask)));
     }
   };
   return {
@@ -353,7 +698,7 @@ behavior exporter::make(stateful_actor<state>* self, expression expr,
       }
       for (auto& i : self->state.indexes) {
         VAST_DEBUG_AT(self, "sends query to index" << i);
-        self->send(i, expr, opts, self);
+        self->send(i, self->state.query, opts, self);
       }
       self->become(
         [=](actor const& task) {
@@ -1,7 +1,11 @@
+#include <algorithm>
+
+#include "vast/bitstream.hpp"
 #include "vast/event.hpp"
 #include "vast/actor/atoms.hpp"
 #include "vast/actor/importer.hpp"
 #include "vast/concept/printable/vast/error.hpp"
+#include "vast/concept/printable/vast/expression.hpp"
 
 namespace vast {
 
@@ -28,6 +32,26 @@ behavior importer::make(stateful_actor<state>* self) {
     }
     return true;
   };
+  // Ships a batch of events with IDs to ARCHIVE and INDEX, followed by the
+  // hits of all continuous queries.
+  auto ship = [=](std::vector<event> batch) {
+    auto& m = self->state.matcher;
+    std::vector<default_bitstream> hits(m.expressions().size());
+    if (!m.empty())
+      for (auto& e : batch)
+        for (auto i : m.match(e)) {
+          hits[i].append(e.id() - hits[i].size(), false);
+          hits[i].push_back(true);
+        }
+    auto msg = make_message(std::move(batch));
+    // FIXME: how to make this type-safe?
+    self->send(actor_cast<actor>(self->state.archive), msg);
+    self->send(self->state.index, msg);
+    for (size_t i = 0; i < hits.size(); ++i)
+      if (!hits[i].empty())
+        self->send(self->state.index, self->state.queries[i],
+                   std::move(hits[i]), continuous_atom::value);
+  };
   self->trap_exit(true);
   return {
     downgrade_exit_msg(self),
@@ -53,6 +77,18 @@ behavior importer::make(stateful_actor<state>* self) {
       VAST_DEBUG_AT(self, "registers index", a);
       self->monitor(a);
       self->state.index = a;
+      self->send(a, put_atom::value, importer_atom::value, self);
+    },
+    [=](interned_expression const& expr, continuous_atom) {
+      VAST_DEBUG_AT(self, "matches continuous query:", expr);
+      if (self->state.matcher.add(*expr))
+        self->state.queries.push_back(expr);
+    },
+    [=](interned_expression const& expr, continuous_atom, disable_atom) {
+      VAST_DEBUG_AT(self, "stops matching continuous query:", expr);
+      auto& qs = self->state.queries;
+      if (self->state.matcher.remove(*expr))
+        qs.erase(std::find(qs.begin(), qs.end(), expr));
     },
     [=](std::vector<event>& events) {
       VAST_DEBUG_AT(self, "got", events.size(), "events");
@@ -77,10 +113,7 @@ behavior importer::make(stateful_actor<state>* self) {
                 std::make_move_iterator(self->state.batch.begin() + n),
                 std::make_move_iterator(self->state.batch.end()));
               self->state.batch.resize(n);
-              auto msg = make_message(std::move(self->state.batch));
-              // FIXME: how to make this type-safe?
-              self->send(actor_cast<actor>(self->state.archive), msg);
-              self->send(self->state.index, msg);
+              ship(std::move(self->state.batch));
               self->state.batch = std::move(remainder);
             }
             VAST_VERBOSE_AT(self, "asks for more IDs: got", self->state.got,
@@ -89,10 +122,7 @@ behavior importer::make(stateful_actor<state>* self) {
                        needed - self->state.got);
           } else {
             // Ship the batch directly if we got enough IDs.
-            auto msg = make_message(std::move(self->state.batch));
-            // FIXME: how to make this type-safe?
-            self->send(actor_cast<actor>(self->state.archive), msg);
-            self->send(self->state.index, msg);
+            ship(std::move(self->state.batch));
             self->state.got = 0;
             self->unbecome();
           }
@@ -7,6 +7,7 @@
 #include "vast/actor/index.hpp"
 #include "vast/actor/partition.hpp"
 #include "vast/actor/task.hpp"
+#include "vast/expr/resolver.hpp"
 #include "vast/expr/restrictor.hpp"
 #include "vast/concept/convertible/vast/type.hpp"
 #include "vast/concept/printable/to_string.hpp"
@@ -37,8 +38,20 @@ void deserialize(Deserializer& source, index::partition_state& ps) {
 
 namespace {
 
+// Relays a message concerning continuous queries to the actors evaluating
+// them: the registered IMPORTERs or, in their absence, the active partitions.
+template <typename... Ts>
+void relay_continuous(stateful_actor<index::state>* self, Ts const&... xs) {
+  if (!self->state.importers.empty())
+    for (auto& i : self->state.importers)
+      self->send(i, xs...);
+  else
+    for (auto& a : self->state.active)
+      self->send(a.second, xs...);
+}
+
 maybe<actor> dispatch(stateful_actor<index::state>* self,
-                         uuid const& part, expression const& expr) {
+                      uuid const& part, interned_expression const& expr) {
   if (self->state.partitions[part].events == 0)
     return {};
   // If the partition is already scheduled, we add the expression to the set of
@@ -73,8 +86,50 @@ maybe<actor> dispatch(stateful_actor<index::state>* self,
   return {};
 }
 
+// Relays a historical query to a partition, which describes its lookup if
+// the query needs an explanation.
+void relay_historical(stateful_actor<index::state>* self, actor const& part,
+                      interned_expression const& expr,
+                      index::historical_query_state const& hist) {
+  if (hist.explain)
+    self->send(part, expr, historical_atom::value, explain_atom::value);
+  else
+    self->send(part, expr, historical_atom::value);
+}
+
+// Describes which partitions INDEX considers for a historical query and how
+// the query resolves against the types in them.
+json::object explain_plan(
+  stateful_actor<index::state>* self, interned_expression const& expr,
+  std::vector<std::pair<uuid const, index::partition_state>*> const& parts) {
+  uint64_t events = 0;
+  json::object resolved;
+  for (auto p : parts) {
+    events += p->second.events;
+    for (auto& t : p->second.schema) {
+      if (resolved.count(t.name()) > 0)
+        continue;
+      auto r = visit(expr::schema_resolver{t}, *expr);
+      if (r)
+        resolved[t.name()] = to_string(visit(expr::type_resolver{t}, *r));
+      else
+        resolved[t.name()] = to_string(r.error());
+    }
+  }
+  auto total = self->state.partitions.size();
+  return json::object{
+    {"partitions", json::object{
+      {"total", total},
+      {"considered", parts.size()},
+      {"pruned", total - parts.size()}
+    }},
+    {"events", events},
+    {"resolved", std::move(resolved)}
+  };
+}
+
 void consolidate(stateful_actor<index::state>*self,
-                 uuid const& part, expression const& expr) {
+                 uuid const& part, interned_expression const& expr) {
   VAST_DEBUG_AT(self, "consolidates", part, "for", expr);
   auto i = std::find_if(self->state.schedule.begin(),
                         self->state.schedule.end(),
@@ -129,13 +184,196 @@ void consolidate(stateful_actor<index::state>*self,
         VAST_ASSERT(q->second.hist);
         q->second.hist->parts.emplace(p->address(), entry.part);
         self->send(q->second.hist->task, p);
-        self->send(p, next_expr, historical_atom::value);
+        relay_historical(self, p, next_expr, *q->second.hist);
       }
       break;
     }
   }
 }
 
+// Stops the evaluation of a historical query. We remove the query from all
+// partitions in the schedule which have not yet received it, and ask the
+// partitions which have received it to skip their remaining lookups. The
+// query task completes once the latter report back.
+void cancel(stateful_actor<index::state>* self,
+            interned_expression const& expr,
+            index::historical_query_state& hist) {
+  VAST_VERBOSE_AT(self, "cancels historical query:", expr);
+  hist.cancelled = true;
+  auto i = self->state.schedule.begin();
+  while (i != self->state.schedule.end()) {
+    auto running = std::any_of(hist.parts.begin(), hist.parts.end(),
+                               [&](auto& p) { return p.second == i->part; });
+    auto x = i->queries.find(expr);
+    if (!running && x != i->queries.end())
+      i->queries.erase(x);
+    if (i->queries.empty()) {
+      VAST_DEBUG_AT(self, "removes partition from schedule:", i->part);
+      i = self->state.schedule.erase(i);
+    } else {
+      ++i;
+    }
+  }
+  for (auto& p : hist.parts)
+    self->send(actor_cast<actor>(p.first), expr, historical_atom::value,
+               disable_atom::value);
+}
+
+// Removes a subscriber from a query. Without subscribers, the query has no
+// purpose anymore, so we stop evaluating it.
+void unsubscribe(stateful_actor<index::state>* self,
+                 std::unordered_map<interned_expression,
+                                    index::query_state>::iterator q,
+                 actor const& subscriber) {
+  if (q->second.subscribers.erase(subscriber) == 0)
+    return;
+  VAST_VERBOSE_AT(self, "removes query subscriber", subscriber);
+  if (!q->second.subscribers.empty())
+    return;
+  if (q->second.cont) {
+    VAST_VERBOSE_AT(self, "disables continuous query:", q->first);
+    q->second.cont = nil;
+    relay_continuous(self, q->first, continuous_atom::value,
+                     disable_atom::value);
+  }
+  if (q->second.hist && q->second.hist->task && !q->second.hist->cancelled)
+    cancel(self, q->first, *q->second.hist);
+  if (!q->second.cont && (!q->second.hist || !q->second.hist->task)) {
+    VAST_VERBOSE_AT(self, "removes query:", q->first);
+    self->state.queries.erase(q);
+  }
+}
+
+// Computes the timestamp of the youngest event among all partitions which
+// have yet to deliver their hits for a historical query.
+time::point horizon(stateful_actor<index::state>* self,
+                    interned_expression const& expr,
+                    index::historical_query_state const& hist) {
+  auto result = time::point{time::duration::min()};
+  auto consider = [&](uuid const& part) {
+    auto& to = self->state.partitions[part].to;
+    if (to > result)
+      result = to;
+  };
+  for (auto& p : hist.parts)
+    consider(p.second);
+  for (auto& s : self->state.schedule)
+    if (s.queries.contains(expr))
+      consider(s.part);
+  return result;
+}
+
+// Checks whether an actor subscribes to any query.
+bool subscribed(stateful_actor<index::state>* self, actor const& subscriber) {
+  return std::any_of(self->state.queries.begin(), self->state.queries.end(),
+                     [&](auto& q) {
+                       return q.second.subscribers.contains(subscriber);
+                     });
+}
+
+// Subscribes an actor to a query and instantiates the query if needed.
+void subscribe(stateful_actor<index::state>* self,
+               interned_expression const& expr, query_options opts,
+               actor const& subscriber) {
+  VAST_VERBOSE_AT(self, "got query:", expr);
+  if (opts == no_query_options) {
+    VAST_WARN_AT(self, "ignores query with no options:", expr);
+    return;
+  }
+  // A cancelled query still completes its pending lookups. Until then,
+  // its hits are incomplete and we cannot hand them to new subscribers, so
+  // we subscribe them once the query completes. Likewise, a running query
+  // fixes the order of its partitions and whether it explains itself when it
+  // starts, so a subscriber asking for a different evaluation has to wait.
+  auto c = self->state.queries.find(expr);
+  if (c != self->state.queries.end() && c->second.hist) {
+    auto& hist = *c->second.hist;
+    if (hist.cancelled) {
+      VAST_DEBUG_AT(self, "defers query until cancellation completes");
+      hist.deferred.emplace_back(subscriber, opts);
+      return;
+    }
+    if (hist.task && has_historical_option(opts)
+        && (hist.newest_first != has_newest_first_option(opts)
+            || hist.explain != has_explain_option(opts))) {
+      VAST_DEBUG_AT(self, "defers query with different options until",
+                    "running query completes");
+      hist.deferred.emplace_back(subscriber, opts);
+      return;
+    }
+  }
+  if (!subscribed(self, subscriber))
+    self->monitor(subscriber);
+  auto& qs = self->state.queries[expr];
+  qs.subscribers.insert(subscriber);
+  if (has_historical_option(opts)) {
+    if (!qs.hist) {
+      VAST_DEBUG_AT(self, "instantiates historical query");
+      qs.hist = index::historical_query_state();
+    }
+    if (!qs.hist->task) {
+      VAST_VERBOSE_AT(self, "enables historical query");
+      qs.hist->task = self->spawn(
+        task::make<time::moment, interned_expression, historical_atom>,
+        time::snapshot(), expr, historical_atom::value);
+      self->send(qs.hist->task, supervisor_atom::value, self);
+      // Test whether this query matches any partition and relay it where
+      // possible. The schedule loads passive partitions in the order we
+      // dispatch them.
+      std::vector<std::pair<uuid const, index::partition_state>*> parts;
+      for (auto& p : self->state.partitions)
+        if (visit(expr::time_restrictor{p.second.from, p.second.to}, *expr))
+          parts.push_back(&p);
+      if (has_newest_first_option(opts)) {
+        qs.hist->newest_first = true;
+        std::sort(parts.begin(), parts.end(), [](auto x, auto y) {
+          return y->second.to < x->second.to;
+        });
+      }
+      if (has_explain_option(opts)) {
+        qs.hist->explain = true;
+        qs.hist->plan = explain_plan(self, expr, parts);
+        qs.hist->lookups.clear();
+      }
+      for (auto p : parts)
+        if (auto a = dispatch(self, p->first, expr)) {
+          qs.hist->parts.emplace(a->address(), p->first);
+          self->send(qs.hist->task, *a);
+          relay_historical(self, *a, expr, *qs.hist);
+        }
+      if (qs.hist->parts.empty()) {
+        VAST_DEBUG_AT(self, "did not find a partition for query");
+        self->send_exit(qs.hist->task, exit::done);
+        qs.hist->task = invalid_actor;
+        if (qs.hist->explain)
+          self->send(subscriber, explain_atom::value, json{qs.hist->plan});
+      }
+    }
+    self->send(subscriber, qs.hist->task);
+    if (!qs.hist->hits.empty() && !qs.hist->hits.all_zeros()) {
+      VAST_VERBOSE_AT(self, "relays", qs.hist->hits.count(), "cached hits");
+      self->send(subscriber, qs.hist->hits);
+    }
+  }
+  if (has_continuous_option(opts)) {
+    if (!qs.cont) {
+      VAST_DEBUG_AT(self, "instantiates continuous query");
+      qs.cont = index::continuous_query_state();
+    }
+    if (!qs.cont->task) {
+      VAST_VERBOSE_AT(self, "enables continuous query");
+      qs.cont->task = self->spawn(task::make<time::moment>, time::snapshot());
+      self->send(qs.cont->task, self);
+      // Relay the continuous query to IMPORTERs, or to all active
+      // partitions as these may still receive events.
+      relay_continuous(self, expr, continuous_atom::value);
+    }
+    self->send(subscriber, qs.cont->task);
+    if (!qs.cont->hits.empty() && !qs.cont->hits.all_zeros())
+      self->send(subscriber, qs.cont->hits);
+  }
+}
+
 void flush(stateful_actor<index::state>* self) {
   for (auto& p : self->state.partitions)
     if (p.second.events > 0) {
@@ -224,25 +462,32 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
         self->send_exit(p.second, msg.reason);
     },
     [=](down_msg const& msg) {
-      for (auto q = self->state.queries.begin();
-           q != self->state.queries.end(); ++q)
-        if (q->second.subscribers.erase(actor_cast<actor>(msg.source)) == 1) {
-          if (q->second.subscribers.empty()) {
-            VAST_VERBOSE_AT(self, "removes query subscriber", msg.source);
-            if (q->second.cont) {
-              VAST_VERBOSE_AT(self, "disables continuous query:", q->first);
-              q->second.cont = nil;
+      auto is_source = [&](auto& a) { return a.address() == msg.source; };
+      auto imp = std::find_if(self->state.importers.begin(),
+                              self->state.importers.end(), is_source);
+      if (imp != self->state.importers.end()) {
+        VAST_DEBUG_AT(self, "removes importer", msg.source);
+        self->state.importers.erase(imp);
+        // Without IMPORTERs, the active partitions take over the evaluation
+        // of continuous queries.
+        if (self->state.importers.empty())
+          for (auto& q : self->state.queries)
+            if (q.second.cont && q.second.cont->task)
               for (auto& a : self->state.active)
-                self->send(a.second, q->first, continuous_atom::value,
-                     disable_atom::value);
-            }
-            if (!q->second.cont && !q->second.hist) {
-              VAST_VERBOSE_AT(self, "removes query:", q->first);
-              self->state.queries.erase(q);
-            }
-          }
-          return;
-        }
+                self->send(a.second, q.first, continuous_atom::value);
+        return;
+      }
+      // A subscriber may take part in several queries. Unsubscribing may
+      // remove a query, so we collect the queries first.
+      auto subscriber = actor_cast<actor>(msg.source);
+      std::vector<interned_expression> exprs;
+      for (auto& q : self->state.queries)
+        if (q.second.subscribers.contains(subscriber))
+          exprs.push_back(q.first);
+      for (auto& expr : exprs)
+        unsubscribe(self, self->state.queries.find(expr), subscriber);
+      if (!exprs.empty())
+        return;
       for (auto i = self->state.active.begin();
            i != self->state.active.end(); ++i) {
         if (i->second.address() == msg.source) {
@@ -262,6 +507,21 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
         }
       }
     },
+    [=](put_atom, importer_atom, actor const& a) {
+      VAST_DEBUG_AT(self, "registers importer", a);
+      self->monitor(a);
+      auto takeover = self->state.importers.empty();
+      self->state.importers.push_back(a);
+      for (auto& q : self->state.queries)
+        if (q.second.cont && q.second.cont->task) {
+          self->send(a, q.first, continuous_atom::value);
+          // The first IMPORTER relieves the active partitions.
+          if (takeover)
+            for (auto& p : self->state.active)
+              self->send(p.second, q.first, continuous_atom::value,
+                         disable_atom::value);
+        }
+    },
     [=](accountant::type const& acc) {
       VAST_DEBUG_AT(self, "registers accountant#", acc->id());
       self->state.accountant = acc;
@@ -360,10 +620,11 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
           self->send(a.second, self->state.accountant);
         auto i = self->state.partitions.emplace(a.first, partition_state());
         part = &i.first->second;
-        // Register continuous queries.
-        for (auto& q : self->state.queries)
-          if (q.second.cont)
-            self->send(a.second, q.first, continuous_atom::value);
+        // Register continuous queries, unless IMPORTERs evaluate them.
+        if (self->state.importers.empty())
+          for (auto& q : self->state.queries)
+            if (q.second.cont && q.second.cont->task)
+              self->send(a.second, q.first, continuous_atom::value);
       }
       // Extract schema.
       util::flat_set<type> types;
@@ -413,68 +674,11 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
                              + make_message(std::move(sch))
                              + make_message(std::move(t)));
     },
-    [=](expression const& expr, query_options opts, actor const& subscriber) {
-      VAST_VERBOSE_AT(self, "got query:", expr);
-      if (opts == no_query_options) {
-        VAST_WARN_AT(self, "ignores query with no options:", expr);
-        return;
-      }
-      self->monitor(subscriber);
-      auto& qs = self->state.queries[expr];
-      qs.subscribers.insert(subscriber);
-      if (has_historical_option(opts)) {
-        if (!qs.hist) {
-          VAST_DEBUG_AT(self, "instantiates historical query");
-          qs.hist = historical_query_state();
-        }
-        if (!qs.hist->task) {
-          VAST_VERBOSE_AT(self, "enables historical query");
-          qs.hist->task
-            = self->spawn(task::make<time::moment, expression, historical_atom>,
-                    time::snapshot(), expr, historical_atom::value);
-          self->send(qs.hist->task, supervisor_atom::value, self);
-          // Test whether this query matches any partition and relay it where
-          // possible.
-          for (auto& p : self->state.partitions)
-            if (visit(expr::time_restrictor{p.second.from, p.second.to}, expr))
-              if (auto a = dispatch(self, p.first, expr)) {
-                qs.hist->parts.emplace(a->address(), p.first);
-                self->send(qs.hist->task, *a);
-                self->send(*a, expr, historical_atom::value);
-              }
-          if (qs.hist->parts.empty()) {
-            VAST_DEBUG_AT(self, "did not find a partition for query");
-            self->send_exit(qs.hist->task, exit::done);
-            qs.hist->task = invalid_actor;
-          }
-        }
-        self->send(subscriber, qs.hist->task);
-        if (!qs.hist->hits.empty() && !qs.hist->hits.all_zeros()) {
-          VAST_VERBOSE_AT(self, "relays", qs.hist->hits.count(), "cached hits");
-          self->send(subscriber, qs.hist->hits);
-        }
-      }
-      if (has_continuous_option(opts)) {
-        if (!qs.cont) {
-          VAST_DEBUG_AT(self, "instantiates continuous query");
-          qs.cont = continuous_query_state();
-        }
-        if (!qs.cont->task) {
-          VAST_VERBOSE_AT(self, "enables continuous query");
-          qs.cont->task =
-            self->spawn(task::make<time::moment>, time::snapshot());
-          self->send(qs.cont->task, self);
-          // Relay the continuous query to all active partitions, as these may
-          // still receive events.
-          for (auto& a : self->state.active)
-            self->send(a.second, expr, continuous_atom::value);
-        }
-        self->send(subscriber, qs.cont->task);
-        if (!qs.cont->hits.empty() && !qs.cont->hits.all_zeros())
-          self->send(subscriber, qs.cont->hits);
-      }
+    [=](interned_expression const& expr, query_options opts,
+        actor const& subscriber) {
+      subscribe(self, expr, opts, subscriber);
     },
-    [=](expression const& expr, continuous_atom, disable_atom) {
+    [=](interned_expression const& expr, continuous_atom, disable_atom) {
       VAST_VERBOSE_AT(self, "got request to disable continuous query:", expr);
       auto q = self->state.queries.find(expr);
       if (q == self->state.queries.end()) {
@@ -485,9 +689,23 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
         VAST_VERBOSE_AT(self, "disables continuous query:", expr);
         self->send(q->second.cont->task, done_atom::value);
         q->second.cont->task = invalid_actor;
+        relay_continuous(self, expr, continuous_atom::value,
+                         disable_atom::value);
+      }
+    },
+    [=](interned_expression const& expr, disable_atom) {
+      auto q = self->state.queries.find(expr);
+      if (q == self->state.queries.end()) {
+        VAST_DEBUG_AT(self, "ignores disable request for completed query:",
+                      expr);
+        return;
       }
+      auto subscriber = actor_cast<actor>(self->current_sender());
+      unsubscribe(self, q, subscriber);
+      if (!subscribed(self, subscriber))
+        self->demonitor(subscriber);
     },
-    [=](done_atom, time::moment start, expression const& expr) {
+    [=](done_atom, time::moment start, interned_expression const& expr) {
       auto runtime = time::snapshot() - start;
       VAST_DEBUG_AT(self, "got signal that", self->current_sender(), "took",
                     runtime, "to complete query: ", expr);
@@ -499,8 +717,26 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
       consolidate(self, p->second, expr);
       self->send(q->second.hist->task, done_atom::value, p->first);
       q->second.hist->parts.erase(p);
+      if (q->second.hist->newest_first && !q->second.hist->cancelled) {
+        auto h = horizon(self, expr, *q->second.hist);
+        for (auto& s : q->second.subscribers)
+          self->send(s, historical_atom::value, h);
+      }
     },
-    [=](done_atom, time::moment start, expression const& expr,
+    [=](interned_expression const& expr, explain_atom, json& lookup) {
+      auto q = self->state.queries.find(expr);
+      if (q == self->state.queries.end() || !q->second.hist
+          || !q->second.hist->explain)
+        return;
+      auto p = q->second.hist->parts.find(self->current_sender());
+      if (p == q->second.hist->parts.end())
+        return;
+      q->second.hist->lookups.push_back(json::object{
+        {"partition", to_string(p->second)},
+        {"lookup", std::move(lookup)}
+      });
+    },
+    [=](done_atom, time::moment start, interned_expression const& expr,
         historical_atom) {
       auto now = time::snapshot();
       auto runtime = now - start;
@@ -509,16 +745,32 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
       VAST_ASSERT(q != self->state.queries.end());
       VAST_ASSERT(q->second.hist);
       VAST_ASSERT(q->second.hist->parts.empty());
+      // The explanation precedes the completion.
+      auto& hist = *q->second.hist;
+      if (hist.explain) {
+        hist.plan["lookups"] = std::move(hist.lookups);
+        hist.plan["runtime"] =
+          time::duration_cast<time::microseconds>(runtime).count();
+        auto msg = make_message(explain_atom::value,
+                                json{std::move(hist.plan)});
+        for (auto& s : q->second.subscribers)
+          self->send(s, msg);
+      }
       // Notify subscribers about completion.
       for (auto& s : q->second.subscribers)
         self->send(s, done_atom::value, now, runtime, expr);
       // Remove query state.
       // TODO: consider caching it for a while and also record its coverage
       // so that future queries don't need to start over again.
+      auto deferred = std::move(hist.deferred);
       q->second.hist->task = invalid_actor;
       self->state.queries.erase(q);
+      // Deferred subscribers start a fresh query.
+      for (auto& d : deferred)
+        subscribe(self, expr, d.second, d.first);
     },
-    [=](expression const& expr, bitstream_type& hits, historical_atom) {
+    [=](interned_expression const& expr, bitstream_type& hits,
+        historical_atom) {
       VAST_DEBUG_AT(self, "received", hits.count(), "historical hits from",
                  self->current_sender(), "for query:", expr);
       auto& qs = self->state.queries[expr];
@@ -531,14 +783,20 @@ behavior index::make(stateful_actor<state>*self, path const& dir,
           self->send(s, msg);
       }
     },
-    [=](expression const& expr, bitstream_type& hits, continuous_atom) {
+    [=](interned_expression const& expr, bitstream_type& hits,
+        continuous_atom) {
       VAST_DEBUG_AT(self, "received", hits.count(), "continuous hits from",
                  self->current_sender(), "for query:", expr);
-      auto& qs = self->state.queries[expr];
-      VAST_ASSERT(qs.cont);
-      qs.cont->hits |= hits;
+      // Hits may still be in flight after a query has been disabled.
+      auto q = self->state.queries.find(expr);
+      if (q == self->state.queries.end() || !q->second.cont
+          || !q->second.cont->task) {
+        VAST_DEBUG_AT(self, "ignores hits of disabled query:", expr);
+        return;
+      }
+      q->second.cont->hits |= hits;
       auto msg = make_message(std::move(hits));
-      for (auto& s : qs.subscribers)
+      for (auto& s : q->second.subscribers)
         self->send(s, msg);
     },
     log_others(self)
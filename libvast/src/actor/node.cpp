@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <thread>
 #include <type_traits>
 
 // TODO: remove
@@ -83,6 +84,7 @@ behavior spawn_core(event_based_actor* self,
     std::string index_events;
     std::string index_active;
     std::string index_passive;
+    uint64_t chunk_cache_size = 0;
     // These must be kept in sync with the individual options for each actor.
     auto r = self->current_message().extract_opts({
       {"identifier-batch-size", "", id_batch_size},
@@ -91,13 +93,17 @@ behavior spawn_core(event_based_actor* self,
       {"archive-size", "", archive_size},
       {"index-events", "", index_events},
       {"index-active", "", index_active},
-      {"index-passive", "", index_passive}
+      {"index-passive", "", index_passive},
+      {"chunk-cache", "", chunk_cache_size}
     });
     if (!r.error.empty()) {
       VAST_ERROR_AT(node, "failed to parse spawn core args:", r.error);
       rp.deliver(make_message(error{std::move(r.error)}));
       return;
     }
+    // Size the cache of decoded chunks which EXPORTERs share.
+    if (r.opts.count("chunk-cache") > 0)
+      node->state.chunks->capacity(chunk_cache_size << 20);
     // Spawn IDENTIFIER.
     auto msg = make_message("spawn", "identifier");
     if (r.opts.count("identifier-batch-size") > 0)
@@ -277,11 +283,22 @@ behavior spawn_actor(event_based_actor* self,
       },
       on("exporter", any_vals) >> [=] {
         auto events = uint64_t{0};
+        auto prefetch = uint64_t{4};
+        auto checkers = uint64_t{0};
+        std::string fields;
+        std::string aggregate;
         auto r = self->current_message().drop(1).extract_opts({
           {"events,e", "the number of events to extract", events},
+          {"prefetch,p", "the number of chunks to prefetch", prefetch},
+          {"checkers,k", "the number of parallel checkers per chunk",
+           checkers},
+          {"fields,f", "the fields to project results onto", fields},
+          {"aggregate,A", "the aggregation to apply to results", aggregate},
           {"continuous,c", "marks a query as continuous"},
           {"historical,h", "marks a query as historical"},
           {"unified,u", "marks a query as unified"},
+          {"newest-first,n", "extracts the youngest results first"},
+          {"explain,x", "reports the query plan and execution statistics"},
           {"auto-connect,a", "connect to available archives & indexes"}
         });
         if (!r.error.empty())
@@ -311,6 +328,41 @@ behavior spawn_actor(event_based_actor* self,
           self->quit(exit::error);
           return;
         }
+        if (r.opts.count("newest-first") > 0) {
+          if (query_opts != historical) {
+            rp.deliver(make_message(
+              error{"newest-first requires a historical query (-h)"}));
+            self->quit(exit::error);
+            return;
+          }
+          query_opts = query_opts + newest_first;
+        }
+        if (r.opts.count("explain") > 0)
+          query_opts = query_opts + explain;
+        if (prefetch == 0) {
+          rp.deliver(make_message(error{"prefetch window must not be empty"}));
+          self->quit(exit::error);
+          return;
+        }
+        // By default, we check the hits of a chunk on all cores.
+        if (checkers == 0)
+          checkers = std::max(1u, std::thread::hardware_concurrency());
+        auto proj = projection{util::split_to_str(fields, " ")};
+        std::shared_ptr<aggregation> agg;
+        if (!aggregate.empty()) {
+          if (!proj.empty()) {
+            rp.deliver(make_message(error{"cannot aggregate projection"}));
+            self->quit(exit::error);
+            return;
+          }
+          auto a = aggregation::parse(aggregate);
+          if (!a) {
+            rp.deliver(make_message(std::move(a.error())));
+            self->quit(exit::error);
+            return;
+          }
+          agg = std::make_shared<aggregation>(std::move(*a));
+        }
         VAST_DEBUG_AT(node, "parses expression");
         auto expr = to<expression>(str);
         if (!expr) {
@@ -321,7 +373,9 @@ behavior spawn_actor(event_based_actor* self,
         }
         *expr = expr::normalize(*expr);
         VAST_VERBOSE_AT(node, "normalized query to", *expr);
-        auto exp = self->spawn(exporter::make, *expr, query_opts);
+        auto exp = self->spawn(exporter::make, *expr, query_opts,
+                               prefetch, checkers, node->state.chunks,
+                               std::move(proj), std::move(agg));
         self->send(exp, node->state.accountant);
         self->send(exp, extract_atom::value, events);
         if (r.opts.count("auto-connect") > 0) {
@@ -878,6 +932,7 @@ behavior node::make(stateful_actor<state>* self, std::string const& name,
                     path const& dir) {
   self->state.dir = dir;
   self->state.desc = name;
+  self->state.chunks = std::make_shared<chunk_cache>(uint64_t{256} << 20);
   self->trap_exit(true);
   // Shut down the node safely.
   auto terminate = [=](uint32_t reason) {
@@ -1,6 +1,10 @@
+#include <algorithm>
+#include <limits>
+
 #include <caf/all.hpp>
 
 #include "vast/event.hpp"
+#include "vast/json.hpp"
 #include "vast/actor/atoms.hpp"
 #include "vast/actor/indexer.hpp"
 #include "vast/actor/partition.hpp"
@@ -8,6 +12,7 @@
 #include "vast/expr/predicatizer.hpp"
 #include "vast/concept/parseable/numeric/integral.hpp"
 #include "vast/concept/parseable/to.hpp"
+#include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/error.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/concept/printable/vast/event.hpp"
@@ -21,9 +26,10 @@ namespace vast {
 namespace {
 
 template <typename Bitstream>
-using hits_map = std::map<predicate, Bitstream>;
+using hits_map = std::unordered_map<interned_predicate, Bitstream>;
 
-// Receives hits from INDEXERs and evaluates a set of expression over them.
+// Receives a known number of hits from INDEXERs and evaluates a set of
+// expression over them.
 template <typename Bitstream>
 struct accumulator {
   struct state : basic_state {
@@ -33,7 +39,7 @@ struct accumulator {
       struct evaluator : expr::bitstream_evaluator<evaluator, Bitstream> {
         evaluator(state const* s) : this_{s} { }
         Bitstream const* lookup(predicate const& pred) const {
-          auto i = this_->hits.find(pred);
+          auto i = this_->hits.find(interned_predicate::find(pred));
           return i == this_->hits.end() ? nullptr : &i->second;
         }
         state const* this_;
@@ -42,20 +48,25 @@ struct accumulator {
     }
 
     hits_map<Bitstream> hits;
+    uint64_t replies = 0;
   };
 
   static behavior make(stateful_actor<state>* self,
-                       std::vector<expression> exprs, actor const& sink) {
+                       std::vector<interned_expression> exprs,
+                       actor const& sink, uint64_t replies) {
+    VAST_ASSERT(replies > 0);
+    self->state.replies = replies;
     return {
-      [=](expression& pred, Bitstream& hits) {
-        auto p = get<predicate>(pred);
-        VAST_ASSERT(p);
-        self->state.hits.emplace(std::move(*p), std::move(hits));
-      },
-      [self, exprs=std::move(exprs), sink](done_atom) {
+      [self, exprs=std::move(exprs), sink](interned_predicate const& pred,
+                                           Bitstream& hits) {
+        // Multiple INDEXERs may answer the same predicate.
+        self->state.hits[pred] |= hits;
+        VAST_ASSERT(self->state.replies > 0);
+        if (--self->state.replies > 0)
+          return;
         for (auto& expr : exprs) {
           VAST_DEBUG_AT(self, "evalutes continuous query:", expr);
-          self->send(sink, expr, self->state.evaluate(expr));
+          self->send(sink, expr, self->state.evaluate(*expr));
         }
         self->quit(exit::done);
         // TODO: relay the hits back to PARTITION if the query is also
@@ -73,55 +84,196 @@ struct cq_proxy {
   struct state : basic_state {
     state(local_actor* self) : basic_state{self, "cq-proxy"} { }
 
-    util::flat_set<expression> exprs;
-    util::flat_set<predicate> preds;
+    util::flat_set<interned_expression> exprs;
+    util::flat_set<interned_predicate> preds;
   };
 
   // Accumulates hits from indexers for a single event batch.
   static behavior make(stateful_actor<state>* self, actor const& sink) {
     return {
-      [=](expression const& expr) {
+      [=](interned_expression const& expr) {
         self->state.exprs.insert(expr);
-        for (auto& p : visit(expr::predicatizer{}, expr))
-          self->state.preds.insert(std::move(p));
+        for (auto& p : visit(expr::predicatizer{}, *expr))
+          self->state.preds.insert(interned_predicate{std::move(p)});
       },
-      [=](expression const& expr, disable_atom) {
+      [=](interned_expression const& expr, disable_atom) {
         self->state.exprs.erase(expr);
         self->state.preds.clear();
         if (self->state.exprs.empty())
           self->quit(exit::done);
         else
           for (auto& ex : self->state.exprs)
-            for (auto& p : visit(expr::predicatizer{}, ex))
-              self->state.preds.insert(std::move(p));
+            for (auto& p : visit(expr::predicatizer{}, *ex))
+              self->state.preds.insert(interned_predicate{std::move(p)});
       },
-      [=](expression const&, Bitstream const& hits) {
+      [=](interned_expression const&, Bitstream const& hits) {
         VAST_DEBUG_AT(self, "relays", hits.count(), "hits");
         self->send(sink, self->current_message()
                            + make_message(continuous_atom::value));
       },
-      [=](std::vector<actor> const& indexers) {
+      [=](std::vector<actor> const& indexers, schema const& sch) {
         VAST_DEBUG_AT(self, "got", indexers.size(), "indexers");
+        VAST_ASSERT(indexers.size() == sch.size());
         if (self->state.exprs.empty()) {
           VAST_WARN_AT(self, "got indexers without having queries");
           return;
         }
-        // FIXME: do not stupidly send every predicate to every indexer,
-        // rather, pick the minimal subset intelligently.
-        auto acc = self->spawn(accumulator<Bitstream>::make,
-                               self->state.exprs.as_vector(), self);
-        auto t = self->spawn(task::make<>);
-        self->send(t, supervisor_atom::value, acc);
-        for (auto& indexer : indexers) {
-          self->send(t, indexer, uint64_t{self->state.preds.size()});
-          for (auto& p : self->state.preds)
-            self->send(indexer, expression{p}, acc, t);
+        // Route each predicate only to the INDEXERs of the event types that
+        // can answer it, which also tells us the exact number of replies.
+        std::vector<std::vector<interned_predicate>> routes(indexers.size());
+        uint64_t replies = 0;
+        auto i = 0u;
+        for (auto& t : sch) {
+          for (auto& p : self->state.preds) {
+            auto n = detail::indexer_router{t}(*p).size();
+            if (n > 0) {
+              routes[i].push_back(p);
+              replies += n;
+            }
+          }
+          ++i;
         }
+        VAST_DEBUG_AT(self, "expects", replies, "replies");
+        if (replies == 0)
+          return;
+        auto acc = self->spawn(accumulator<Bitstream>::make,
+                               self->state.exprs.as_vector(), self, replies);
+        // Continuous lookups need no task, because ACCUMULATOR counts the
+        // replies itself.
+        for (i = 0; i < indexers.size(); ++i)
+          for (auto& p : routes[i])
+            self->send(indexers[i], p, acc, actor{invalid_actor});
       }
     };
   }
 };
 
+// Evaluates an expression over the predicate hits of PARTITION.
+struct hits_evaluator
+  : expr::bitstream_evaluator<hits_evaluator, partition::bitstream_type> {
+  hits_evaluator(partition::state const& s) : state_{s} { }
+
+  partition::bitstream_type const* lookup(predicate const& pred) const {
+    auto p = state_.predicates.find(interned_predicate::find(pred));
+    return p == state_.predicates.end() ? nullptr : &p->second.hits;
+  }
+
+  partition::state const& state_;
+};
+
+constexpr auto unknown_hits = std::numeric_limits<uint64_t>::max();
+
+// Computes an upper bound for the number of hits of an expression based on
+// the expected hits of its predicates.
+struct hits_estimator {
+  hits_estimator(partition::state const& s) : state_{s} { }
+
+  uint64_t operator()(none) const {
+    return 0;
+  }
+
+  uint64_t operator()(conjunction const& con) const {
+    auto n = unknown_hits;
+    for (auto& op : con)
+      n = std::min(n, visit(*this, op));
+    return n;
+  }
+
+  uint64_t operator()(disjunction const& dis) const {
+    uint64_t n = 0;
+    for (auto& op : dis) {
+      auto x = visit(*this, op);
+      n = x > unknown_hits - n ? unknown_hits : n + x;
+    }
+    return n;
+  }
+
+  uint64_t operator()(negation const&) const {
+    return unknown_hits;
+  }
+
+  uint64_t operator()(predicate const& pred) const {
+    auto p = state_.predicates.find(interned_predicate::find(pred));
+    if (p == state_.predicates.end())
+      return unknown_hits;
+    // A predicate may have estimates for some batches and exact hits for
+    // others, in which case we settle for the larger of the two.
+    return std::max<uint64_t>(p->second.estimate, p->second.hits.count());
+  }
+
+  partition::state const& state_;
+};
+
+// Records the number of hits after each operator of an expression, from the
+// innermost operands to the entire expression.
+struct hits_explainer {
+  hits_explainer(partition::state const& s, json::array& ops)
+    : state_{s}, ops_{ops} {
+  }
+
+  void operator()(none) const {
+  }
+
+  void operator()(conjunction const& con) const {
+    for (auto& op : con)
+      visit(*this, op);
+    record(con);
+  }
+
+  void operator()(disjunction const& dis) const {
+    for (auto& op : dis)
+      visit(*this, op);
+    record(dis);
+  }
+
+  void operator()(negation const& n) const {
+    visit(*this, n.expression());
+    record(n);
+  }
+
+  void operator()(predicate const& pred) const {
+    record(pred);
+  }
+
+  template <typename T>
+  void record(T const& x) const {
+    auto hits = hits_evaluator{state_}(x);
+    ops_.push_back(json::object{
+      {"expression", to_string(x)},
+      {"hits", hits.count()}
+    });
+  }
+
+  partition::state const& state_;
+  json::array& ops_;
+};
+
+// Describes how PARTITION looked up a historical query.
+json explain_lookup(partition::state const& s,
+                    interned_expression const& expr, time::extent runtime) {
+  auto& qs = s.queries.at(expr);
+  json::array preds;
+  for (auto& x : visit(expr::predicatizer{}, *expr)) {
+    auto pred = interned_predicate::find(x);
+    auto p = s.predicates.find(pred);
+    auto c = qs.contacted.find(pred);
+    preds.push_back(json::object{
+      {"predicate", to_string(x)},
+      {"indexers", c == qs.contacted.end() ? 0 : c->second},
+      {"hits", p == s.predicates.end() ? 0 : p->second.hits.count()}
+    });
+  }
+  json::array ops;
+  visit(hits_explainer{s, ops}, *expr);
+  return json::object{
+    {"runtime", time::duration_cast<time::microseconds>(runtime).count()},
+    {"stages", qs.total_stages},
+    {"skipped", qs.skipped_stages},
+    {"predicates", std::move(preds)},
+    {"operators", std::move(ops)}
+  };
+}
+
 } // namespace <anonymous>
 
 partition::state::state(local_actor* self) : basic_state{self, "partition"} { }
@@ -217,6 +369,147 @@ behavior partition::make(stateful_actor<state>* self, path dir, actor sink) {
     VAST_ASSERT(self->state.pending_events >= events);
     self->state.pending_events -= events;
   };
+  // Relays the predicates of an expression to all INDEXERs which haven't
+  // looked them up yet, on behalf of a query.
+  auto dispatch = [=](interned_expression const& query,
+                      expression const& expr) {
+    auto& qs = self->state.queries[query];
+    bitstream_type cached_hits;
+    for (auto& x : visit(expr::predicatizer{}, expr)) {
+      auto pred = interned_predicate{std::move(x)};
+      VAST_DEBUG_AT(self, "dispatches predicate", pred);
+      auto p = self->state.predicates.emplace(pred, predicate_state()).first;
+      auto i = self->state.indexers.begin();
+      while (i != self->state.indexers.end()) {
+        auto base = i->first;
+        if (p->second.cache.contains(base)) {
+          // If an indexer has already looked up this predicate in the
+          // past, it must have sent the hits back to this partition, or is
+          // in the process of doing so.
+          VAST_DEBUG_AT(self, "skips indexers for base", base);
+          while (i != self->state.indexers.end() && i->first == base)
+            ++i;
+          // If hits for this predicate exist already, we must send them
+          // back to INDEX. Otherwise INDEX will produce false negatives.
+          if (!p->second.hits.empty() && !p->second.hits.all_zeros())
+            cached_hits |= p->second.hits;
+        } else {
+          // Forward the predicate to the subset of indexers which we
+          // haven't asked yet.
+          VAST_DEBUG_AT(self, "relays predicate for base", base);
+          while (i != self->state.indexers.end() && i->first == base) {
+            VAST_DEBUG_AT(self, " - forwards predicate to", i->second);
+            ++qs.contacted[pred];
+            p->second.cache.insert(i->first);
+            if (!p->second.task) {
+              p->second.task =
+                self->spawn(task::make<time::moment, interned_predicate>,
+                            time::snapshot(), pred);
+              self->send(p->second.task, supervisor_atom::value, self);
+            }
+            self->send(qs.task, p->second.task);
+            self->send(p->second.task, i->second);
+            self->send(i->second, pred, self, p->second.task);
+            ++i;
+          }
+        }
+      }
+    }
+    if (!cached_hits.empty() && !cached_hits.all_zeros())
+      self->send(sink, query, std::move(cached_hits), historical_atom::value);
+  };
+  // Asks the INDEXERs which haven't looked up the predicates of a query yet
+  // for the number of hits they expect.
+  auto estimate = [=](interned_expression const& query) {
+    auto t = self->spawn(task::make<estimate_atom, interned_expression>,
+                         estimate_atom::value, query);
+    self->send(t, supervisor_atom::value, self);
+    self->send(t, self);
+    for (auto& x : visit(expr::predicatizer{}, *query)) {
+      auto pred = interned_predicate{std::move(x)};
+      auto& ps = self->state.predicates[pred];
+      auto i = self->state.indexers.begin();
+      while (i != self->state.indexers.end()) {
+        auto base = i->first;
+        auto known = ps.cache.contains(base) || ps.estimated.contains(base);
+        ps.estimated.insert(base);
+        for (; i != self->state.indexers.end() && i->first == base; ++i)
+          if (!known) {
+            self->send(t, i->second);
+            self->send(i->second, estimate_atom::value, pred, self, t);
+          }
+      }
+    }
+    self->send(t, done_atom::value);
+  };
+  // Dispatches the stages of a query one after another. Before moving on to
+  // the next stage, we wait for the hits of all previous stages and skip the
+  // remaining ones if their conjunction has no hits.
+  auto advance = [=](interned_expression const& query) {
+    auto& qs = self->state.queries[query];
+    if (qs.stages.empty())
+      return;
+    while (qs.stage < qs.stages.size()) {
+      for (size_t i = 0; i < qs.stage; ++i)
+        for (auto& pred : visit(expr::predicatizer{}, qs.stages[i])) {
+          auto p = self->state.predicates.find(interned_predicate::find(pred));
+          if (p != self->state.predicates.end() && p->second.task)
+            return;
+        }
+      if (qs.stage > 0) {
+        conjunction con(qs.stages.begin(), qs.stages.begin() + qs.stage);
+        auto hits = hits_evaluator{self->state}(con);
+        if (hits.empty() || hits.all_zeros()) {
+          VAST_DEBUG_AT(self, "skips", qs.stages.size() - qs.stage,
+                        "stages of", query);
+          qs.skipped_stages = qs.stages.size() - qs.stage;
+          break;
+        }
+      }
+      dispatch(query, qs.stages[qs.stage++]);
+    }
+    qs.stages.clear();
+    qs.stage = 0;
+    self->send(qs.task, done_atom::value);
+  };
+  // Looks up the hits of a historical query.
+  auto lookup = [=](interned_expression const& expr, historical_atom) {
+    VAST_DEBUG_AT(self, "got historical query:", expr);
+    auto q = self->state.queries.emplace(expr, query_state()).first;
+    if (!q->second.task) {
+      // Even if we still have evaluated this query in the past, we still
+      // spin up a new task to ensure that we incorporate results from events
+      // that have arrived in the meantime.
+      VAST_DEBUG_AT(self, "spawns new query task");
+      q->second.task =
+        self->spawn(task::make<time::moment, interned_expression>,
+                    time::snapshot(), q->first);
+      self->send(q->second.task, supervisor_atom::value, self);
+      self->send(q->second.task, self);
+      for (auto& pred : visit(expr::predicatizer{}, *expr)) {
+        auto p = interned_predicate{std::move(pred)};
+        self->state.predicates[p].queries.insert(q->first);
+      }
+      q->second.contacted.clear();
+      q->second.skipped_stages = 0;
+      // A conjunction has no hits as soon as one of its operands has none.
+      // We thus evaluate the operands in stages, starting with the one we
+      // expect to yield the fewest hits, so that we can skip the lookups
+      // of the broad operands when the selective ones come up empty.
+      auto con = get<conjunction>(*expr);
+      if (con && con->size() > 1) {
+        q->second.stages.assign(con->begin(), con->end());
+        q->second.total_stages = q->second.stages.size();
+        estimate(q->first);
+      } else {
+        q->second.stages = {*expr};
+        q->second.total_stages = 1;
+        advance(q->first);
+      }
+    }
+    if (!q->second.hits.empty() && !q->second.hits.all_zeros())
+      self->send(sink, expr, q->second.hits, historical_atom::value);
+  };
   self->trap_exit(true);
   return {
     [=](exit_msg const& msg) {
@@ -299,128 +592,107 @@ behavior partition::make(stateful_actor<state>* self, path dir, actor sink) {
         indexers.push_back(indexer);
         self->state.indexers.emplace(base, std::move(indexer));
       }
-      // Relay INDEXERs to continuous query proxy.
+      // Relay INDEXERs to continuous query proxy, along with the type of
+      // each.
       if (self->state.proxy != invalid_actor)
-        self->send(self->state.proxy, std::move(indexers));
+        self->send(self->state.proxy, std::move(indexers), sch);
       // Update per-partition statistics.
       self->state.pending_events += events.size();
       VAST_DEBUG_AT(self, "indexes", self->state.pending_events,
                  "events in parallel");
     },
-    [=](expression const& expr, continuous_atom) {
+    [=](interned_expression const& expr, continuous_atom) {
       VAST_DEBUG_AT(self, "got continuous query:", expr);
       if (!self->state.proxy)
         self->state.proxy
           = self->spawn<monitored>(cq_proxy<default_bitstream>::make, sink);
       self->send(self->state.proxy, expr);
     },
-    [=](expression const& expr, continuous_atom, disable_atom) {
+    [=](interned_expression const& expr, continuous_atom, disable_atom) {
       VAST_DEBUG_AT(self, "got continuous query:", expr);
       if (!self->state.proxy)
         VAST_WARN_AT(self, "ignores disable request, no continuous queries");
       else
         self->send(self->state.proxy, expr, disable_atom::value);
     },
-    [=](expression const& expr, historical_atom) {
-      VAST_DEBUG_AT(self, "got historical query:", expr);
-      auto q = self->state.queries.emplace(expr, query_state()).first;
-      if (!q->second.task) {
-        // Even if we still have evaluated this query in the past, we still
-        // spin up a new task to ensure that we incorporate results from events
-        // that have arrived in the meantime.
-        VAST_DEBUG_AT(self, "spawns new query task");
-        q->second.task = self->spawn(task::make<time::moment, expression>,
-                                     time::snapshot(), q->first);
-        self->send(q->second.task, supervisor_atom::value, self);
-        self->send(q->second.task, self);
-        // Split up the query into predicates and handle each separately.
-        bitstream_type cached_hits;
-        for (auto& pred : visit(expr::predicatizer{}, expr)) {
-          VAST_DEBUG_AT(self, "dispatches predicate", pred);
-          auto p =
-            self->state.predicates.emplace(pred, predicate_state()).first;
-          VAST_ASSERT(p->first == pred);
-          p->second.queries.insert(&q->first);
-          auto i = self->state.indexers.begin();
-          while (i != self->state.indexers.end()) {
-            auto base = i->first;
-            if (p->second.cache.contains(base)) {
-              // If an indexer has already looked up this predicate in the
-              // past, it must have sent the hits back to this partition, or is
-              // in the process of doing so.
-              VAST_DEBUG_AT(self, "skips indexers for base", base);
-              while (i->first == base && i != self->state.indexers.end())
-                ++i;
-              // If hits for this predicate exist already, we must send them
-              // back to INDEX. Otherwise INDEX will produce false negatives.
-              if (!p->second.hits.empty() && !p->second.hits.all_zeros())
-                cached_hits |= p->second.hits;
-            } else {
-              // Forward the predicate to the subset of indexers which we
-              // haven't asked yet.
-              VAST_DEBUG_AT(self, "relays predicate for base", base);
-              while (i->first == base && i != self->state.indexers.end()) {
-                VAST_DEBUG_AT(self, " - forwards predicate to", i->second);
-                p->second.cache.insert(i->first);
-                if (!p->second.task) {
-                  p->second.task =
-                    self->spawn(task::make<time::moment, predicate>,
-                                time::snapshot(), pred);
-                  self->send(p->second.task, supervisor_atom::value, self);
-                }
-                self->send(q->second.task, p->second.task);
-                self->send(p->second.task, i->second);
-                self->send(i->second, expression{pred}, self, p->second.task);
-                ++i;
-              }
-            }
-          }
-        }
-        if (!cached_hits.empty() && !cached_hits.all_zeros())
-          self->send(sink, expr, std::move(cached_hits),
-                     historical_atom::value);
-        self->send(q->second.task, done_atom::value);
+    lookup,
+    [=](interned_expression const& expr, historical_atom, explain_atom) {
+      VAST_DEBUG_AT(self, "got request to explain query:", expr);
+      self->state.queries[expr].explain = true;
+      lookup(expr, historical_atom::value);
+    },
+    [=](interned_expression const& expr, historical_atom, disable_atom) {
+      // We cannot take back the predicates already dispatched, because other
+      // queries may share them. But we can skip the remaining stages.
+      auto q = self->state.queries.find(expr);
+      if (q == self->state.queries.end() || !q->second.task
+          || q->second.stages.empty())
+        return;
+      VAST_DEBUG_AT(self, "skips", q->second.stages.size() - q->second.stage,
+                    "stages of cancelled query:", expr);
+      q->second.skipped_stages = q->second.stages.size() - q->second.stage;
+      q->second.stages.clear();
+      q->second.stage = 0;
+      self->send(q->second.task, done_atom::value);
+    },
+    [=](estimate_atom, interned_predicate const& pred, uint64_t n) {
+      VAST_DEBUG_AT(self, "got estimate of", n, "hits for predicate:", pred);
+      self->state.predicates[pred].estimate += n;
+    },
+    [=](done_atom, estimate_atom, interned_expression const& expr) {
+      auto q = self->state.queries.find(expr);
+      if (q == self->state.queries.end() || !q->second.task)
+        return;
+      auto& stages = q->second.stages;
+      std::vector<std::pair<uint64_t, expression>> ordered;
+      for (auto& stage : stages)
+        ordered.emplace_back(visit(hits_estimator{self->state}, stage),
+                             std::move(stage));
+      std::stable_sort(ordered.begin(), ordered.end(),
+                       [](auto& x, auto& y) { return x.first < y.first; });
+      for (size_t i = 0; i < ordered.size(); ++i) {
+        VAST_DEBUG_AT(self, "expects", ordered[i].first, "hits for stage",
+                      i << ':', ordered[i].second);
+        stages[i] = std::move(ordered[i].second);
       }
-      if (!q->second.hits.empty() && !q->second.hits.all_zeros())
-        self->send(sink, expr, q->second.hits, historical_atom::value);
+      advance(q->first);
     },
-    [=](expression const& pred, bitstream_type const& hits) {
+    [=](interned_predicate const& pred, bitstream_type const& hits) {
       VAST_DEBUG_AT(self, "got", hits.count(), "hits for predicate:", pred);
-      self->state.predicates[*get<predicate>(pred)].hits |= hits;
+      self->state.predicates[pred].hits |= hits;
     },
-    [=](done_atom, time::moment start, predicate const& pred) {
-      struct evaluator : expr::bitstream_evaluator<evaluator,
-                                                   default_bitstream> {
-        evaluator(state const& s) : state_{s} { }
-        bitstream_type const* lookup(predicate const& pred) const {
-          auto p = state_.predicates.find(pred);
-          return p == state_.predicates.end() ? nullptr : &p->second.hits;
-        }
-        state const& state_;
-      };
+    [=](done_atom, time::moment start, interned_predicate const& pred) {
       // Once we've completed all tasks of a certain predicate for all events,
       // we evaluate all queries in which the predicate participates.
       auto& ps = self->state.predicates[pred];
       VAST_DEBUG_AT(self, "took", time::snapshot() - start,
                     "to complete predicate for", ps.cache.size(), "indexers:",
                     pred);
+      ps.task = invalid_actor;
       for (auto& q : ps.queries) {
-        VAST_ASSERT(q != nullptr);
-        VAST_DEBUG_AT(self, "evaluates", *q);
-        auto& qs = self->state.queries[*q];
-        auto hits = visit(evaluator{self->state}, *q);
+        VAST_DEBUG_AT(self, "evaluates", q);
+        auto& qs = self->state.queries[q];
+        auto hits = visit(hits_evaluator{self->state}, *q);
         if (!hits.empty() && !hits.all_zeros() && hits != qs.hits) {
           VAST_DEBUG_AT(self, "relays", hits.count(), "hits");
           qs.hits = hits;
-          self->send(sink, *q, std::move(hits), historical_atom::value);
+          self->send(sink, q, std::move(hits), historical_atom::value);
         }
+        if (qs.stage > 0)
+          advance(q);
       }
-      ps.task = invalid_actor;
     },
-    [=](done_atom, time::moment start, expression const& expr) {
-      VAST_DEBUG_AT(self, "completed query", expr, "in",
-                    time::snapshot() - start);
-      self->state.queries[expr].task = invalid_actor;
+    [=](done_atom, time::moment start, interned_expression const& expr) {
+      auto runtime = time::snapshot() - start;
+      VAST_DEBUG_AT(self, "completed query", expr, "in", runtime);
+      auto& qs = self->state.queries[expr];
+      qs.task = invalid_actor;
+      // The explanation must reach INDEX before the completion.
+      if (qs.explain) {
+        qs.explain = false;
+        self->send(sink, expr, explain_atom::value,
+                   explain_lookup(self->state, expr, runtime));
+      }
       self->send(sink, self->current_message());
     },
     [=](flush_atom, actor const& task) {
@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <limits>
+
+#include "vast/aggregation.hpp"
+#include "vast/event.hpp"
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/numeric/integral.hpp"
+#include "vast/concept/parseable/vast/offset.hpp"
+#include "vast/util/hash_combine.hpp"
+#include "vast/util/string.hpp"
+
+namespace vast {
+
+namespace {
+
+char const* function_names[] = {"count", "sum", "min", "max", "distinct"};
+
+// Adds two numeric values of the same type. Other values leave the sum as is.
+data accumulate(data const& x, data const& y) {
+  if (auto a = get<integer>(x))
+    if (auto b = get<integer>(y))
+      return *a + *b;
+  if (auto a = get<count>(x))
+    if (auto b = get<count>(y))
+      return *a + *b;
+  if (auto a = get<real>(x))
+    if (auto b = get<real>(y))
+      return *a + *b;
+  if (auto a = get<time::duration>(x))
+    if (auto b = get<time::duration>(y))
+      return *a + *b;
+  return x;
+}
+
+} // namespace <anonymous>
+
+trial<aggregation> aggregation::parse(std::string const& str) {
+  std::vector<std::string> tokens;
+  for (auto& t : util::split_to_str(str, " "))
+    if (!t.empty())
+      tokens.push_back(std::move(t));
+  if (tokens.empty())
+    return error{"empty aggregation"};
+  auto f = std::find(std::begin(function_names), std::end(function_names),
+                     tokens[0]);
+  if (f == std::end(function_names))
+    return error{"unknown aggregate function: ", tokens[0]};
+  auto fun = static_cast<function_type>(f - std::begin(function_names));
+  size_t i = 1;
+  std::string field;
+  if (i < tokens.size() && tokens[i] != "by" && tokens[i] != "top")
+    field = tokens[i++];
+  else if (fun != count)
+    return error{"missing field for ", tokens[0]};
+  std::vector<std::string> groups;
+  if (i < tokens.size() && tokens[i] == "by") {
+    while (++i < tokens.size() && tokens[i] != "top")
+      groups.push_back(tokens[i]);
+    if (groups.empty())
+      return error{"missing fields to group by"};
+  }
+  size_t top = 0;
+  if (i < tokens.size() && tokens[i] == "top") {
+    if (++i == tokens.size())
+      return error{"missing number of top groups"};
+    auto& k = tokens[i++];
+    auto f = k.begin();
+    auto l = k.end();
+    auto n = to<uint64_t>(f, l);
+    // Numbers with more digits may not fit into 64 bits.
+    auto fits = k.size() <= std::numeric_limits<uint64_t>::digits10;
+    if (!n || f != l || !fits || *n == 0)
+      return error{"invalid number of top groups: ", k};
+    top = *n;
+  }
+  if (i < tokens.size())
+    return error{"unexpected token in aggregation: ", tokens[i]};
+  return aggregation{fun, std::move(field), std::move(groups), top};
+}
+
+aggregation::aggregation(function_type fun, std::string field,
+                         std::vector<std::string> groups, size_t top)
+  : function_{fun},
+    names_(std::move(groups)),
+    valued_{!field.empty()},
+    value_{make_field(field)},
+    top_{top} {
+  for (auto& name : names_)
+    groups_.push_back(make_field(name));
+  group_types_.resize(groups_.size());
+}
+
+void aggregation::add(event const& e) {
+  auto& p = lookup(e.type());
+  if (!p.congruent)
+    return;
+  auto r = get<record>(e);
+  auto at = [&](column const& c) -> data const* {
+    if (!c.resolved)
+      return nullptr;
+    if (c.off.empty())
+      return &e.data();
+    return r ? r->at(c.off) : nullptr;
+  };
+  auto x = at(p.value);
+  if (valued_ && (!x || is<none>(*x)))
+    return;
+  vector group;
+  group.reserve(p.groups.size());
+  for (auto& c : p.groups) {
+    auto y = at(c);
+    group.push_back(y ? *y : data{nil});
+  }
+  auto& g = table_[std::move(group)];
+  auto first = g.events++ == 0;
+  switch (function_) {
+    case count:
+      break;
+    case sum:
+      g.value = first ? *x : accumulate(g.value, *x);
+      break;
+    case min:
+      if (first || *x < g.value)
+        g.value = *x;
+      break;
+    case max:
+      if (first || g.value < *x)
+        g.value = *x;
+      break;
+    case distinct:
+      g.values.insert(*x);
+      break;
+  }
+}
+
+std::vector<event> aggregation::results() const {
+  std::vector<type::record::field> fields;
+  for (size_t i = 0; i < names_.size(); ++i)
+    fields.emplace_back(names_[i], group_types_[i]);
+  auto counting = function_ == count || function_ == distinct;
+  fields.emplace_back(function_names[function_],
+                      counting ? type{type::count{}} : value_type_);
+  type t = type::record{std::move(fields)};
+  t.name("aggregate");
+  std::vector<std::pair<vector const*, data>> rows;
+  rows.reserve(table_.size());
+  for (auto& g : table_) {
+    auto& s = g.second;
+    if (function_ == count)
+      rows.emplace_back(&g.first, vast::count{s.events});
+    else if (function_ == distinct)
+      rows.emplace_back(&g.first, vast::count{s.values.size()});
+    else
+      rows.emplace_back(&g.first, s.value);
+  }
+  auto by_group = [](auto& x, auto& y) { return *x.first < *y.first; };
+  auto by_value = [](auto& x, auto& y) {
+    return y.second < x.second || (!(x.second < y.second)
+                                   && *x.first < *y.first);
+  };
+  if (top_ > 0 && top_ < rows.size()) {
+    std::partial_sort(rows.begin(), rows.begin() + top_, rows.end(),
+                      by_value);
+    rows.resize(top_);
+  } else if (top_ > 0) {
+    std::sort(rows.begin(), rows.end(), by_value);
+  } else {
+    std::sort(rows.begin(), rows.end(), by_group);
+  }
+  std::vector<event> result;
+  result.reserve(rows.size());
+  for (auto& row : rows) {
+    record xs(row.first->begin(), row.first->end());
+    xs.push_back(std::move(row.second));
+    result.emplace_back(value{std::move(xs), t});
+  }
+  return result;
+}
+
+size_t aggregation::groups() const {
+  return table_.size();
+}
+
+size_t aggregation::group_hash::operator()(vector const& xs) const {
+  size_t digest = xs.size();
+  for (auto& x : xs)
+    digest = util::hash_128_to_64(digest, std::hash<data>{}(x));
+  return digest;
+}
+
+aggregation::field aggregation::make_field(std::string const& str) {
+  if (auto o = to<offset>(str))
+    return std::move(*o);
+  auto names = util::split_to_str(str, ".");
+  return key(names.begin(), names.end());
+}
+
+aggregation::plan const& aggregation::lookup(type const& t) {
+  auto i = plans_.find(t);
+  if (i != plans_.end())
+    return i->second;
+  auto rec = get<type::record>(t);
+  auto resolve = [&](field const& f) {
+    column c;
+    if (rec) {
+      if (auto o = get<offset>(f)) {
+        c.off = *o;
+      } else {
+        auto trace = rec->find_suffix(*get<key>(f));
+        if (trace.empty())
+          return c;
+        c.off = trace.front().first;
+      }
+      if (auto ft = rec->at(c.off)) {
+        c.resolved = true;
+        c.type = *ft;
+      }
+    } else if (auto k = get<key>(f)) {
+      // Without a record, only the event name refers to the data.
+      if (k->size() == 1 && (*k)[0] == t.name()) {
+        c.resolved = true;
+        c.type = t;
+      }
+    }
+    return c;
+  };
+  auto agrees = [](column const& c, vast::type const& established) {
+    return !c.resolved || is<none>(established)
+           || congruent(c.type, established);
+  };
+  // The first resolved column fixes the type of its field in the result, but
+  // only if all columns of its type agree with the types fixed so far.
+  auto establish = [](column const& c, vast::type& established) {
+    if (c.resolved && is<none>(established))
+      established = c.type;
+  };
+  plan p;
+  if (valued_) {
+    p.value = resolve(value_);
+    p.congruent = agrees(p.value, value_type_);
+  }
+  for (size_t j = 0; j < groups_.size(); ++j) {
+    p.groups.push_back(resolve(groups_[j]));
+    p.congruent = agrees(p.groups.back(), group_types_[j]) && p.congruent;
+  }
+  if (p.congruent) {
+    if (valued_)
+      establish(p.value, value_type_);
+    for (size_t j = 0; j < groups_.size(); ++j)
+      establish(p.groups[j], group_types_[j]);
+  }
+  return plans_.emplace(t, std::move(p)).first->second;
+}
+
+} // namespace vast
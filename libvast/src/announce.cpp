@@ -20,6 +20,7 @@
 #include "vast/actor/accountant.hpp"
 #include "vast/actor/archive.hpp"
 #include "vast/actor/identifier.hpp"
+#include "vast/actor/indexer.hpp"
 #include "vast/concept/serializable/builtin.hpp"
 #include "vast/concept/serializable/state.hpp"
 #include "vast/concept/serializable/caf/message.hpp"
@@ -29,6 +30,7 @@
 #include "vast/concept/serializable/std/unordered_map.hpp"
 #include "vast/concept/serializable/std/vector.hpp"
 #include "vast/concept/serializable/std/map.hpp"
+#include "vast/concept/serializable/std/pair.hpp"
 #include "vast/concept/serializable/vast/bitstream_polymorphic.hpp"
 #include "vast/concept/serializable/vast/bitmap_index_polymorphic.hpp"
 #include "vast/concept/serializable/vast/data.hpp"
@@ -36,6 +38,8 @@
 #include "vast/concept/serializable/vast/schema.hpp"
 #include "vast/concept/serializable/vast/type.hpp"
 #include "vast/concept/serializable/vast/vector_event.hpp"
+#include "vast/concept/serializable/vast/util/interned.hpp"
+#include "vast/concept/serializable/vast/util/mapped_vector.hpp"
 #include "vast/concept/serializable/vast/util/radix_tree.hpp"
 #include "vast/concept/state/address.hpp"
 #include "vast/concept/state/bitmap_index.hpp"
@@ -121,8 +125,12 @@ void announce_bmi_hierarchy(std::string const& bs_name) {
     wrap("vast::port_bitmap_index", "T", bs_name));
   announce<string_bitmap_index<Bitstream>>(
     wrap("vast::string_bitmap_index", "T", bs_name));
+  announce<dictionary_bitmap_index<Bitstream>>(
+    wrap("vast::dictionary_bitmap_index", "T", bs_name));
   announce<sequence_bitmap_index<Bitstream>>(
     wrap("vast::sequence_bitmap_index", "T", bs_name));
+  announce<table_bitmap_index<Bitstream>>(
+    wrap("vast::table_bitmap_index", "T", bs_name));
   announce_hierarchy<
     bitmap_index_concept<Bitstream>,
     bitmap_index_model<arithmetic_bitmap_index<Bitstream, boolean>>,
@@ -135,7 +143,9 @@ void announce_bmi_hierarchy(std::string const& bs_name) {
     bitmap_index_model<subnet_bitmap_index<Bitstream>>,
     bitmap_index_model<port_bitmap_index<Bitstream>>,
     bitmap_index_model<string_bitmap_index<Bitstream>>,
-    bitmap_index_model<sequence_bitmap_index<Bitstream>>
+    bitmap_index_model<dictionary_bitmap_index<Bitstream>>,
+    bitmap_index_model<sequence_bitmap_index<Bitstream>>,
+    bitmap_index_model<table_bitmap_index<Bitstream>>
   >(model_wrap("arithmetic_bitmap_index<T,boolean>", bs_name),
     model_wrap("arithmetic_bitmap_index<T,integer>", bs_name),
     model_wrap("arithmetic_bitmap_index<T,count>", bs_name),
@@ -146,7 +156,9 @@ void announce_bmi_hierarchy(std::string const& bs_name) {
     model_wrap("subnet_bitmap_index<T>", bs_name),
     model_wrap("port_bitmap_index<T>", bs_name),
     model_wrap("string_bitmap_index<T>", bs_name),
-    model_wrap("sequence_bitmap_index<T>", bs_name)
+    model_wrap("dictionary_bitmap_index<T>", bs_name),
+    model_wrap("sequence_bitmap_index<T>", bs_name),
+    model_wrap("table_bitmap_index<T>", bs_name)
   );
 }
 
@@ -182,6 +194,8 @@ void announce_types() {
   announce<event>("vast::event");
   announce<expression>("vast::expression");
   announce<predicate>("vast::predicate");
+  announce<interned_expression>("vast::interned_expression");
+  announce<interned_predicate>("vast::interned_predicate");
   announce<io::compression>("vast::io::compression");
   announce<none>("vast::none");
   announce<error>("vast::error");
@@ -190,6 +204,7 @@ void announce_types() {
   announce<std::vector<event>>("std::vector<vast::event>");
   announce<std::vector<value>>("std::vector<vast::value>");
   announce<std::vector<uuid>>("std::vector<vast::uuid>");
+  announce<indexer_column>("vast::indexer_column");
   announce<util::radix_tree<message>>(
     "vast::util::radix_tree<caf::message>>");
   // Polymorphic bitstreams
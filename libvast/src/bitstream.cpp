@@ -284,6 +284,22 @@ ewah_bitstream::sequence_range::sequence_range(ewah_bitstream const& bs)
     next();
 }
 
+ewah_bitstream::sequence_range::sequence_range(ewah_bitstream const& bs,
+                                               sample const& s)
+  : bits_{&bs.bits_},
+    next_block_{s.block} {
+  if (s.block != s.marker) {
+    // If the sample points into the dirty blocks of a marker, we have to
+    // account for the remaining ones.
+    auto num_dirty = marker_num_dirty(bits_->block(s.marker));
+    auto consumed = s.block - s.marker - 1;
+    if (consumed < num_dirty)
+      num_dirty_ = num_dirty - consumed;
+  }
+  seq_.offset = s.offset;
+  next();
+}
+
 bool ewah_bitstream::sequence_range::next_sequence(bitseq& seq) {
   if (next_block_ >= bits_->blocks())
     return false;
@@ -333,6 +349,60 @@ ewah_bitstream::ewah_bitstream(size_type n, bool bit) {
   append(n, bit);
 }
 
+ewah_bitstream::ewah_bitstream(ewah_bitstream const& other)
+  : bitstream_base<ewah_bitstream>(other),
+    bits_{other.bits_},
+    num_bits_{other.num_bits_},
+    last_marker_{other.last_marker_} {
+  if (other.directory_)
+    directory_ = std::make_unique<directory>(*other.directory_);
+}
+
+ewah_bitstream& ewah_bitstream::operator=(ewah_bitstream const& other) {
+  bits_ = other.bits_;
+  num_bits_ = other.num_bits_;
+  last_marker_ = other.last_marker_;
+  if (other.directory_)
+    directory_ = std::make_unique<directory>(*other.directory_);
+  else
+    directory_.reset();
+  return *this;
+}
+
+void ewah_bitstream::attach_directory(size_type k) {
+  VAST_ASSERT(k > 0);
+  directory_ = std::make_unique<directory>(k);
+  catch_up();
+}
+
+void ewah_bitstream::detach_directory() {
+  directory_.reset();
+}
+
+ewah_bitstream::size_type ewah_bitstream::rank(size_type i) const {
+  if (i > num_bits_)
+    i = num_bits_;
+  if (i == 0)
+    return 0;
+  size_type n = 0;
+  auto range = sequence_range{*this};
+  if (directory_) {
+    auto& s = directory_->samples[locate(i - 1)];
+    n = s.rank;
+    range = sequence_range{*this, s};
+  }
+  for (auto& seq : range) {
+    if (seq.offset >= i)
+      break;
+    auto length = std::min(i - seq.offset, seq.length);
+    if (seq.is_literal())
+      n += bitvector::count(seq.data & (all_one >> (block_width - length)));
+    else if (seq.data)
+      n += length;
+  }
+  return n;
+}
+
 bool ewah_bitstream::equals(ewah_bitstream const& other) const {
   return bits_ == other.bits_;
 }
@@ -340,6 +410,8 @@ bool ewah_bitstream::equals(ewah_bitstream const& other) const {
 void ewah_bitstream::bitwise_not() {
   if (bits_.empty())
     return;
+  if (directory_)
+    directory_->reset();
   VAST_ASSERT(bits_.blocks() >= 2);
   size_type next_marker = 0;
   size_type i;
@@ -356,29 +428,30 @@ void ewah_bitstream::bitwise_not() {
   // We only flip the active bits in the last block.
   auto idx = bitvector::bit_index(bits_.size() - 1);
   bits_.block(i) ^= all_one >> (block_width - idx - 1);
+  catch_up();
 }
 
 void ewah_bitstream::bitwise_and(ewah_bitstream const& other) {
-  *this = and_(*this, other);
+  assign(and_(*this, other));
 }
 
 void ewah_bitstream::bitwise_or(ewah_bitstream const& other) {
-  *this = or_(*this, other);
+  assign(or_(*this, other));
 }
 
 void ewah_bitstream::bitwise_xor(ewah_bitstream const& other) {
-  *this = xor_(*this, other);
+  assign(xor_(*this, other));
 }
 
 void ewah_bitstream::bitwise_subtract(ewah_bitstream const& other) {
-  *this = nand_(*this, other);
+  assign(nand_(*this, other));
 }
 
 void ewah_bitstream::append_impl(ewah_bitstream const& other) {
   if (other.bits_.empty())
     return;
   if (bits_.empty()) {
-    *this = other;
+    assign(ewah_bitstream{other});
     return;
   }
   bits_.reserve(bits_.size() + other.bits_.size());
@@ -451,6 +524,7 @@ void ewah_bitstream::append_impl(size_type n, bool bit) {
     last_marker_ = bits_.blocks() - 1;
   }
   bits_.resize(bits_.size() + remaining_bits, bit);
+  catch_up();
 }
 
 void ewah_bitstream::append_block_impl(block_type block, size_type bits) {
@@ -490,6 +564,8 @@ void ewah_bitstream::push_back_impl(bool bit) {
 void ewah_bitstream::trim_impl() {
   if (empty())
     return;
+  if (directory_)
+    directory_->reset();
   auto marker = bits_.block(last_marker_);
   auto num_dirty = marker_num_dirty(marker);
   auto num_clean = marker_num_clean(marker);
@@ -498,6 +574,7 @@ void ewah_bitstream::trim_impl() {
     auto high_pos = bitvector::highest_bit(bits_.last_block());
     VAST_ASSERT(last_pos >= high_pos);
     num_bits_ -= last_pos - high_pos;
+    catch_up();
     return;
   } else if (last_marker_ == 0 && !marker) {
     clear();
@@ -576,11 +653,14 @@ void ewah_bitstream::trim_impl() {
       bits_.last_block() = all_one;
     }
   }
+  catch_up();
 }
 
 void ewah_bitstream::clear_impl() noexcept {
   bits_.clear();
   num_bits_ = last_marker_ = 0;
+  if (directory_)
+    directory_->reset();
 }
 
 bool ewah_bitstream::at(size_type i) const {
@@ -596,6 +676,8 @@ ewah_bitstream::size_type ewah_bitstream::size_impl() const {
 }
 
 ewah_bitstream::size_type ewah_bitstream::count_impl() const {
+  if (directory_)
+    return rank(num_bits_);
   size_type n = 0;
   for (auto& seq : sequence_range{*this})
     if (seq.is_literal())
@@ -682,6 +764,7 @@ void ewah_bitstream::integrate_last_block() {
     // The current block is dirty.
     bump_dirty_count();
   }
+  catch_up();
 }
 
 void ewah_bitstream::bump_dirty_count() {
@@ -702,8 +785,92 @@ void ewah_bitstream::bump_dirty_count() {
   }
 }
 
+void ewah_bitstream::assign(ewah_bitstream&& other) {
+  auto dir = std::move(directory_);
+  *this = std::move(other);
+  directory_ = std::move(dir);
+  if (directory_)
+    directory_->reset();
+  catch_up();
+}
+
+void ewah_bitstream::catch_up() {
+  if (!directory_ || bits_.empty())
+    return;
+  // The positions and ranks of all blocks before the last marker are final.
+  // Once the last marker has dirty blocks, its clean count and its dirty
+  // blocks are final as well. Only the last (incomplete) block may still
+  // change, either by turning into a marker or by getting absorbed into the
+  // last marker's clean count.
+  auto num_dirty = marker_num_dirty(bits_.block(last_marker_));
+  auto frontier = num_dirty > 0 ? last_marker_ + num_dirty + 1 : last_marker_;
+  auto& dir = *directory_;
+  auto& c = dir.cursor;
+  while (c.block < frontier) {
+    if (c.block != c.marker) {
+      auto consumed = c.block - c.marker - 1;
+      if (consumed < marker_num_dirty(bits_.block(c.marker))) {
+        auto block = bits_.block(c.block++);
+        c.offset += block_width;
+        c.rank += bitvector::count(block);
+        if (c.block - dir.samples.back().block >= dir.interval)
+          dir.samples.push_back(c);
+        continue;
+      }
+      c.marker = c.block;
+    }
+    auto marker = bits_.block(c.block++);
+    auto clean = marker_num_clean(marker) * block_width;
+    c.offset += clean;
+    if (marker_type(marker))
+      c.rank += clean;
+    if (c.block - dir.samples.back().block >= dir.interval)
+      dir.samples.push_back(c);
+  }
+}
+
+size_t ewah_bitstream::locate(size_type i) const {
+  VAST_ASSERT(directory_ && !bits_.empty());
+  auto& samples = directory_->samples;
+  auto pred = [](size_type x, sequence_range::sample const& s) {
+    return x < s.offset;
+  };
+  auto s = std::upper_bound(samples.begin(), samples.end(), i, pred);
+  VAST_ASSERT(s != samples.begin());
+  return static_cast<size_t>(s - samples.begin() - 1);
+}
+
 ewah_bitstream::size_type ewah_bitstream::find_forward(size_type i) const {
-  auto range = sequence_range{*this};
+  if (!directory_ || bits_.empty())
+    return find_forward(sequence_range{*this}, i);
+  auto& s = directory_->samples[locate(i)];
+  return find_forward(sequence_range{*this, s}, i);
+}
+
+ewah_bitstream::size_type ewah_bitstream::find_backward(size_type i) const {
+  if (!directory_ || bits_.empty())
+    return find_backward(sequence_range{*this}, i);
+  if (i >= num_bits_)
+    i = num_bits_ - 1;
+  auto& samples = directory_->samples;
+  auto s = locate(i);
+  auto result = find_backward(sequence_range{*this, samples[s]}, i);
+  if (result != npos || samples[s].rank == 0)
+    return result;
+  // The sample window before *i* has no 1-bits, so we look for the last
+  // window containing one, i.e., the last sample whose rank is smaller.
+  auto pred = [](sequence_range::sample const& x, size_type rank) {
+    return x.rank < rank;
+  };
+  auto end = samples.begin() + s;
+  auto next = std::lower_bound(samples.begin(), end, samples[s].rank, pred);
+  VAST_ASSERT(next != samples.begin());
+  auto prev = next - 1;
+  return find_backward(sequence_range{*this, *prev}, next->offset - 1);
+}
+
+ewah_bitstream::size_type
+ewah_bitstream::find_forward(sequence_range range, size_type i) const {
   auto seq = range.begin();
   auto end = range.end();
   while (seq != end) {
@@ -739,9 +906,9 @@ ewah_bitstream::size_type ewah_bitstream::find_forward(size_type i) const {
   return npos;
 }
 
-ewah_bitstream::size_type ewah_bitstream::find_backward(size_type i) const {
+ewah_bitstream::size_type
+ewah_bitstream::find_backward(sequence_range range, size_type i) const {
   size_type last = npos;
-  auto range = sequence_range{*this};
   for (auto& seq : range) {
     if (seq.offset + seq.length > i) {
       if (!seq.data)
@@ -345,6 +345,10 @@ bitvector::reference bitvector::operator[](size_type i) {
   return {bits_[block_index(i)], bit_index(i)};
 }
 
+bool bitvector::mapped() const {
+  return bits_.mapped();
+}
+
 size_type bitvector::count() const {
   auto i = bits_.begin();
   size_type n = 0;
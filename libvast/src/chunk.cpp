@@ -174,6 +174,10 @@ uint64_t chunk::bytes() const {
   return block().compressed_bytes();
 }
 
+uint64_t chunk::uncompressed_bytes() const {
+  return block().uncompressed_bytes();
+}
+
 uint64_t chunk::events() const {
   return block().elements();
 }
@@ -0,0 +1,149 @@
+#include <iterator>
+#include <vector>
+
+#include "vast/chunk.hpp"
+#include "vast/chunk_cache.hpp"
+#include "vast/event.hpp"
+#include "vast/concept/state/pattern.hpp"
+
+namespace vast {
+
+namespace {
+
+// Estimates the heap memory of data, including that of nested data.
+struct heap_estimator {
+  template <typename T>
+  uint64_t operator()(T const&) const {
+    return 0;
+  }
+
+  uint64_t operator()(std::string const& x) const {
+    return x.capacity();
+  }
+
+  uint64_t operator()(pattern const& x) const {
+    uint64_t n = 0;
+    access::state<pattern>::call(x, [&](auto& str) { n = str.capacity(); });
+    return n;
+  }
+
+  uint64_t operator()(vector const& x) const {
+    return sequence(x);
+  }
+
+  uint64_t operator()(set const& x) const {
+    return sequence(x);
+  }
+
+  uint64_t operator()(record const& x) const {
+    return sequence(x);
+  }
+
+  uint64_t operator()(table const& x) const {
+    // A map node has three pointers and a color next to its value.
+    uint64_t n = x.size() * (2 * sizeof(data) + 4 * sizeof(void*));
+    for (auto& pair : x)
+      n += visit(*this, pair.first) + visit(*this, pair.second);
+    return n;
+  }
+
+  template <typename Container>
+  uint64_t sequence(Container const& xs) const {
+    uint64_t n = xs.size() * sizeof(data);
+    for (auto& x : xs)
+      n += visit(*this, x);
+    return n;
+  }
+};
+
+} // namespace <anonymous>
+
+chunk_cache::chunk_cache(uint64_t capacity) : capacity_{capacity} {
+}
+
+uint64_t chunk_cache::footprint(std::vector<event> const& events) {
+  uint64_t n = events.size() * sizeof(event);
+  for (auto& e : events)
+    n += visit(heap_estimator{}, e.data());
+  return n;
+}
+
+trial<caf::message> chunk_cache::lookup(chunk const& chk) {
+  auto base = chk.base();
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    auto i = entries_.find(base);
+    if (i != entries_.end()) {
+      ++hits_;
+      lru_.splice(lru_.end(), lru_, i->second.position);
+      return i->second.events;
+    }
+    ++misses_;
+  }
+  // We decode outside the critical section to let other threads proceed.
+  std::vector<event> events;
+  events.reserve(chk.events());
+  chunk::reader reader{chk};
+  for (uint64_t i = 0; i < chk.events(); ++i) {
+    auto e = reader.read();
+    if (!e) {
+      if (e.empty())
+        return error{"chunk ", base, " ends after ", i, " events"};
+      return e.error();
+    }
+    events.push_back(std::move(*e));
+  }
+  // The serialized size of a chunk underestimates its decoded events by far,
+  // so we charge the cache with an estimate of the latter.
+  auto bytes = footprint(events);
+  auto msg = caf::make_message(std::move(events));
+  std::lock_guard<std::mutex> lock{mutex_};
+  // Another thread may have decoded the same chunk in the meantime.
+  auto i = entries_.find(base);
+  if (i != entries_.end())
+    return i->second.events;
+  if (bytes > capacity_)
+    return msg;
+  shrink(capacity_ - bytes);
+  lru_.push_back(base);
+  entries_.emplace(base, entry{msg, bytes, std::prev(lru_.end())});
+  size_ += bytes;
+  return msg;
+}
+
+uint64_t chunk_cache::capacity() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return capacity_;
+}
+
+void chunk_cache::capacity(uint64_t bytes) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  capacity_ = bytes;
+  shrink(capacity_);
+}
+
+uint64_t chunk_cache::size() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return size_;
+}
+
+uint64_t chunk_cache::hits() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return hits_;
+}
+
+uint64_t chunk_cache::misses() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return misses_;
+}
+
+void chunk_cache::shrink(uint64_t bytes) {
+  while (size_ > bytes) {
+    auto i = entries_.find(lru_.front());
+    size_ -= i->second.bytes;
+    entries_.erase(i);
+    lru_.pop_front();
+  }
+}
+
+} // namespace vast
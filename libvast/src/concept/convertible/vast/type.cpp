@@ -100,6 +100,9 @@ bool convert(type::attribute const& a, json& j) {
     case type::attribute::default_:
       j = json::array{"default", a.value};
       break;
+    case type::attribute::index:
+      j = json::array{"index", a.value};
+      break;
   }
   return true;
 }
@@ -1,6 +1,9 @@
 #include "vast/data.hpp"
 #include "vast/concept/printable/vast/data.hpp"
+#include "vast/concept/state/pattern.hpp"
 #include "vast/util/assert.hpp"
+#include "vast/util/hash_combine.hpp"
+#include "vast/util/hash/xxhash.hpp"
 
 namespace vast {
 
@@ -148,6 +151,11 @@ struct in_visitor {
     return std::find(rhs.begin(), rhs.end(), lhs) != rhs.end();
   }
 
+  template <typename T>
+  bool operator()(T const& lhs, table const& rhs) const {
+    return rhs.find(lhs) != rhs.end();
+  }
+
   template <typename T, typename U>
   bool operator()(T const&, U const&) const {
     return false;
@@ -204,4 +212,98 @@ bool operator<(data const& lhs, data const& rhs) {
   return lhs.data_ < rhs.data_;
 }
 
+namespace {
+
+struct data_hasher {
+  using hash = util::xxhash64;
+
+  size_t operator()(none) const {
+    return 0;
+  }
+
+  template <typename T>
+  auto operator()(T x) const
+  -> std::enable_if_t<std::is_integral<T>::value, size_t> {
+    return hash::digest(x);
+  }
+
+  size_t operator()(real x) const {
+    // Both zeros compare equal but differ in their bit pattern.
+    return x == 0 ? 0 : hash::digest(x);
+  }
+
+  size_t operator()(time::point x) const {
+    return hash::digest(x.time_since_epoch().count());
+  }
+
+  size_t operator()(time::duration x) const {
+    return hash::digest(x.count());
+  }
+
+  size_t operator()(std::string const& x) const {
+    return hash::digest_bytes(x.data(), x.size());
+  }
+
+  size_t operator()(address const& x) const {
+    return hash::digest_bytes(x.data().data(), x.data().size());
+  }
+
+  size_t operator()(subnet const& x) const {
+    return util::hash_128_to_64((*this)(x.network()), x.length());
+  }
+
+  size_t operator()(port const& x) const {
+    return hash::digest((uint32_t{x.type()} << 16) | x.number());
+  }
+
+  size_t operator()(pattern const& x) const {
+    size_t h = 0;
+    access::state<pattern>::call(x, [&](auto& str) { h = (*this)(str); });
+    return h;
+  }
+
+  size_t operator()(vector const& x) const {
+    return sequence(x);
+  }
+
+  size_t operator()(set const& x) const {
+    return sequence(x);
+  }
+
+  size_t operator()(record const& x) const {
+    return sequence(x);
+  }
+
+  size_t operator()(table const& x) const {
+    uint64_t h = x.size();
+    for (auto& pair : x) {
+      auto p = util::hash_128_to_64(std::hash<data>{}(pair.first),
+                                    std::hash<data>{}(pair.second));
+      h = util::hash_128_to_64(h, p);
+    }
+    return h;
+  }
+
+  // Combines the element hashes in order, which is the order in which
+  // equality compares them.
+  template <typename Container>
+  size_t sequence(Container const& xs) const {
+    uint64_t h = xs.size();
+    for (auto& x : xs)
+      h = util::hash_128_to_64(h, std::hash<data>{}(x));
+    return h;
+  }
+};
+
+} // namespace <anonymous>
+
 } // namespace vast
+
+namespace std {
+
+size_t hash<vast::data>::operator()(vast::data const& x) const {
+  auto tag = static_cast<uint64_t>(vast::which(x));
+  return vast::util::hash_128_to_64(tag, vast::visit(vast::data_hasher{}, x));
+}
+
+} // namespace std
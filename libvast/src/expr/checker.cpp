@@ -0,0 +1,254 @@
+#include <functional>
+
+#include "vast/event.hpp"
+#include "vast/expr/checker.hpp"
+
+namespace vast {
+namespace expr {
+
+namespace {
+
+using comparator = bool (*)(data const&, relational_operator, data const&);
+
+bool compare_data(data const& x, relational_operator op, data const& y) {
+  return data::evaluate(x, op, y);
+}
+
+// Compares two values of the same type directly. Operands of different types
+// take the generic path, which defines the order across types.
+template <typename T, typename Op>
+bool compare_values(data const& x, relational_operator op, data const& y) {
+  if (auto l = get<T>(x))
+    return Op{}(*l, *get<T>(y));
+  return data::evaluate(x, op, y);
+}
+
+bool compare_subnet(data const& x, relational_operator op, data const& y) {
+  if (auto a = get<address>(x))
+    return get<subnet>(y)->contains(*a) == (op == in);
+  return data::evaluate(x, op, y);
+}
+
+// Selects the comparison function for a constant operand.
+struct comparator_selector {
+  template <typename T>
+  static comparator scalar(relational_operator op) {
+    switch (op) {
+      default:
+        return compare_data;
+      case equal:
+        return compare_values<T, std::equal_to<T>>;
+      case not_equal:
+        return compare_values<T, std::not_equal_to<T>>;
+      case less:
+        return compare_values<T, std::less<T>>;
+      case less_equal:
+        return compare_values<T, std::less_equal<T>>;
+      case greater:
+        return compare_values<T, std::greater<T>>;
+      case greater_equal:
+        return compare_values<T, std::greater_equal<T>>;
+    }
+  }
+
+  template <typename T>
+  comparator operator()(T const&) const {
+    return compare_data;
+  }
+
+  comparator operator()(boolean) const {
+    return scalar<boolean>(op);
+  }
+
+  comparator operator()(integer) const {
+    return scalar<integer>(op);
+  }
+
+  comparator operator()(count) const {
+    return scalar<count>(op);
+  }
+
+  comparator operator()(real) const {
+    return scalar<real>(op);
+  }
+
+  comparator operator()(time::point) const {
+    return scalar<time::point>(op);
+  }
+
+  comparator operator()(time::duration) const {
+    return scalar<time::duration>(op);
+  }
+
+  comparator operator()(std::string const&) const {
+    return scalar<std::string>(op);
+  }
+
+  comparator operator()(address const&) const {
+    return scalar<address>(op);
+  }
+
+  comparator operator()(port const&) const {
+    return scalar<port>(op);
+  }
+
+  comparator operator()(subnet const&) const {
+    return op == in || op == not_in ? compare_subnet : compare_data;
+  }
+
+  relational_operator op;
+};
+
+} // namespace <anonymous>
+
+struct checker::compiler {
+  void operator()(none) {
+    constant(false);
+  }
+
+  void operator()(conjunction const& c) {
+    compound(c, node::all);
+  }
+
+  void operator()(disjunction const& d) {
+    compound(d, node::any);
+  }
+
+  void operator()(negation const& n) {
+    auto first = nodes_.size();
+    nodes_.push_back(make(node::negation));
+    visit(*this, n.expression());
+    if (nodes_[first + 1].kind == node::constant) {
+      auto value = !nodes_[first + 1].value;
+      nodes_.resize(first);
+      constant(value);
+    } else {
+      nodes_[first].size = nodes_.size() - first;
+    }
+  }
+
+  void operator()(predicate const& p) {
+    // Like the event evaluator, we treat an extractor on the RHS as if it
+    // occurred on the LHS.
+    auto lhs = &p.lhs;
+    auto rhs = &p.rhs;
+    if (is<data>(*lhs) && !is<data>(*rhs))
+      std::swap(lhs, rhs);
+    auto d = get<data>(*rhs);
+    if (!d || is<data>(*lhs)) {
+      constant(false);
+      return;
+    }
+    // The event extractor yields the same result for all events of a type.
+    if (is<event_extractor>(*lhs)) {
+      constant(data::evaluate(type_.name(), p.op, *d));
+      return;
+    }
+    auto n = make(node::field);
+    if (is<time_extractor>(*lhs)) {
+      n.kind = node::timestamp;
+    } else if (auto e = get<data_extractor>(*lhs)) {
+      if (e->type != type_) {
+        constant(false);
+        return;
+      }
+      n.offset = e->offset;
+    } else {
+      constant(false);
+      return;
+    }
+    n.op = p.op;
+    n.compare = visit(comparator_selector{p.op}, *d);
+    n.rhs = *d;
+    nodes_.push_back(std::move(n));
+  }
+
+  // Operands which fold into a constant either decide the compound right
+  // away or drop out of it.
+  template <typename Operands>
+  void compound(Operands const& xs, node::kind_type kind) {
+    auto decisive = kind == node::any;
+    auto first = nodes_.size();
+    nodes_.push_back(make(kind));
+    uint32_t arity = 0;
+    for (auto& x : xs) {
+      auto operand = nodes_.size();
+      visit(*this, x);
+      if (nodes_[operand].kind != node::constant) {
+        ++arity;
+      } else if (nodes_[operand].value == decisive) {
+        nodes_.resize(first);
+        constant(decisive);
+        return;
+      } else {
+        nodes_.resize(operand);
+      }
+    }
+    if (arity == 0) {
+      nodes_.resize(first);
+      constant(!decisive);
+    } else if (arity == 1) {
+      nodes_.erase(nodes_.begin() + first);
+    } else {
+      nodes_[first].arity = arity;
+      nodes_[first].size = nodes_.size() - first;
+    }
+  }
+
+  void constant(bool value) {
+    auto n = make(node::constant);
+    n.value = value;
+    nodes_.push_back(std::move(n));
+  }
+
+  static node make(node::kind_type kind) {
+    return {kind, false, equal, 0, 1, nullptr, {}, {}};
+  }
+
+  std::vector<node>& nodes_;
+  type const& type_;
+};
+
+checker::checker(expression const& expr, type const& t) {
+  compiler c{nodes_, t};
+  visit(c, expr);
+}
+
+bool checker::operator()(event const& e) const {
+  return !nodes_.empty() && run(0, e, get<record>(e));
+}
+
+size_t checker::size() const {
+  return nodes_.size();
+}
+
+bool checker::run(size_t i, event const& e, record const* r) const {
+  auto& n = nodes_[i];
+  switch (n.kind) {
+    case node::constant:
+      return n.value;
+    case node::all:
+    case node::any: {
+      auto decisive = n.kind == node::any;
+      auto j = i + 1;
+      for (auto k = 0u; k < n.arity; ++k) {
+        if (run(j, e, r) == decisive)
+          return decisive;
+        j += nodes_[j].size;
+      }
+      return !decisive;
+    }
+    case node::negation:
+      return !run(i + 1, e, r);
+    case node::timestamp:
+      return n.compare(e.timestamp(), n.op, n.rhs);
+    case node::field: {
+      auto x = n.offset.empty() ? &e.data() : r ? r->at(n.offset) : nullptr;
+      return x && n.compare(*x, n.op, n.rhs);
+    }
+  }
+  return false;
+}
+
+} // namespace expr
+} // namespace vast
@@ -0,0 +1,375 @@
+#include <algorithm>
+#include <array>
+#include <map>
+#include <tuple>
+
+#include "vast/event.hpp"
+#include "vast/expr/matcher.hpp"
+#include "vast/expr/resolver.hpp"
+#include "vast/util/assert.hpp"
+
+namespace vast {
+namespace expr {
+
+namespace {
+
+// A binary trie over the 128 bits of an address which associates subnets with
+// slots. IPv4 subnets live below the IPv4-mapped prefix, just like the
+// addresses they contain.
+class subnet_trie {
+public:
+  void insert(subnet const& sn, size_t slot) {
+    auto& net = sn.network();
+    auto length = net.is_v4() ? sn.length() + 96u : sn.length();
+    size_t n = 0;
+    for (auto i = 0u; i < length; ++i) {
+      auto bit = bit_at(net, i);
+      if (nodes_[n].children[bit] == 0) {
+        nodes_[n].children[bit] = nodes_.size();
+        nodes_.emplace_back();
+      }
+      n = nodes_[n].children[bit];
+    }
+    nodes_[n].slots.push_back(slot);
+  }
+
+  // Invokes a function for each slot whose subnet contains a given address.
+  template <typename F>
+  void lookup(address const& addr, F f) const {
+    size_t n = 0;
+    for (auto i = 0u; ; ++i) {
+      for (auto s : nodes_[n].slots)
+        f(s);
+      if (i == 128)
+        break;
+      n = nodes_[n].children[bit_at(addr, i)];
+      if (n == 0)
+        break;
+    }
+  }
+
+private:
+  struct node {
+    std::array<size_t, 2> children = {{0, 0}};
+    std::vector<size_t> slots;
+  };
+
+  static size_t bit_at(address const& addr, unsigned i) {
+    return (addr.data()[i / 8] >> (7 - i % 8)) & 1;
+  }
+
+  std::vector<node> nodes_ = std::vector<node>(1);
+};
+
+// The inequality operators in the order of their bound lists.
+constexpr std::array<relational_operator, 4> bound_ops = {
+  {less, less_equal, greater, greater_equal}
+};
+
+} // namespace <anonymous>
+
+// The compiled form of all expressions for a single event type. Each distinct
+// predicate occupies a *slot*, which an event satisfies if the slot carries
+// the current generation. Queries then reduce to a postfix program over slots.
+struct matcher::program {
+  using bound = std::pair<data, size_t>;
+
+  // All predicates over the same extractor.
+  struct field {
+    bool timestamp;
+    vast::offset offset;
+    size_t present;
+    std::unordered_map<data, std::vector<size_t>> equal;
+    std::array<std::vector<bound>, 4> bounds;
+    subnet_trie subnets;
+    std::vector<std::tuple<relational_operator, data, size_t>> residuals;
+  };
+
+  enum class opcode : uint8_t { test, constant, negate, all, any };
+
+  struct instruction {
+    opcode op;
+    size_t arg;
+  };
+
+  struct query {
+    size_t index;
+    std::vector<instruction> code;
+  };
+
+  struct compiler {
+    void operator()(none) {
+      emit(opcode::constant, 0);
+    }
+
+    void operator()(conjunction const& c) {
+      for (auto& op : c)
+        visit(*this, op);
+      emit(opcode::all, c.size());
+    }
+
+    void operator()(disjunction const& d) {
+      for (auto& op : d)
+        visit(*this, op);
+      emit(opcode::any, d.size());
+    }
+
+    void operator()(negation const& n) {
+      visit(*this, n.expression());
+      emit(opcode::negate, 0);
+    }
+
+    void operator()(predicate const& p) {
+      // Like the event evaluator, we treat an extractor on the RHS as if it
+      // occurred on the LHS.
+      auto lhs = &p.lhs;
+      auto rhs = &p.rhs;
+      if (is<data>(*lhs) && !is<data>(*rhs))
+        std::swap(lhs, rhs);
+      auto d = get<data>(*rhs);
+      if (!d || is<data>(*lhs)) {
+        emit(opcode::constant, 0);
+        return;
+      }
+      // The event extractor yields the same result for all events of a type.
+      if (is<event_extractor>(*lhs)) {
+        emit(opcode::constant, data::evaluate(type_.name(), p.op, *d));
+        return;
+      }
+      size_t f;
+      if (is<time_extractor>(*lhs)) {
+        f = prog_.field_for(true, {});
+      } else if (auto e = get<data_extractor>(*lhs)) {
+        if (e->type != type_) {
+          emit(opcode::constant, 0);
+          return;
+        }
+        f = prog_.field_for(false, e->offset);
+      } else {
+        emit(opcode::constant, 0);
+        return;
+      }
+      // A negated predicate holds only if the field has a value at all.
+      if (p.op == not_equal || p.op == not_in) {
+        emit(opcode::test, prog_.fields[f].present);
+        emit(opcode::test, slot(f, p.op == not_equal ? equal : in, *d));
+        emit(opcode::negate, 0);
+        emit(opcode::all, 2);
+      } else {
+        emit(opcode::test, slot(f, p.op, *d));
+      }
+    }
+
+    size_t slot(size_t f, relational_operator op, data const& d) {
+      auto key = std::make_tuple(f, op, d);
+      auto i = slots_.find(key);
+      if (i != slots_.end())
+        return i->second;
+      auto s = prog_.make_slot();
+      slots_.emplace(std::move(key), s);
+      auto& fld = prog_.fields[f];
+      auto b = std::find(bound_ops.begin(), bound_ops.end(), op);
+      if (op == equal) {
+        fld.equal[d].push_back(s);
+      } else if (b != bound_ops.end()) {
+        fld.bounds[b - bound_ops.begin()].emplace_back(d, s);
+      } else if (op == in && is<subnet>(d)) {
+        fld.subnets.insert(*get<subnet>(d), s);
+      } else if (op == in && is<vector>(d)) {
+        for (auto& x : *get<vector>(d))
+          fld.equal[x].push_back(s);
+      } else if (op == in && is<set>(d)) {
+        for (auto& x : *get<set>(d))
+          fld.equal[x].push_back(s);
+      } else if (op == in && is<table>(d)) {
+        for (auto& x : *get<table>(d))
+          fld.equal[x.first].push_back(s);
+      } else {
+        fld.residuals.emplace_back(op, d, s);
+      }
+      return s;
+    }
+
+    void emit(opcode op, size_t arg) {
+      code_.push_back({op, arg});
+    }
+
+    program& prog_;
+    type const& type_;
+    std::map<std::tuple<size_t, relational_operator, data>, size_t>& slots_;
+    std::vector<instruction> code_;
+  };
+
+  program(std::vector<expression> const& exprs, type const& t) {
+    std::map<std::tuple<size_t, relational_operator, data>, size_t> slots;
+    for (size_t i = 0; i < exprs.size(); ++i) {
+      auto resolved = visit(schema_resolver{t}, exprs[i]);
+      if (!resolved)
+        continue;
+      auto expr = visit(type_resolver{t}, *resolved);
+      if (is<none>(expr))
+        continue;
+      compiler c{*this, t, slots, {}};
+      visit(c, expr);
+      queries.push_back({i, std::move(c.code_)});
+    }
+    for (auto& f : fields)
+      for (auto& b : f.bounds)
+        std::sort(b.begin(), b.end(), [](auto& x, auto& y) {
+          return x.first < y.first;
+        });
+  }
+
+  size_t make_slot() {
+    marks.push_back(0);
+    return marks.size() - 1;
+  }
+
+  size_t field_for(bool timestamp, vast::offset const& o) {
+    for (size_t i = 0; i < fields.size(); ++i)
+      if (fields[i].timestamp == timestamp && fields[i].offset == o)
+        return i;
+    auto present = make_slot();
+    fields.push_back({timestamp, o, present, {}, {}, {}, {}});
+    return fields.size() - 1;
+  }
+
+  // Marks the slots of all predicates which hold for a field value.
+  void evaluate(field const& f, data const& x) {
+    auto mark = [&](size_t s) { marks[s] = generation; };
+    mark(f.present);
+    if (!f.equal.empty()) {
+      auto i = f.equal.find(x);
+      if (i != f.equal.end())
+        for (auto s : i->second)
+          mark(s);
+    }
+    auto lower = [&](auto& bs) {
+      return std::lower_bound(bs.begin(), bs.end(), x, [](auto& b, auto& d) {
+        return b.first < d;
+      });
+    };
+    auto upper = [&](auto& bs) {
+      return std::upper_bound(bs.begin(), bs.end(), x, [](auto& d, auto& b) {
+        return d < b.first;
+      });
+    };
+    auto mark_range = [&](auto first, auto last) {
+      for (; first != last; ++first)
+        mark(first->second);
+    };
+    auto& bs = f.bounds;
+    mark_range(upper(bs[0]), bs[0].end());   // x < b
+    mark_range(lower(bs[1]), bs[1].end());   // x <= b
+    mark_range(bs[2].begin(), lower(bs[2])); // x > b
+    mark_range(bs[3].begin(), upper(bs[3])); // x >= b
+    if (auto a = get<address>(x))
+      f.subnets.lookup(*a, mark);
+    for (auto& r : f.residuals)
+      if (data::evaluate(x, std::get<0>(r), std::get<1>(r)))
+        mark(std::get<2>(r));
+  }
+
+  bool run(query const& q) {
+    stack.clear();
+    for (auto& i : q.code) {
+      switch (i.op) {
+        case opcode::test:
+          stack.push_back(marks[i.arg] == generation);
+          break;
+        case opcode::constant:
+          stack.push_back(i.arg != 0);
+          break;
+        case opcode::negate:
+          stack.back() = !stack.back();
+          break;
+        case opcode::all:
+        case opcode::any: {
+          VAST_ASSERT(stack.size() >= i.arg);
+          auto first = stack.end() - i.arg;
+          auto result = i.op == opcode::all
+            ? std::all_of(first, stack.end(), [](char b) { return b; })
+            : std::any_of(first, stack.end(), [](char b) { return b; });
+          stack.erase(first, stack.end());
+          stack.push_back(result);
+          break;
+        }
+      }
+    }
+    VAST_ASSERT(stack.size() == 1);
+    return stack.back();
+  }
+
+  std::vector<field> fields;
+  std::vector<query> queries;
+  std::vector<uint64_t> marks;
+  uint64_t generation = 0;
+  std::vector<char> stack;
+};
+
+matcher::matcher() {
+}
+
+matcher::~matcher() {
+}
+
+bool matcher::add(expression const& expr) {
+  if (std::find(exprs_.begin(), exprs_.end(), expr) != exprs_.end())
+    return false;
+  exprs_.push_back(expr);
+  programs_.clear();
+  return true;
+}
+
+bool matcher::remove(expression const& expr) {
+  auto i = std::find(exprs_.begin(), exprs_.end(), expr);
+  if (i == exprs_.end())
+    return false;
+  exprs_.erase(i);
+  programs_.clear();
+  return true;
+}
+
+bool matcher::empty() const {
+  return exprs_.empty();
+}
+
+std::vector<expression> const& matcher::expressions() const {
+  return exprs_;
+}
+
+std::vector<size_t> const& matcher::match(event const& e) {
+  matches_.clear();
+  auto& p = compile(e.type());
+  if (p.queries.empty())
+    return matches_;
+  ++p.generation;
+  data timestamp;
+  for (auto& f : p.fields) {
+    data const* x = nullptr;
+    if (f.timestamp) {
+      timestamp = e.timestamp();
+      x = &timestamp;
+    } else if (f.offset.empty()) {
+      x = &e.data();
+    } else if (auto r = get<record>(e)) {
+      x = r->at(f.offset);
+    }
+    if (x)
+      p.evaluate(f, *x);
+  }
+  for (auto& q : p.queries)
+    if (p.run(q))
+      matches_.push_back(q.index);
+  return matches_;
+}
+
+matcher::program& matcher::compile(type const& t) {
+  auto i = programs_.find(t);
+  if (i == programs_.end())
+    i = programs_.emplace(t, std::make_unique<program>(exprs_, t)).first;
+  return *i->second;
+}
+
+} // namespace expr
+} // namespace vast
@@ -1,5 +1,6 @@
 #include "vast/expression.hpp"
 #include "vast/util/assert.hpp"
+#include "vast/util/hash_combine.hpp"
 
 namespace vast {
 
@@ -29,4 +30,81 @@ bool operator<(expression const& lhs, expression const& rhs) {
   return lhs.node_ < rhs.node_;
 }
 
+namespace {
+
+struct hasher {
+  size_t operator()(none) const {
+    return 0;
+  }
+
+  size_t operator()(event_extractor const&) const {
+    return 1;
+  }
+
+  size_t operator()(time_extractor const&) const {
+    return 2;
+  }
+
+  size_t operator()(type_extractor const& e) const {
+    return std::hash<type>{}(e.type);
+  }
+
+  size_t operator()(schema_extractor const& e) const {
+    size_t h = e.key.size();
+    for (auto& k : e.key)
+      h = util::hash_128_to_64(h, std::hash<std::string>{}(k));
+    return h;
+  }
+
+  size_t operator()(data_extractor const& e) const {
+    size_t h = std::hash<type>{}(e.type);
+    for (auto i : e.offset)
+      h = util::hash_128_to_64(h, i);
+    return h;
+  }
+
+  size_t operator()(data const& d) const {
+    return std::hash<data>{}(d);
+  }
+
+  size_t operator()(predicate const& p) const {
+    auto h = util::hash_128_to_64(visit(*this, p.lhs), p.op);
+    return util::hash_128_to_64(h, visit(*this, p.rhs));
+  }
+
+  template <typename T>
+  size_t combine(T const& xs, uint64_t tag) const {
+    uint64_t h = tag;
+    for (auto& x : xs)
+      h = util::hash_128_to_64(h, visit(*this, x));
+    return h;
+  }
+
+  size_t operator()(conjunction const& c) const {
+    return combine(c, 3);
+  }
+
+  size_t operator()(disjunction const& d) const {
+    return combine(d, 4);
+  }
+
+  size_t operator()(negation const& n) const {
+    return combine(n, 5);
+  }
+};
+
+} // namespace <anonymous>
+
 } // namespace vast
+
+namespace std {
+
+size_t hash<vast::predicate>::operator()(vast::predicate const& p) const {
+  return vast::hasher{}(p);
+}
+
+size_t hash<vast::expression>::operator()(vast::expression const& e) const {
+  return vast::visit(vast::hasher{}, e);
+}
+
+} // namespace std
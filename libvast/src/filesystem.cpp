@@ -416,6 +416,10 @@ bool rm(const path& p) {
   return false;
 }
 
+bool mv(path const& from, path const& to) {
+  return VAST_MOVE_FILE(from.str().data(), to.str().data());
+}
+
 trial<void> mkdir(path const& p) {
   auto components = split(p);
   if (components.empty())
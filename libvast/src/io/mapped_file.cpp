@@ -0,0 +1,57 @@
+#include "vast/io/mapped_file.hpp"
+
+#ifdef VAST_POSIX
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif // VAST_POSIX
+
+namespace vast {
+namespace io {
+
+mapped_file::mapped_file(path const& filename) {
+#ifdef VAST_POSIX
+  auto fd = ::open(filename.str().data(), O_RDONLY);
+  if (fd == -1)
+    return;
+  struct stat st;
+  if (::fstat(fd, &st) == 0) {
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+      // Mapping zero bytes fails, yet an empty file is perfectly readable.
+      is_open_ = true;
+    } else {
+      auto addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        data_ = addr;
+        is_open_ = true;
+      }
+    }
+  }
+  // The mapping remains valid after closing the descriptor.
+  ::close(fd);
+#endif // VAST_POSIX
+}
+
+mapped_file::~mapped_file() {
+#ifdef VAST_POSIX
+  if (data_ != nullptr)
+    ::munmap(data_, size_);
+#endif // VAST_POSIX
+}
+
+bool mapped_file::is_open() const {
+  return is_open_;
+}
+
+void const* mapped_file::data() const {
+  return data_;
+}
+
+size_t mapped_file::size() const {
+  return is_open_ ? size_ : 0;
+}
+
+} // namespace io
+} // namespace vast
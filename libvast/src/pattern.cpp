@@ -1,18 +1,60 @@
-#include <regex>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <mutex>
+#include <unordered_map>
 
 #include "vast/pattern.hpp"
+#include "vast/util/regex.hpp"
 
 namespace vast {
 
+namespace {
+
+std::string extract_literal_prefix(std::string const& str);
+
+} // namespace <anonymous>
+
+struct pattern::compiled {
+  explicit compiled(std::string const& s)
+    : str{s},
+      prefix{extract_literal_prefix(s)},
+      rx{s} {
+  }
+
+  std::string str;
+  std::string prefix;
+  util::regex rx;
+};
+
 pattern pattern::glob(std::string const& str) {
-  auto rx = std::regex_replace(str, std::regex("\\."), "\\.");
-  rx = std::regex_replace(rx, std::regex("\\*"), ".*");
-  return pattern{std::regex_replace(rx, std::regex("\\?"), ".")};
+  std::string rx;
+  for (auto c : str)
+    if (c == '.')
+      rx += "\\.";
+    else if (c == '*')
+      rx += ".*";
+    else if (c == '?')
+      rx += '.';
+    else
+      rx += c;
+  return pattern{std::move(rx)};
 }
 
 pattern::pattern(std::string str) : str_(std::move(str)) {
 }
 
+pattern::pattern(pattern const& other)
+  : str_{other.str_},
+    compiled_{std::atomic_load(&other.compiled_)} {
+}
+
+pattern& pattern::operator=(pattern const& other) {
+  str_ = other.str_;
+  std::atomic_store(&compiled_, std::atomic_load(&other.compiled_));
+  return *this;
+}
+
 bool operator==(pattern const& lhs, pattern const& rhs) {
   return lhs.str_ == rhs.str_;
 }
@@ -22,11 +64,107 @@ bool operator<(pattern const& lhs, pattern const& rhs) {
 }
 
 bool pattern::match(std::string const& str) const {
-  return std::regex_match(str.begin(), str.end(), std::regex{str_});
+  auto c = automaton();
+  if (str.compare(0, c->prefix.size(), c->prefix) != 0)
+    return false;
+  return c->rx.match(str.data(), str.data() + str.size());
 }
 
 bool pattern::search(std::string const& str) const {
-  return std::regex_search(str.begin(), str.end(), std::regex{str_});
+  auto c = automaton();
+  // A match cannot begin before the first occurrence of the literal prefix.
+  auto first = c->prefix.empty() ? 0 : str.find(c->prefix);
+  if (first == std::string::npos)
+    return false;
+  return c->rx.search(str.data() + first, str.data() + str.size(), first == 0);
+}
+
+std::string pattern::literal_prefix() const {
+  return extract_literal_prefix(str_);
+}
+
+std::shared_ptr<pattern::compiled const>
+pattern::compile(std::string const& str) {
+  // Leaked deliberately, because patterns may outlive static destruction.
+  static auto mutex = new std::mutex;
+  static auto cache =
+    new std::unordered_map<std::string, std::weak_ptr<compiled const>>;
+  static size_t prune_at = 64;
+  std::lock_guard<std::mutex> guard{*mutex};
+  auto i = cache->find(str);
+  if (i != cache->end())
+    if (auto c = i->second.lock())
+      return c;
+  auto c = std::make_shared<compiled const>(str);
+  (*cache)[str] = c;
+  if (cache->size() >= prune_at) {
+    for (auto j = cache->begin(); j != cache->end(); )
+      if (j->second.expired())
+        j = cache->erase(j);
+      else
+        ++j;
+    prune_at = 2 * std::max(cache->size(), size_t{32});
+  }
+  return c;
+}
+
+std::shared_ptr<pattern::compiled const> pattern::automaton() const {
+  auto c = std::atomic_load(&compiled_);
+  // Deserialization replaces the expression without resetting the cache.
+  if (!c || c->str != str_) {
+    c = compile(str_);
+    std::atomic_store(&compiled_, c);
+  }
+  return c;
+}
+
+namespace {
+
+std::string extract_literal_prefix(std::string const& str) {
+  // A top-level alternation admits strings with different prefixes.
+  auto depth = 0;
+  auto in_class = false;
+  for (auto i = 0u; i < str.size(); ++i) {
+    auto c = str[i];
+    if (c == '\\')
+      ++i;
+    else if (in_class)
+      in_class = c != ']';
+    else if (c == '[')
+      in_class = true;
+    else if (c == '(')
+      ++depth;
+    else if (c == ')')
+      --depth;
+    else if (c == '|' && depth == 0)
+      return {};
+  }
+  static auto const meta = std::string{".^$|?*+()[]{}"};
+  std::string result;
+  auto i = str.size() > 0 && str[0] == '^' ? 1u : 0u;
+  while (i < str.size()) {
+    auto c = str[i];
+    auto n = 1u;
+    if (c == '\\') {
+      // Only escaped punctuation stands for itself; sequences like \d or \w
+      // denote character classes.
+      if (i + 1 == str.size()
+          || std::isalnum(static_cast<unsigned char>(str[i + 1])))
+        break;
+      c = str[i + 1];
+      n = 2;
+    } else if (meta.find(c) != std::string::npos) {
+      break;
+    }
+    // A quantifier that admits zero repetitions makes the character optional.
+    auto next = i + n < str.size() ? str[i + n] : '\0';
+    if (next == '?' || next == '*' || next == '{')
+      break;
+    result += c;
+    i += n;
+  }
+  return result;
 }
 
+} // namespace <anonymous>
 } // namespace vast
@@ -0,0 +1,81 @@
+#include <algorithm>
+
+#include "vast/event.hpp"
+#include "vast/projection.hpp"
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/offset.hpp"
+#include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/key.hpp"
+#include "vast/util/string.hpp"
+
+namespace vast {
+
+projection::projection(std::vector<std::string> const& fields) {
+  for (auto& f : fields) {
+    if (f.empty())
+      continue;
+    if (auto o = to<offset>(f)) {
+      fields_.emplace_back(std::move(*o));
+    } else {
+      auto names = util::split_to_str(f, ".");
+      fields_.emplace_back(key(names.begin(), names.end()));
+    }
+  }
+}
+
+event projection::operator()(event const& e) {
+  auto p = lookup(e.type());
+  if (!p)
+    return e;
+  auto r = get<record>(e);
+  record xs;
+  xs.reserve(p->offsets.size());
+  for (auto& o : p->offsets) {
+    auto x = r ? r->at(o) : nullptr;
+    xs.push_back(x ? *x : data{nil});
+  }
+  event result{{std::move(xs), p->type}};
+  result.id(e.id());
+  result.timestamp(e.timestamp());
+  return result;
+}
+
+bool projection::empty() const {
+  return fields_.empty();
+}
+
+projection::plan const* projection::lookup(type const& t) {
+  auto r = get<type::record>(t);
+  if (fields_.empty() || !r)
+    return nullptr;
+  auto i = plans_.find(t);
+  if (i != plans_.end())
+    return &i->second;
+  // Fields which match several arguments select all of them, but each
+  // argument occurs only once in the derived type.
+  std::vector<offset> offsets;
+  auto add = [&](offset const& o) {
+    if (std::find(offsets.begin(), offsets.end(), o) == offsets.end())
+      offsets.push_back(o);
+  };
+  for (auto& f : fields_) {
+    if (auto o = get<offset>(f)) {
+      if (r->at(*o))
+        add(*o);
+    } else {
+      for (auto& p : r->find_suffix(*get<key>(f)))
+        add(p.first);
+    }
+  }
+  std::vector<type::record::field> args;
+  args.reserve(offsets.size());
+  for (auto& o : offsets)
+    args.emplace_back(to_string(*r->resolve(o)), *r->at(o));
+  plan p;
+  p.type = type::record{std::move(args)};
+  p.type.name(t.name());
+  p.offsets = std::move(offsets);
+  return &plans_.emplace(t, std::move(p)).first->second;
+}
+
+} // namespace vast
@@ -0,0 +1,616 @@
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cctype>
+#include <cstdint>
+#include <mutex>
+#include <regex>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/util/regex.hpp"
+
+namespace vast {
+namespace util {
+
+namespace {
+
+using charset = std::bitset<256>;
+
+// Thrown by the parser for expressions it leaves to the fallback engine,
+// either because they are not regular or because they are invalid, in which
+// case the fallback reports the error.
+struct unsupported {};
+
+// Bounds the size of the NFA, which grows with counted repetitions.
+constexpr size_t max_instructions = 1 << 16;
+
+// Bounds the number of cached DFA states per automaton.
+constexpr size_t max_states = 1 << 11;
+
+struct node {
+  enum kind_type { set, concatenation, alternation, repetition, begin, end };
+
+  node(kind_type k) : kind{k} {
+  }
+
+  kind_type kind;
+  charset chars;
+  std::vector<node> children;
+  int min = 0;
+  int max = -1; // unbounded
+};
+
+// A recursive-descent parser for the regular subset of ECMAScript syntax.
+class parser {
+public:
+  explicit parser(std::string const& str) : str_{str} {
+  }
+
+  node parse() {
+    auto n = alternation();
+    if (i_ != str_.size())
+      throw unsupported{};
+    return n;
+  }
+
+private:
+  node alternation() {
+    auto n = concatenation();
+    if (!peek('|'))
+      return n;
+    node alt{node::alternation};
+    alt.children.push_back(std::move(n));
+    while (accept('|'))
+      alt.children.push_back(concatenation());
+    return alt;
+  }
+
+  node concatenation() {
+    node cat{node::concatenation};
+    while (i_ < str_.size() && !peek('|') && !peek(')'))
+      cat.children.push_back(repetition());
+    return cat;
+  }
+
+  node repetition() {
+    auto n = atom();
+    node rep{node::repetition};
+    if (accept('*')) {
+      rep.min = 0;
+    } else if (accept('+')) {
+      rep.min = 1;
+    } else if (accept('?')) {
+      rep.max = 1;
+    } else if (accept('{')) {
+      rep.min = number();
+      rep.max = rep.min;
+      if (accept(','))
+        rep.max = peek('}') ? -1 : number();
+      if (!accept('}') || (rep.max >= 0 && rep.max < rep.min))
+        throw unsupported{};
+    } else {
+      return n;
+    }
+    if (n.kind == node::begin || n.kind == node::end)
+      throw unsupported{};
+    // Whether a quantifier is lazy or greedy does not affect whether a match
+    // exists.
+    accept('?');
+    if (peek('*') || peek('+') || peek('?') || peek('{'))
+      throw unsupported{};
+    rep.children.push_back(std::move(n));
+    return rep;
+  }
+
+  node atom() {
+    auto c = str_[i_++];
+    switch (c) {
+      case '(': {
+        if (accept('?') && !accept(':'))
+          throw unsupported{}; // lookahead
+        auto n = alternation();
+        if (!accept(')'))
+          throw unsupported{};
+        return n;
+      }
+      case '[':
+        return set(char_class());
+      case '.': {
+        charset cs;
+        cs.set();
+        cs.reset('\n');
+        cs.reset('\r');
+        return set(cs);
+      }
+      case '^':
+        return {node::begin};
+      case '$':
+        return {node::end};
+      case '\\':
+        return set(escape());
+      case ')':
+      case '*':
+      case '+':
+      case '?':
+      case '{':
+      case '}':
+      case ']':
+        throw unsupported{};
+      default:
+        return single(c);
+    }
+  }
+
+  charset char_class() {
+    auto negate = accept('^');
+    if (peek(']'))
+      throw unsupported{};
+    charset cs;
+    while (!accept(']')) {
+      if (i_ == str_.size())
+        throw unsupported{};
+      if (peek('[') && i_ + 1 < str_.size()
+          && (str_[i_ + 1] == ':' || str_[i_ + 1] == '='
+              || str_[i_ + 1] == '.'))
+        throw unsupported{}; // POSIX class
+      auto lo = class_atom(cs);
+      if (peek('-') && i_ + 1 < str_.size() && str_[i_ + 1] != ']') {
+        ++i_;
+        charset ignored;
+        auto hi = class_atom(ignored);
+        if (lo < 0 || hi < 0 || hi < lo)
+          throw unsupported{};
+        for (auto x = lo; x <= hi; ++x)
+          cs.set(x);
+      }
+    }
+    if (negate)
+      cs.flip();
+    return cs;
+  }
+
+  // Adds a class atom to a set and returns its character, or -1 if the atom
+  // denotes a class of characters.
+  int class_atom(charset& cs) {
+    charset a;
+    if (accept('\\'))
+      a = escape();
+    else
+      a.set(static_cast<unsigned char>(str_[i_++]));
+    cs |= a;
+    if (a.count() != 1)
+      return -1;
+    auto x = 0;
+    while (!a.test(x))
+      ++x;
+    return x;
+  }
+
+  charset escape() {
+    if (i_ == str_.size())
+      throw unsupported{};
+    auto c = str_[i_++];
+    charset cs;
+    switch (c) {
+      default:
+        // Alphanumeric escapes other than the ones below denote word
+        // boundaries, backreferences, and other non-regular constructs.
+        if (std::isalnum(static_cast<unsigned char>(c)))
+          throw unsupported{};
+        cs.set(static_cast<unsigned char>(c));
+        break;
+      case 'd':
+      case 'D':
+      case 'w':
+      case 'W':
+      case 's':
+      case 'S': {
+        auto lower = static_cast<char>(std::tolower(c));
+        for (auto x = 0; x < 128; ++x)
+          if ((lower == 'd' && std::isdigit(x))
+              || (lower == 'w' && (std::isalnum(x) || x == '_'))
+              || (lower == 's' && std::isspace(x)))
+            cs.set(x);
+        if (c != lower)
+          cs.flip();
+        break;
+      }
+      case 't':
+        cs.set('\t');
+        break;
+      case 'n':
+        cs.set('\n');
+        break;
+      case 'r':
+        cs.set('\r');
+        break;
+      case 'v':
+        cs.set('\v');
+        break;
+      case 'f':
+        cs.set('\f');
+        break;
+      case '0':
+        if (i_ < str_.size() && is_digit(str_[i_]))
+          throw unsupported{};
+        cs.set(0);
+        break;
+      case 'x': {
+        if (i_ + 2 > str_.size()
+            || !std::isxdigit(static_cast<unsigned char>(str_[i_]))
+            || !std::isxdigit(static_cast<unsigned char>(str_[i_ + 1])))
+          throw unsupported{};
+        cs.set(std::stoi(str_.substr(i_, 2), nullptr, 16));
+        i_ += 2;
+        break;
+      }
+    }
+    return cs;
+  }
+
+  int number() {
+    auto first = i_;
+    while (i_ < str_.size() && is_digit(str_[i_]))
+      ++i_;
+    if (i_ == first || i_ - first > 4)
+      throw unsupported{};
+    return std::stoi(str_.substr(first, i_ - first));
+  }
+
+  static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+  static node single(char c) {
+    charset cs;
+    cs.set(static_cast<unsigned char>(c));
+    return set(cs);
+  }
+
+  static node set(charset const& cs) {
+    node n{node::set};
+    n.chars = cs;
+    return n;
+  }
+
+  bool peek(char c) const {
+    return i_ < str_.size() && str_[i_] == c;
+  }
+
+  bool accept(char c) {
+    if (!peek(c))
+      return false;
+    ++i_;
+    return true;
+  }
+
+  std::string const& str_;
+  size_t i_ = 0;
+};
+
+} // namespace <anonymous>
+
+// A Thompson NFA. It is immutable after construction, so that threads can
+// share it.
+struct regex::automaton {
+  struct instruction {
+    enum opcode : uint8_t { byte, set, split, jump, begin, end, match };
+    opcode op;
+    uint8_t c;
+    uint32_t x;
+    uint32_t y;
+  };
+
+  explicit automaton(node const& root) {
+    emit(root);
+    push(instruction::match);
+  }
+
+  size_t push(instruction::opcode op) {
+    if (program.size() == max_instructions)
+      throw unsupported{};
+    program.push_back({op, 0, 0, 0});
+    return program.size() - 1;
+  }
+
+  void emit(node const& n) {
+    switch (n.kind) {
+      case node::set:
+        if (n.chars.count() == 1) {
+          auto i = push(instruction::byte);
+          while (!n.chars.test(program[i].c))
+            ++program[i].c;
+        } else {
+          auto i = push(instruction::set);
+          program[i].x = sets.size();
+          sets.push_back(n.chars);
+        }
+        break;
+      case node::concatenation:
+        for (auto& child : n.children)
+          emit(child);
+        break;
+      case node::alternation: {
+        std::vector<size_t> jumps;
+        for (size_t i = 0; i + 1 < n.children.size(); ++i) {
+          auto s = push(instruction::split);
+          program[s].x = s + 1;
+          emit(n.children[i]);
+          jumps.push_back(push(instruction::jump));
+          program[s].y = program.size();
+        }
+        emit(n.children.back());
+        for (auto j : jumps)
+          program[j].x = program.size();
+        break;
+      }
+      case node::repetition: {
+        for (auto i = 0; i < n.min; ++i)
+          emit(n.children[0]);
+        if (n.max < 0) {
+          auto s = push(instruction::split);
+          program[s].x = s + 1;
+          emit(n.children[0]);
+          program[push(instruction::jump)].x = s;
+          program[s].y = program.size();
+        } else {
+          for (auto i = n.min; i < n.max; ++i) {
+            auto s = push(instruction::split);
+            program[s].x = s + 1;
+            emit(n.children[0]);
+            program[s].y = program.size();
+          }
+        }
+        break;
+      }
+      case node::begin:
+        push(instruction::begin);
+        break;
+      case node::end:
+        push(instruction::end);
+        break;
+    }
+  }
+
+  std::vector<instruction> program;
+  std::vector<charset> sets;
+};
+
+// Two lazily constructed DFAs over an automaton, one anchored at both ends
+// for matching and one unanchored for searching, along with the scratch space
+// to construct them. A cache belongs to one thread at a time.
+struct regex::cache {
+  using instruction = automaton::instruction;
+
+  struct state {
+    std::vector<uint32_t> pcs;
+    bool begin;
+    bool accepting;
+    int8_t accepts_at_end = -1;
+    std::array<int32_t, 256> next;
+  };
+
+  struct dfa {
+    std::vector<std::unique_ptr<state>> states;
+    std::unordered_map<std::string, uint32_t> index;
+    uint64_t flushes = 0;
+  };
+
+  explicit cache(automaton const& a)
+    : program{a.program},
+      sets{a.sets},
+      marks(a.program.size(), 0) {
+  }
+
+  // Adds the instructions reachable from *pc* without consuming input to
+  // *out*: the ones consuming a character and the end assertions which
+  // hold only at the end of the input.
+  void closure(uint32_t pc, bool at_begin, bool at_end,
+               std::vector<uint32_t>& out, bool& matched) {
+    stack.push_back(pc);
+    while (!stack.empty()) {
+      pc = stack.back();
+      stack.pop_back();
+      if (marks[pc] == generation)
+        continue;
+      marks[pc] = generation;
+      auto& i = program[pc];
+      switch (i.op) {
+        case instruction::byte:
+        case instruction::set:
+          out.push_back(pc);
+          break;
+        case instruction::split:
+          stack.push_back(i.y);
+          stack.push_back(i.x);
+          break;
+        case instruction::jump:
+          stack.push_back(i.x);
+          break;
+        case instruction::begin:
+          if (at_begin)
+            stack.push_back(pc + 1);
+          break;
+        case instruction::end:
+          if (at_end)
+            stack.push_back(pc + 1);
+          else
+            out.push_back(pc);
+          break;
+        case instruction::match:
+          matched = true;
+          break;
+      }
+    }
+  }
+
+  uint32_t make_state(dfa& d, std::vector<uint32_t>& pcs, bool begin,
+                      bool accepting) {
+    std::sort(pcs.begin(), pcs.end());
+    std::string key(reinterpret_cast<char const*>(pcs.data()),
+                    pcs.size() * sizeof(uint32_t));
+    key += begin ? 'b' : '-';
+    key += accepting ? 'a' : '-';
+    auto i = d.index.find(key);
+    if (i != d.index.end())
+      return i->second;
+    if (d.states.size() == max_states) {
+      d.states.clear();
+      d.index.clear();
+      ++d.flushes;
+    }
+    auto s = std::make_unique<state>();
+    s->pcs = pcs;
+    s->begin = begin;
+    s->accepting = accepting;
+    s->next.fill(-1);
+    d.states.push_back(std::move(s));
+    d.index.emplace(std::move(key), d.states.size() - 1);
+    return d.states.size() - 1;
+  }
+
+  uint32_t start(dfa& d, bool at_begin) {
+    ++generation;
+    scratch.clear();
+    auto matched = false;
+    closure(0, at_begin, false, scratch, matched);
+    return make_state(d, scratch, at_begin, matched);
+  }
+
+  uint32_t transition(dfa& d, uint32_t s, unsigned char c, bool search) {
+    auto next = d.states[s]->next[c];
+    if (next >= 0)
+      return next;
+    ++generation;
+    scratch.clear();
+    auto matched = false;
+    for (auto pc : d.states[s]->pcs) {
+      auto& i = program[pc];
+      if ((i.op == instruction::byte && i.c == c)
+          || (i.op == instruction::set && sets[i.x].test(c)))
+        closure(pc + 1, false, false, scratch, matched);
+    }
+    // An unanchored search may begin a new match at every position.
+    if (search)
+      closure(0, false, false, scratch, matched);
+    auto flushes = d.flushes;
+    auto t = make_state(d, scratch, false, matched);
+    // A flush invalidates the source state.
+    if (d.flushes == flushes)
+      d.states[s]->next[c] = t;
+    return t;
+  }
+
+  // Checks whether a state accepts at the end of the input.
+  bool accepts_at_end(dfa& d, uint32_t s) {
+    auto& st = *d.states[s];
+    if (st.accepting)
+      return true;
+    if (st.accepts_at_end < 0) {
+      ++generation;
+      scratch.clear();
+      auto matched = false;
+      for (auto pc : st.pcs)
+        if (program[pc].op == instruction::end)
+          closure(pc + 1, st.begin, true, scratch, matched);
+      st.accepts_at_end = matched;
+    }
+    return st.accepts_at_end;
+  }
+
+  bool match(char const* first, char const* last) {
+    auto s = start(matcher, true);
+    for (; first != last; ++first) {
+      if (matcher.states[s]->pcs.empty())
+        return false;
+      s = transition(matcher, s, *first, false);
+    }
+    return accepts_at_end(matcher, s);
+  }
+
+  bool search(char const* first, char const* last, bool at_begin) {
+    auto s = start(searcher, at_begin);
+    for (; first != last; ++first) {
+      if (searcher.states[s]->accepting)
+        return true;
+      s = transition(searcher, s, *first, true);
+    }
+    return accepts_at_end(searcher, s);
+  }
+
+  std::vector<instruction> const& program;
+  std::vector<charset> const& sets;
+  dfa matcher;
+  dfa searcher;
+  std::vector<uint64_t> marks;
+  uint64_t generation = 0;
+  std::vector<uint32_t> stack;
+  std::vector<uint32_t> scratch;
+};
+
+struct regex::impl {
+  // Hands out a cache for the duration of one match. Matching itself runs
+  // without the lock, so that threads sharing a regex do not serialize; the
+  // pool holds at most as many caches as threads matched concurrently.
+  std::unique_ptr<cache> acquire() {
+    {
+      std::lock_guard<std::mutex> lock{mutex};
+      if (!pool.empty()) {
+        auto c = std::move(pool.back());
+        pool.pop_back();
+        return c;
+      }
+    }
+    return std::make_unique<cache>(*nfa);
+  }
+
+  void release(std::unique_ptr<cache> c) {
+    std::lock_guard<std::mutex> lock{mutex};
+    pool.push_back(std::move(c));
+  }
+
+  std::unique_ptr<automaton> nfa;
+  std::unique_ptr<std::regex> fallback;
+  std::mutex mutex;
+  std::vector<std::unique_ptr<cache>> pool;
+};
+
+regex::regex(std::string const& str) : impl_{std::make_unique<impl>()} {
+  try {
+    impl_->nfa = std::make_unique<automaton>(parser{str}.parse());
+  } catch (unsupported) {
+    impl_->fallback = std::make_unique<std::regex>(str);
+  }
+}
+
+regex::~regex() {
+}
+
+bool regex::match(char const* first, char const* last) const {
+  if (impl_->fallback)
+    return std::regex_match(first, last, *impl_->fallback);
+  auto c = impl_->acquire();
+  auto result = c->match(first, last);
+  impl_->release(std::move(c));
+  return result;
+}
+
+bool regex::search(char const* first, char const* last, bool at_begin) const {
+  if (impl_->fallback) {
+    auto flags = at_begin ? std::regex_constants::match_default
+                          : std::regex_constants::match_prev_avail;
+    return std::regex_search(first, last, *impl_->fallback, flags);
+  }
+  auto c = impl_->acquire();
+  auto result = c->search(first, last, at_begin);
+  impl_->release(std::move(c));
+  return result;
+}
+
+bool regex::linear() const {
+  return impl_->fallback == nullptr;
+}
+
+} // namespace util
+} // namespace vast
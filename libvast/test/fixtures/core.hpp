@@ -3,6 +3,8 @@
 
 #include <vector>
 
+#include "vast/event.hpp"
+#include "vast/uuid.hpp"
 #include "vast/actor/node.hpp"
 
 using namespace vast;
@@ -91,6 +93,59 @@ struct core {
     );
   }
 
+  // Spawns an EXPORTER under a given label, connects it to ARCHIVE and
+  // INDEX, and collects its results until it completes.
+  template <typename... Args>
+  std::vector<event> run_exporter(actor const& n, std::string const& label,
+                                  Args&&... args) {
+    actor exp;
+    self->sync_send(n, "spawn", "exporter", "-l", label,
+                    std::forward<Args>(args)...).await(
+      [&](actor const& a) {
+        exp = a;
+      },
+      [&](error const& e) {
+        FAIL(e);
+      }
+    );
+    std::vector<message> msgs = {
+      make_message("connect", label, "archive"),
+      make_message("connect", label, "index")
+    };
+    for (auto& msg : msgs)
+      self->sync_send(n, msg).await(
+        [](ok_atom) {},
+        [&](error const& e) {
+          FAIL(e);
+        }
+      );
+    self->monitor(exp);
+    self->send(exp, put_atom::value, sink_atom::value, self);
+    self->send(exp, run_atom::value);
+    // Like a SINK, we let EXPORTER terminate once it has delivered the
+    // requested number of events.
+    self->send(exp, stop_atom::value);
+    std::vector<event> results;
+    auto done = false;
+    self->do_receive(
+      [&](uuid const&, std::vector<event> const& v) {
+        results.insert(results.end(), v.begin(), v.end());
+      },
+      [&](uuid const&, progress_atom, double, uint64_t) { /* nop */ },
+      [&](uuid const&, done_atom, time::extent) {
+        done = true;
+      },
+      others >> [&] {
+        ERROR("got unexpected message from " << self->current_sender() <<
+              ": " << to_string(self->current_message()));
+      }
+    ).until([&] { return done; });
+    self->receive(
+      [&](down_msg const& msg) { CHECK(msg.source == exp); }
+    );
+    return results;
+  }
+
   std::string const node_name = "test-node";
   path dir = "vast-unit-test";
   scoped_actor self;
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <caf/all.hpp>
 
 #include "vast/bitstream.hpp"
@@ -20,6 +22,17 @@
 
 using namespace vast;
 
+namespace {
+
+std::vector<event_id> ids(std::vector<event> const& xs) {
+  std::vector<event_id> result;
+  for (auto& x : xs)
+    result.push_back(x.id());
+  return result;
+}
+
+} // namespace <anonymous>
+
 FIXTURE_SCOPE(core_scope, fixtures::core)
 
 TEST(export) {
@@ -63,7 +76,7 @@ TEST(export) {
       CHECK(fqn == "index@" + node_name);
       CHECK(type == "index");
       REQUIRE(a != invalid_actor);
-      self->send(a, *pops, historical, self);
+      self->send(a, interned_expression{*pops}, historical, self);
     }
   );
   MESSAGE("retrieving lookup task");
@@ -76,9 +89,10 @@ TEST(export) {
     [&](default_bitstream const& hits) {
       CHECK(hits.count() > 0);
     },
-    [&](done_atom, time::moment, time::extent, expression const& expr) {
+    [&](done_atom, time::moment, time::extent,
+        interned_expression const& expr) {
       done = true;
-      CHECK(expr == *pops);
+      CHECK(*expr == *pops);
     },
     [&](progress_atom, uint64_t remaining, uint64_t total) {
       // The task we receive from INDEX consists of 12 stages, because we
@@ -203,4 +217,99 @@ TEST(export) {
   stop_core(n);
 }
 
+TEST(export prefetching) {
+  MESSAGE("inhaling a Bro conn log");
+  auto n = make_core();
+  run_source(n, "bro", "-b", "100", "-r", m57_day11_18::conn);
+  stop_core(n);
+  self->await_all_other_actors_done();
+
+  // The 3,455 DNS connections span all 85 chunks.
+  n = make_core();
+  auto q = "id.resp_p == 53/?";
+  MESSAGE("extracting one chunk at a time");
+  auto xs = ids(run_exporter(n, "exporter-1", "-h", "-p", "1", q));
+  CHECK(xs.size() == 3455);
+  CHECK(std::is_sorted(xs.begin(), xs.end()));
+  MESSAGE("prefetching chunks");
+  auto ys = ids(run_exporter(n, "exporter-8", "-h", "-p", "8", q));
+  CHECK(xs == ys);
+  stop_core(n);
+}
+
+TEST(export limit) {
+  MESSAGE("inhaling a Bro conn log");
+  auto n = make_core();
+  run_source(n, "bro", "-b", "100", "-r", m57_day11_18::conn);
+  stop_core(n);
+  self->await_all_other_actors_done();
+
+  n = make_core();
+  auto q = "id.resp_p == 53/?";
+  MESSAGE("extracting all results");
+  auto xs = ids(run_exporter(n, "exporter-all", "-h", q));
+  REQUIRE(xs.size() == 3455);
+  MESSAGE("extracting the first 10 results");
+  // EXPORTER terminates after the tenth result, long before INDEX has
+  // looked at all partitions.
+  auto ys = ids(run_exporter(n, "exporter-10", "-h", "-e", "10", q));
+  REQUIRE(ys.size() == 10);
+  CHECK(std::equal(ys.begin(), ys.end(), xs.begin()));
+  MESSAGE("extracting all results again after cancellation");
+  auto zs = ids(run_exporter(n, "exporter-again", "-h", q));
+  CHECK(xs == zs);
+  stop_core(n);
+}
+
+TEST(export newest first) {
+  MESSAGE("inhaling a Bro conn log");
+  auto n = make_core();
+  run_source(n, "bro", "-b", "100", "-r", m57_day11_18::conn);
+  stop_core(n);
+  self->await_all_other_actors_done();
+
+  n = make_core();
+  auto q = "id.resp_p == 53/?";
+  MESSAGE("extracting all results");
+  auto xs = run_exporter(n, "exporter-all", "-h", q);
+  REQUIRE(xs.size() == 3455);
+  // The youngest results come first, with ties broken by descending ID.
+  std::sort(xs.begin(), xs.end(), [](auto& x, auto& y) {
+    return y.timestamp() < x.timestamp()
+           || (y.timestamp() == x.timestamp() && y.id() < x.id());
+  });
+  MESSAGE("extracting the 10 youngest results");
+  auto ys = ids(run_exporter(n, "exporter-10", "-h", "-n", "-e", "10", q));
+  REQUIRE(ys.size() == 10);
+  auto youngest = ids(xs);
+  CHECK(std::equal(ys.begin(), ys.end(), youngest.begin()));
+  stop_core(n);
+}
+
+TEST(export parallel checking) {
+  MESSAGE("inhaling a Bro conn log as a single chunk");
+  auto n = make_core();
+  run_source(n, "bro", "-b", "10000", "-r", m57_day11_18::conn);
+  stop_core(n);
+  self->await_all_other_actors_done();
+
+  // With 3,455 hits in the chunk, EXPORTER can check up to 3 ranges of at
+  // least 1,024 hits in parallel.
+  n = make_core();
+  auto q = "id.resp_p == 53/?";
+  MESSAGE("checking all hits sequentially");
+  auto xs = ids(run_exporter(n, "exporter-1", "-h", "-k", "1", q));
+  CHECK(xs.size() == 3455);
+  CHECK(std::is_sorted(xs.begin(), xs.end()));
+  MESSAGE("checking ranges of hits in parallel");
+  auto ys = ids(run_exporter(n, "exporter-4", "-h", "-k", "4", q));
+  CHECK(xs == ys);
+  MESSAGE("truncating parallel checks at the limit");
+  auto zs = ids(run_exporter(n, "exporter-limit", "-h", "-k", "4", "-e",
+                             "2000", q));
+  REQUIRE(zs.size() == 2000);
+  CHECK(std::equal(zs.begin(), zs.end(), xs.begin()));
+  stop_core(n);
+}
+
 FIXTURE_SCOPE_END()
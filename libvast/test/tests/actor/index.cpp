@@ -33,7 +33,7 @@ TEST(index) {
   auto expr = to<expression>("c >= 42 && c < 84");
   REQUIRE(expr);
   actor task;
-  self->send(idx, *expr, historical, self);
+  self->send(idx, interned_expression{*expr}, historical, self);
   self->receive(
     [&](actor const& t) {
       REQUIRE(t != invalid_actor);
@@ -48,8 +48,9 @@ TEST(index) {
     [&](bitstream_type const& h) {
       hits |= h;
     },
-    [&](done_atom, time::moment, time::extent, expression const& e) {
-      CHECK(*expr == e);
+    [&](done_atom, time::moment, time::extent,
+        interned_expression const& e) {
+      CHECK(*expr == *e);
       done = true;
     }
   ).until([&] { return done; });
@@ -61,7 +62,7 @@ TEST(index) {
   // The expression must have already been normalized as it hits the index.
   expr = to<expression>("s ni \"7\"");
   REQUIRE(expr);
-  self->send(idx, *expr, continuous, self);
+  self->send(idx, interned_expression{*expr}, continuous, self);
   self->receive(
     [&](actor const& t) {
       REQUIRE(t != invalid_actor);
@@ -74,7 +75,8 @@ TEST(index) {
   self->receive([&](bitstream_type const& bs) { CHECK(bs.count() == 95); });
 
   MESSAGE("disabling continuous query and sending another event");
-  self->send(idx, *expr, continuous_atom::value, disable_atom::value);
+  self->send(idx, interned_expression{*expr}, continuous_atom::value,
+             disable_atom::value);
   self->receive([&](down_msg const& msg) { CHECK(msg.source == task); });
   auto e = event::make(record{1337u, std::to_string(1337)}, type0);
   e.id(4711);
@@ -88,4 +90,70 @@ TEST(index) {
   rm(dir);
 }
 
+TEST(index cancellation) {
+  using bitstream_type = index::bitstream_type;
+
+  MESSAGE("sending events to index in many partitions");
+  path dir = "vast-test-index-cancellation";
+  scoped_actor self;
+  auto idx = self->spawn<priority_aware>(index::make, dir, 16, 2, 1);
+  for (auto i = 0u; i < events0.size(); i += 16)
+    self->send(idx, std::vector<event>(events0.begin() + i,
+                                       events0.begin() + i + 16));
+  self->send_exit(idx, exit::done);
+  self->await_all_other_actors_done();
+
+  MESSAGE("cancelling a query right after issuing it");
+  // Of the 32 partitions, INDEX loads 2 at a time. Cancelling the query
+  // before any of them completes leaves the others unloaded. Subscribing
+  // again while the cancelled query completes starts over once it is done.
+  idx = self->spawn<priority_aware>(index::make, dir, 16, 2, 1);
+  auto expr = interned_expression{*to<expression>("c < 512")};
+  self->send(idx, expr, historical, self);
+  self->send(idx, expr, disable_atom::value);
+  self->send(idx, expr, historical, self);
+  actor task;
+  self->receive(
+    [&](actor const& t) {
+      REQUIRE(t != invalid_actor);
+      self->monitor(t);
+      self->send(t, subscriber_atom::value, self);
+      task = t;
+    });
+
+  MESSAGE("getting results of the second query");
+  auto cancelled = false;
+  auto done = false;
+  uint64_t stages = 0;
+  bitstream_type hits;
+  self->do_receive(
+    [&](progress_atom, uint64_t, uint64_t total) {
+      CHECK(self->current_sender() == task);
+      stages = total;
+    },
+    [&](down_msg const& msg) {
+      CHECK(msg.source == task);
+      cancelled = true;
+    },
+    [&](actor const& t) {
+      CHECK(t != task);
+    },
+    [&](bitstream_type const& h) {
+      hits |= h;
+    },
+    [&](done_atom, time::moment, time::extent,
+        interned_expression const& e) {
+      CHECK(*expr == *e);
+      done = true;
+    }
+  ).until([&] { return cancelled && done; });
+  CHECK(stages == 2);
+  CHECK(hits.count() == 512);
+
+  MESSAGE("cleaning up");
+  self->send_exit(idx, exit::done);
+  self->await_all_other_actors_done();
+  rm(dir);
+}
+
 FIXTURE_SCOPE_END()
@@ -49,10 +49,10 @@ TEST(indexer)
   predicate pred{type_extractor{type::count{}}, less, data{100u}};
   t = self->spawn<monitored>(task::make<>);
   self->send(t, i0);
-  self->send(i0, expression{pred}, self, t);
+  self->send(i0, interned_predicate{pred}, self, t);
   self->receive(
-    [&](expression const& expr, bitstream_type const& hit) {
-      CHECK(expr == expression{pred});
+    [&](interned_predicate const& p, bitstream_type const& hit) {
+      CHECK(*p == pred);
       CHECK(hit.find_first() == 0);
       CHECK(hit.count() == 100 / 2); // Every other event in [0,100).
     });
@@ -62,10 +62,10 @@ TEST(indexer)
   pred = {type_extractor{t1}, less_equal, data{42.0}};
   t = self->spawn<monitored>(task::make<>);
   self->send(t, i1);
-  self->send(i1, expression{pred}, self, t);
+  self->send(i1, interned_predicate{pred}, self, t);
   self->receive(
-    [&](expression const& expr, bitstream_type const& hit) {
-      CHECK(expr == expression{pred});
+    [&](interned_predicate const& p, bitstream_type const& hit) {
+      CHECK(*p == pred);
       CHECK(hit.find_first() == 1);
       CHECK(hit.count() == 19);
     });
@@ -96,14 +96,109 @@ TEST(indexer)
   pred = predicate{type_extractor{type::count{}}, equal, data{998u}};
   t = self->spawn<monitored>(task::make<>);
   self->send(t, i0);
-  self->send(i0, expression{pred}, self, t);
+  self->send(i0, interned_predicate{pred}, self, t);
   self->receive(
-    [&](expression const& expr, bitstream_type const& hit) {
-      CHECK(expr == expression{pred});
+    [&](interned_predicate const& p, bitstream_type const& hit) {
+      CHECK(*p == pred);
       CHECK(hit.find_first() == 998u);
       CHECK(hit.count() == 1);
     });
   self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
+
+  MESSAGE("appending to the delta log");
+  std::vector<event> more(10);
+  for (size_t i = 0; i < more.size(); ++i) {
+    more[i] = event::make(record{n + i, std::to_string(n + i)}, t0);
+    more[i].id(n + i);
+  }
+  self->send(i0, load_atom::value);
+  t = self->spawn<monitored>(task::make<>);
+  self->send(t, i0);
+  self->send(i0, more, t);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
+  t = self->spawn<monitored>(task::make<>);
+  self->send(t, i0);
+  self->send(i0, flush_atom::value, t);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
+  CHECK(exists(dir0 / "meta" / "name.log"));
+  self->send_exit(i0, exit::done);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == i0); });
+  CHECK(!exists(dir0 / "meta" / "name.log"));
+
+  MESSAGE("querying the compacted index");
+  i0 = self->spawn(event_indexer<bitstream_type>::make, dir0, t0);
+  self->monitor(i0);
+  pred = predicate{type_extractor{type::count{}}, greater_equal, data{998u}};
+  t = self->spawn<monitored>(task::make<>);
+  self->send(t, i0);
+  self->send(i0, interned_predicate{pred}, self, t);
+  self->receive(
+    [&](interned_predicate const& p, bitstream_type const& hit) {
+      CHECK(*p == pred);
+      CHECK(hit.find_first() == 998u);
+      CHECK(hit.count() == 1 + more.size());
+    });
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
+  self->send_exit(i0, exit::done);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == i0); });
+
+  MESSAGE("appending two records to the delta log and crashing");
+  i0 = self->spawn(event_indexer<bitstream_type>::make, dir0, t0);
+  self->monitor(i0);
+  self->send(i0, load_atom::value);
+  auto log = dir0 / "meta" / "name.log";
+  size_t first_record = 0;
+  for (auto batch = 1; batch <= 2; ++batch) {
+    std::vector<event> xs(10);
+    for (size_t i = 0; i < xs.size(); ++i) {
+      auto id = n + batch * more.size() + i;
+      xs[i] = event::make(record{id, std::to_string(id)}, t0);
+      xs[i].id(id);
+    }
+    t = self->spawn<monitored>(task::make<>);
+    self->send(t, i0);
+    self->send(i0, xs, t);
+    self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
+    t = self->spawn<monitored>(task::make<>);
+    self->send(t, i0);
+    self->send(i0, flush_atom::value, t);
+    self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
+    if (batch == 1) {
+      auto contents = load_contents(log);
+      REQUIRE(contents);
+      first_record = contents->size();
+    }
+  }
+  // Killing the indexer skips compaction.
+  self->send_exit(i0, exit::kill);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == i0); });
+
+  MESSAGE("tearing the log inside the length prefix of the second record");
+  {
+    auto contents = load_contents(log);
+    REQUIRE(contents);
+    // The 10 event names make for a record with a multi-byte length.
+    REQUIRE(contents->size() > first_record + 2);
+    file f{log};
+    REQUIRE(f.open(file::write_only));
+    REQUIRE(f.write(contents->data(), first_record + 1));
+  }
+
+  MESSAGE("replaying the torn log");
+  i0 = self->spawn(event_indexer<bitstream_type>::make, dir0, t0);
+  self->monitor(i0);
+  pred = predicate{event_extractor{}, equal, data{t0.name()}};
+  t = self->spawn<monitored>(task::make<>);
+  self->send(t, i0);
+  self->send(i0, interned_predicate{pred}, self, t);
+  self->receive(
+    [&](interned_predicate const& p, bitstream_type const& hit) {
+      CHECK(*p == pred);
+      // The even events, plus the 10 from before and the 10 of the first
+      // intact record.
+      CHECK(hit.count() == n / 2 + 2 * more.size());
+    });
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
   self->send_exit(i0, exit::done);
   self->receive([&](down_msg const& msg) { CHECK(msg.source == i0); });
 
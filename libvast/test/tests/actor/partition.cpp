@@ -1,5 +1,6 @@
 #include "vast/bitstream.hpp"
 #include "vast/event.hpp"
+#include "vast/json.hpp"
 #include "vast/actor/partition.hpp"
 #include "vast/actor/task.hpp"
 #include "vast/concept/parseable/to.hpp"
@@ -37,25 +38,59 @@ TEST(partition) {
   p = self->spawn<monitored + priority_aware>(partition::make, dir, self);
   auto expr = to<expression>("&time < now && c >= 42 && c < 84");
   REQUIRE(expr);
-  self->send(p, *expr, historical_atom::value);
+  self->send(p, interned_expression{*expr}, historical_atom::value);
   bool done = false;
   bitstream_type hits;
   self->do_receive(
-    [&](expression const& e, bitstream_type const& h, historical_atom) {
-      CHECK(*expr == e);
+    [&](interned_expression const& e, bitstream_type const& h,
+        historical_atom) {
+      CHECK(*expr == *e);
       hits |= h;
     },
-    [&](done_atom, time::moment, expression const& e) {
-      CHECK(*expr == e);
+    [&](done_atom, time::moment, interned_expression const& e) {
+      CHECK(*expr == *e);
       done = true;
     }
   ).until([&] { return done; });
   CHECK(hits.count() == 42);
 
+  MESSAGE("explaining the query");
+  self->send(p, interned_expression{*expr}, historical_atom::value,
+             explain_atom::value);
+  done = false;
+  json plan;
+  self->do_receive(
+    [&](interned_expression const&, bitstream_type const&, historical_atom) {
+      // The partition relays the hits it has already.
+    },
+    [&](interned_expression const& e, explain_atom, json const& j) {
+      CHECK(*expr == *e);
+      CHECK(!done);
+      plan = j;
+    },
+    [&](done_atom, time::moment, interned_expression const& e) {
+      CHECK(*expr == *e);
+      done = true;
+    }
+  ).until([&] { return done; });
+  auto lookup = get<json::object>(plan);
+  REQUIRE(lookup);
+  CHECK((*lookup)["stages"] == json{3});
+  CHECK((*lookup)["skipped"] == json{0});
+  auto preds = get<json::array>((*lookup)["predicates"]);
+  REQUIRE(preds);
+  CHECK(preds->size() == 3);
+  auto ops = get<json::array>((*lookup)["operators"]);
+  REQUIRE(ops);
+  REQUIRE(ops->size() == 4);
+  auto query = get<json::object>(ops->back());
+  REQUIRE(query);
+  CHECK((*query)["hits"] == json{42});
+
   MESSAGE("creating a continuous query");
   expr = to<expression>("s ni \"7\"");
   REQUIRE(expr);
-  self->send(p, *expr, continuous_atom::value);
+  self->send(p, interned_expression{*expr}, continuous_atom::value);
 
   MESSAGE("sending another event");
   t = self->spawn<monitored>(task::make<time::moment, uint64_t>,
@@ -65,8 +100,9 @@ TEST(partition) {
 
   MESSAGE("getting continuous hits");
   self->receive(
-    [&](expression const& e, bitstream_type const& hits, continuous_atom) {
-      CHECK(*expr == e);
+    [&](interned_expression const& e, bitstream_type const& hits,
+        continuous_atom) {
+      CHECK(*expr == *e);
       // (0..1024)
       //   .select{|x| x % 2 == 0}
       //   .map{|x| x.to_s}
@@ -76,7 +112,8 @@ TEST(partition) {
     });
 
   MESSAGE("disabling continuous query and sending another event");
-  self->send(p, *expr, continuous_atom::value, disable_atom::value);
+  self->send(p, interned_expression{*expr}, continuous_atom::value,
+             disable_atom::value);
   auto e = event::make(record{1337u, std::to_string(1337)}, type0);
   e.id(4711);
   t = self->spawn<monitored>(task::make<time::moment, uint64_t>,
@@ -86,6 +123,29 @@ TEST(partition) {
   // Make sure that we didn't get any new hits.
   CHECK(self->mailbox().count() == 0);
 
+  MESSAGE("evaluating a continuous query with a failing lookup");
+  // The INDEXER for c cannot look up "in" and terminates, yet it must still
+  // answer so that the continuous query completes the batch.
+  expr = to<expression>(":count in 42 || s ni \"7\"");
+  REQUIRE(expr);
+  self->send(p, interned_expression{*expr}, continuous_atom::value);
+  std::vector<event> more(10);
+  for (auto i = 0u; i < more.size(); ++i) {
+    more[i] = event::make(record{5000u + i, std::to_string(5000 + i)}, type0);
+    more[i].id(5000 + i);
+  }
+  t = self->spawn<monitored>(task::make<time::moment, uint64_t>,
+                             time::snapshot(), more.size());
+  self->send(p, more, sch, t);
+  self->receive([&](down_msg const& msg) { CHECK(msg.source == t); });
+  self->receive(
+    [&](interned_expression const& e, bitstream_type const& hits,
+        continuous_atom) {
+      CHECK(*expr == *e);
+      CHECK(hits.count() == 1);
+      CHECK(hits.find_first() == 5007);
+    });
+
   MESSAGE("cleaning up");
   self->send_exit(p, exit::done);
   self->await_all_other_actors_done();
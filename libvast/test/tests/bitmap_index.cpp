@@ -82,6 +82,98 @@ TEST(integral) {
   CHECK(bmi == bmi2);
 }
 
+namespace {
+
+// Compares all arithmetic lookups against a scan over the input values.
+template <typename BitmapIndex>
+size_t check_lookups(BitmapIndex const& bmi, std::vector<integer> const& xs) {
+  auto failures = size_t{0};
+  auto ops = {less, less_equal, equal, not_equal, greater_equal, greater};
+  for (auto op : ops)
+    for (auto i = 0u; i < xs.size(); i += 7)
+      for (auto probe : {xs[i] - 1, xs[i], xs[i] + 1}) {
+        auto r = bmi.lookup(op, probe);
+        if (!r || r->size() != xs.size()) {
+          ++failures;
+          continue;
+        }
+        for (auto j = 0u; j < xs.size(); ++j)
+          if ((*r)[j] != data::evaluate(xs[j], op, probe))
+            ++failures;
+      }
+  return failures;
+}
+
+} // namespace <anonymous>
+
+TEST(arithmetic coding selection) {
+  using bitmap_index_type = arithmetic_bitmap_index<null_bitstream, integer>;
+  MESSAGE("low cardinality");
+  bitmap_index_type low{64};
+  std::vector<integer> xs;
+  for (auto i = 0; i < 100; ++i)
+    xs.push_back(i % 3 == 0 ? 200 : i % 3 == 1 ? 404 : -1);
+  for (auto i = 0u; i < xs.size(); ++i) {
+    if (i == 63)
+      CHECK(low.coding() == arithmetic_coding::undecided);
+    REQUIRE(low.push_back(xs[i]));
+  }
+  CHECK(low.coding() == arithmetic_coding::equality);
+  CHECK(check_lookups(low, xs) == 0);
+  MESSAGE("high cardinality");
+  bitmap_index_type high{64};
+  xs.clear();
+  for (auto i = 0; i < 100; ++i)
+    xs.push_back(i * 7919 - 1000);
+  for (auto x : xs)
+    REQUIRE(high.push_back(x));
+  CHECK(high.coding() == arithmetic_coding::bitslice);
+  CHECK(check_lookups(high, xs) == 0);
+  MESSAGE("medium cardinality");
+  bitmap_index_type medium{128};
+  xs.clear();
+  for (auto i = 0; i < 200; ++i)
+    xs.push_back(i % 40);
+  for (auto x : xs)
+    REQUIRE(medium.push_back(x));
+  CHECK(medium.coding() == arithmetic_coding::range);
+  CHECK(check_lookups(medium, xs) == 0);
+  MESSAGE("equality coding outgrowing its dictionary");
+  bitmap_index_type growing{8};
+  xs.clear();
+  for (auto i = 0; i < 8; ++i)
+    xs.push_back(i % 2);
+  for (auto i = 0; i < 400; ++i)
+    xs.push_back(i);
+  for (auto i = 0u; i < xs.size(); ++i) {
+    if (i == 8)
+      CHECK(growing.coding() == arithmetic_coding::equality);
+    REQUIRE(growing.push_back(xs[i]));
+  }
+  CHECK(growing.coding() == arithmetic_coding::range);
+  CHECK(check_lookups(growing, xs) == 0);
+  MESSAGE("nil values and offsets");
+  bitmap_index_type sparse{4};
+  CHECK(sparse.push_back(42, 2));
+  CHECK(sparse.push_back(nil));
+  CHECK(sparse.push_back(43, 5));
+  CHECK(sparse.push_back(42));
+  CHECK(sparse.push_back(44));
+  CHECK(sparse.coding() == arithmetic_coding::equality);
+  CHECK(to_string(*sparse.lookup(equal, 42)) == "00100010");
+  CHECK(to_string(*sparse.lookup(greater, 42)) == "00000101");
+  CHECK(to_string(*sparse.lookup(equal, nil)) == "00010000");
+  MESSAGE("serialization");
+  std::vector<uint8_t> buf;
+  save(buf, sparse, growing);
+  bitmap_index_type sparse2, growing2;
+  load(buf, sparse2, growing2);
+  CHECK(sparse == sparse2);
+  CHECK(growing == growing2);
+  CHECK(sparse2.coding() == arithmetic_coding::equality);
+  CHECK(to_string(*sparse2.lookup(less_equal, 43)) == "00100110");
+}
+
 TEST(floating-point with custom binner) {
   arithmetic_bitmap_index<null_bitstream, real, precision_binner<6, 2>> bmi;
   CHECK(bmi.push_back(-7.8));
@@ -178,6 +270,52 @@ TEST(time point) {
   CHECK(bmi == bmi2);
 }
 
+TEST(time index) {
+  time_bitmap_index<null_bitstream> bmi{4};
+  // Nearly ordered timestamps with nanosecond differences, a few stragglers,
+  // nil values, and gaps in the rows.
+  auto base = time::point{} + time::seconds(1389850215);
+  std::vector<int64_t> ns = {0, 1, 1, 5, 3, 7, 7, 9, 8, 20, 21, 22, -4, 30};
+  std::vector<maybe<time::point>> xs(10);
+  for (auto i = 0u; i < ns.size(); ++i) {
+    auto t = base + time::nanoseconds(ns[i]);
+    REQUIRE(bmi.push_back(t, xs.size()));
+    xs.push_back(t);
+    if (i % 5 == 4) {
+      REQUIRE(bmi.push_back(nil));
+      xs.push_back(nil);
+    }
+  }
+  auto failures = 0u;
+  auto ops = {less, less_equal, equal, not_equal, greater_equal, greater};
+  for (auto op : ops)
+    for (auto n : {-5, -4, 0, 1, 2, 7, 8, 9, 21, 30, 31}) {
+      auto probe = base + time::nanoseconds(n);
+      auto r = bmi.lookup(op, probe);
+      if (!r || r->size() != xs.size()) {
+        ++failures;
+        continue;
+      }
+      auto hits = 0u;
+      for (auto j = 0u; j < xs.size(); ++j) {
+        auto expected = xs[j] && data::evaluate(*xs[j], op, probe);
+        if ((*r)[j] != expected)
+          ++failures;
+        hits += expected ? 1 : 0;
+      }
+      if (bmi.estimate(op, probe) != hits)
+        ++failures;
+    }
+  CHECK(failures == 0);
+  CHECK(!bmi.lookup(in, base));
+  MESSAGE("serialization");
+  std::vector<uint8_t> buf;
+  save(buf, bmi);
+  decltype(bmi) bmi2;
+  load(buf, bmi2);
+  CHECK(bmi == bmi2);
+}
+
 TEST(string) {
   string_bitmap_index<null_bitstream> bmi;
   CHECK(bmi.push_back("foo"));
@@ -214,6 +352,12 @@ TEST(string) {
   auto e = bmi.lookup(match, "foo");
   CHECK(! e);
 
+  MESSAGE("literal prefix of patterns");
+  CHECK(to_string(*bmi.lookup(match, pattern{"ba.*"})) == "0110010001");
+  CHECK(to_string(*bmi.lookup(match, pattern{"baz+"})) == "0010000001");
+  CHECK(to_string(*bmi.lookup(match, pattern{"quux"})) == "0000000000");
+  CHECK(to_string(*bmi.lookup(not_match, pattern{"ba.*"})) == "1111111111");
+
   MESSAGE("serialization");
   std::vector<uint8_t> buf;
   save(buf, bmi);
@@ -224,6 +368,90 @@ TEST(string) {
   CHECK(to_string(*bmi2.lookup(equal, "bar")) == "0100010000");
 }
 
+TEST(dictionary string) {
+  dictionary_bitmap_index<null_bitstream> bmi;
+  auto long_str = std::string(100, 'x') + "foo";
+  CHECK(bmi.push_back("foo"));
+  CHECK(bmi.push_back("bar"));
+  CHECK(bmi.push_back("baz"));
+  CHECK(bmi.push_back("foo"));
+  CHECK(bmi.push_back(nil));
+  CHECK(bmi.push_back("bar"));
+  CHECK(bmi.push_back(""));
+  CHECK(bmi.push_back(long_str));
+  CHECK(bmi.push_back("foo"));
+  CHECK(bmi.push_back(long_str));
+  CHECK(bmi.cardinality() == 5);
+
+  CHECK(to_string(*bmi.lookup(equal, "foo")) ==   "1001000010");
+  CHECK(to_string(*bmi.lookup(equal, "bar")) ==   "0100010000");
+  CHECK(to_string(*bmi.lookup(equal, "")) ==      "0000001000");
+  CHECK(to_string(*bmi.lookup(equal, "qux")) ==   "0000000000");
+  CHECK(to_string(*bmi.lookup(equal, long_str)) == "0000000101");
+  CHECK(to_string(*bmi.lookup(not_equal, "foo")) == "0110111101");
+  CHECK(to_string(*bmi.lookup(equal, nil)) ==     "0000100000");
+
+  MESSAGE("substring search includes hashed strings");
+  CHECK(to_string(*bmi.lookup(ni, "a")) ==      "0110010101");
+  CHECK(to_string(*bmi.lookup(not_ni, "a")) ==  "1001001111");
+
+  MESSAGE("patterns");
+  CHECK(to_string(*bmi.lookup(match, pattern{"ba."})) ==    "0110010101");
+  CHECK(to_string(*bmi.lookup(match, pattern{"f.*"})) ==    "1001000111");
+  CHECK(to_string(*bmi.lookup(not_match, pattern{"f.*"})) == "0110011101");
+
+  auto e = bmi.lookup(less, "foo");
+  CHECK(! e);
+
+  MESSAGE("serialization");
+  std::vector<uint8_t> buf;
+  save(buf, bmi);
+  decltype(bmi) bmi2;
+  load(buf, bmi2);
+  CHECK(bmi == bmi2);
+  CHECK(to_string(*bmi2.lookup(equal, "foo")) == "1001000010");
+  CHECK(to_string(*bmi2.lookup(equal, long_str)) == "0000000101");
+}
+
+TEST(dictionary pattern) {
+  dictionary_bitmap_index<null_bitstream> bmi;
+  std::vector<data> xs;
+  for (auto str : {"foo", "ba.", "foo", "f.*", "", "b[a-z]+"}) {
+    REQUIRE(bmi.push_back(pattern{str}));
+    xs.emplace_back(pattern{str});
+  }
+  MESSAGE("index agrees with evaluator");
+  auto failures = 0u;
+  auto ops = {equal, not_equal, match, not_match, ni, not_ni};
+  auto probes = std::vector<data>{
+    "foo", "bar", "/foo/", "xfoox", pattern{"foo"}, pattern{"f.*"},
+    pattern{"qux"}, pattern{"ba."}};
+  for (auto op : ops)
+    for (auto& probe : probes) {
+      auto r = bmi.lookup(op, probe);
+      if (!r || r->size() != xs.size()) {
+        ++failures;
+        continue;
+      }
+      for (auto i = 0u; i < xs.size(); ++i)
+        if ((*r)[i] != data::evaluate(xs[i], op, probe))
+          ++failures;
+    }
+  CHECK(failures == 0);
+  CHECK(to_string(*bmi.lookup(match, pattern{"f.*"})) ==     "000000");
+  CHECK(to_string(*bmi.lookup(not_match, pattern{"f.*"})) == "111111");
+  CHECK(to_string(*bmi.lookup(equal, pattern{"foo"})) ==     "101000");
+  CHECK(to_string(*bmi.lookup(ni, "bar")) ==                 "010011");
+  CHECK(bmi.estimate(equal, "/foo/") == 0u);
+  MESSAGE("serialization");
+  std::vector<uint8_t> buf;
+  save(buf, bmi);
+  decltype(bmi) bmi2;
+  load(buf, bmi2);
+  CHECK(bmi == bmi2);
+  CHECK(to_string(*bmi2.lookup(match, pattern{"foo"})) == "000000");
+}
+
 TEST(address) {
   address_bitmap_index<null_bitstream> bmi;
   CHECK(bmi.push_back(*to<address>("192.168.0.1")));
@@ -271,6 +499,37 @@ TEST(address) {
   REQUIRE(bs);
   CHECK(to_string(*bs) == "11111111101");
 
+  MESSAGE("IPv6 addresses");
+  CHECK(to_string(*bmi.lookup(equal, *to<address>("::1"))) == "00000000000");
+  CHECK(bmi.push_back(*to<address>("2001:db8::1")));
+  CHECK(bmi.push_back(*to<address>("192.168.0.1")));
+  CHECK(bmi.push_back(*to<address>("2001:db8::c0a8:1")));
+  CHECK(bmi.push_back(*to<address>("::ffff:10.0.0.1")));
+  CHECK(bmi.push_back(*to<address>("2001:db9::1")));
+  bs = bmi.lookup(equal, *to<address>("192.168.0.1"));
+  CHECK(to_string(*bs) == "1001100000001000");
+  bs = bmi.lookup(equal, *to<address>("2001:db8::1"));
+  CHECK(to_string(*bs) == "0000000000010000");
+  bs = bmi.lookup(not_equal, *to<address>("2001:db8::1"));
+  CHECK(to_string(*bs) == "1111111111101111");
+  bs = bmi.lookup(equal, *to<address>("10.0.0.1"));
+  CHECK(to_string(*bs) == "0000000000000010");
+  bs = bmi.lookup(in, subnet{*to<address>("2001:db8::"), 32});
+  CHECK(to_string(*bs) == "0000000000010100");
+  bs = bmi.lookup(in, subnet{*to<address>("2001:db8::"), 31});
+  CHECK(to_string(*bs) == "0000000000010101");
+  MESSAGE("IPv6 prefixes covering IPv4-mapped addresses");
+  bs = bmi.lookup(in, subnet{*to<address>("::"), 8});
+  CHECK(to_string(*bs) == "1111111111101010");
+  bs = bmi.lookup(in, subnet{*to<address>("::"), 80});
+  CHECK(to_string(*bs) == "1111111111101010");
+  bs = bmi.lookup(in, subnet{*to<address>("::fffe:0:0"), 95});
+  CHECK(to_string(*bs) == "1111111111101010");
+  bs = bmi.lookup(in, subnet{*to<address>("::fffe:0:0"), 96});
+  CHECK(to_string(*bs) == "0000000000000000");
+  bs = bmi.lookup(not_in, subnet{*to<address>("10.0.0.0"), 8});
+  CHECK(to_string(*bs) == "1111111111111101");
+
   MESSAGE("serialization");
   std::vector<uint8_t> buf;
   save(buf, bmi);
@@ -374,6 +633,69 @@ TEST(container) {
   auto strings = vector{"you", "won't", "believe", "it"};
   CHECK(bmi.push_back(strings));
 
+  MESSAGE("large containers");
+  vector large(10000, "x");
+  large.back() = "qux";
+  CHECK(bmi.push_back(large));
+  CHECK(bmi.push_back(vector{}));
+  CHECK(to_string(*bmi.lookup(in, "qux")) == "0100010");
+  CHECK(to_string(*bmi.lookup(not_in, "qux")) == "1011101");
+  CHECK(to_string(*bmi.lookup(in, "x")) == "0000010");
+  CHECK(! bmi.lookup_position(0, equal, "foo"));
+
+  MESSAGE("serialization");
+  std::vector<uint8_t> buf;
+  save(buf, bmi);
+  decltype(bmi) bmi2;
+  load(buf, bmi2);
+  CHECK(bmi == bmi2);
+}
+
+TEST(container positions) {
+  sequence_bitmap_index<null_bitstream> bmi{type::count{}, true};
+  CHECK(bmi.push_back(vector{1u, 2u, 3u}));
+  CHECK(bmi.push_back(vector{3u, 2u}));
+  CHECK(bmi.push_back(nil));
+  CHECK(bmi.push_back(vector{2u}));
+  CHECK(to_string(*bmi.lookup(in, 2u)) == "1101");
+  CHECK(to_string(*bmi.lookup_position(0, equal, 2u)) == "0001");
+  CHECK(to_string(*bmi.lookup_position(1, equal, 2u)) == "1100");
+  CHECK(to_string(*bmi.lookup_position(0, greater, 1u)) == "0101");
+  CHECK(to_string(*bmi.lookup_position(2, equal, 3u)) == "1000");
+  CHECK(to_string(*bmi.lookup_position(3, equal, 3u)) == "0000");
+}
+
+TEST(table) {
+  table_bitmap_index<null_bitstream> bmi{type::count{}};
+  std::vector<data> xs{
+    table{{1u, "foo"}, {2u, "bar"}},
+    table{},
+    table{{3u, "foo"}},
+    nil,
+    table{{2u, "baz"}, {4u, "qux"}, {5u, "foo"}}};
+  for (auto& x : xs)
+    CHECK(bmi.push_back(x));
+  CHECK(to_string(*bmi.lookup(ni, 2u)) ==       "10001");
+  CHECK(to_string(*bmi.lookup(ni, 3u)) ==       "00100");
+  CHECK(to_string(*bmi.lookup(not_ni, 2u)) ==   "01110");
+  CHECK(to_string(*bmi.lookup(ni, 6u)) ==       "00000");
+  CHECK(to_string(*bmi.lookup(equal, "foo")) == "11111");
+
+  MESSAGE("index hits are a superset of the evaluated rows");
+  std::vector<std::pair<relational_operator, data>> preds{
+    {ni, 2u}, {not_ni, 2u}, {ni, 6u}, {equal, "foo"}, {not_equal, "foo"},
+    {in, 2u}, {equal, table{{3u, "foo"}}}};
+  for (auto& p : preds) {
+    auto hits = bmi.lookup(p.first, p.second);
+    REQUIRE(hits);
+    for (auto i = 0u; i < xs.size(); ++i)
+      if (data::evaluate(xs[i], p.first, p.second))
+        CHECK((*hits)[i]);
+  }
+  // For key membership, the index is exact.
+  for (auto i = 0u; i < xs.size(); ++i)
+    CHECK((*bmi.lookup(ni, 2u))[i] == data::evaluate(xs[i], ni, data{2u}));
+
   MESSAGE("serialization");
   std::vector<uint8_t> buf;
   save(buf, bmi);
@@ -409,3 +731,49 @@ TEST(offset_push_back) {
   REQUIRE(r);
   CHECK(to_string(*r) == "00110001");
 }
+
+TEST(statistics) {
+  MESSAGE("exact estimates from per-value bins");
+  arithmetic_bitmap_index<null_bitstream, count> counts{16};
+  for (auto i = 0u; i < 100; ++i)
+    REQUIRE(counts.push_back(count{i % 4}));
+  REQUIRE(counts.push_back(nil));
+  CHECK(counts.coding() == arithmetic_coding::equality);
+  auto stats = counts.statistics();
+  CHECK(stats.rows == 101);
+  CHECK(stats.nils == 1);
+  CHECK(stats.distinct == 4);
+  CHECK(counts.estimate(equal, count{2}) == 25);
+  CHECK(counts.estimate(less, count{2}) == 50);
+  CHECK(counts.estimate(equal, count{42}) == 0);
+  CHECK(counts.estimate(equal, nil) == 1);
+  MESSAGE("dictionary");
+  dictionary_bitmap_index<null_bitstream> dict;
+  for (auto i = 0; i < 30; ++i)
+    REQUIRE(dict.push_back(i % 3 == 0 ? "foo" : "bar"));
+  CHECK(dict.statistics().distinct == 2);
+  CHECK(dict.estimate(equal, "foo") == 10);
+  CHECK(dict.estimate(not_equal, "foo") == 20);
+  CHECK(dict.estimate(equal, "qux") == 0);
+  MESSAGE("distinct-value sketches");
+  string_bitmap_index<null_bitstream> names;
+  address_bitmap_index<null_bitstream> addrs;
+  for (auto i = 0; i < 1000; ++i) {
+    REQUIRE(names.push_back("bro::conn"));
+    auto a = *to<address>("10.0." + std::to_string(i / 256) + '.'
+                          + std::to_string(i % 256));
+    REQUIRE(addrs.push_back(a));
+  }
+  CHECK(names.statistics().distinct == 1);
+  CHECK(names.estimate(equal, "bro::conn") == 1000);
+  auto distinct = addrs.statistics().distinct;
+  CHECK(distinct > 700);
+  CHECK(distinct < 1300);
+  auto a = *to<address>("10.0.0.1");
+  CHECK(addrs.estimate(equal, a) < 10);
+  CHECK(addrs.estimate(less, a) == 1000);
+  MESSAGE("polymorphic");
+  bitmap_index<null_bitstream> bmi{std::move(dict)};
+  CHECK(bmi.statistics().rows == 30);
+  CHECK(bmi.estimate(equal, "bar") == 20);
+}
@@ -4,6 +4,7 @@
 #include "vast/concept/printable/vast/bitstream.hpp"
 #include "vast/concept/serializable/io.hpp"
 #include "vast/concept/serializable/vast/bitstream_polymorphic.hpp"
+#include "vast/util/system.hpp"
 
 #define SUITE bitstream
 #include "test.hpp"
@@ -273,6 +274,46 @@ TEST(polymorphic) {
   CHECK(y.size() == 3);
 }
 
+TEST(memory-mapped EWAH) {
+  auto x = make_ewah3();
+  auto filename = path{"/tmp"}
+    / ("vast-unit-test-mapped-ewah-" + std::to_string(util::process_id()));
+  // The leading byte throws off alignment, which the format compensates for.
+  REQUIRE(save(filename, uint8_t{42}, x));
+  uint8_t u = 0;
+  ewah_bitstream y;
+  REQUIRE(load_mapped(filename, u, y));
+  CHECK(u == 42);
+  CHECK(y.bits().mapped());
+  CHECK(y == x);
+  // Read-only operations work on the mapped blocks.
+  CHECK(y.count() == x.count());
+  CHECK((y & x) == x);
+  CHECK(y.bits().mapped());
+  // Appending promotes the blocks to the heap.
+  y.append(10, true);
+  CHECK(!y.bits().mapped());
+  CHECK(y.size() == x.size() + 10);
+  // The mapping stays alive as long as a bitstream references it.
+  ewah_bitstream z;
+  REQUIRE(load_mapped(filename, u, z));
+  CHECK(rm(filename));
+  CHECK(z == x);
+}
+
+TEST(mapped vector byte order) {
+  util::mapped_vector<uint32_t> x{std::vector<uint32_t>{0x01020304}};
+  std::vector<uint8_t> buf;
+  REQUIRE(save(buf, x));
+  // The size, padding to the alignment of the elements, and the elements in
+  // little-endian byte order.
+  CHECK((buf == std::vector<uint8_t>{1, 0, 0, 0, 4, 3, 2, 1}));
+  util::mapped_vector<uint32_t> y;
+  REQUIRE(load(buf, y));
+  REQUIRE(y.size() == 1);
+  CHECK(y.data()[0] == 0x01020304);
+}
+
 TEST(bitwise operations NULL) {
   null_bitstream x;
   REQUIRE(x.append(3, true));
@@ -579,6 +620,97 @@ TEST(finding EWAH) {
   CHECK(ebs.find_next(64 + 31) == ewah_bitstream::npos);
 }
 
+TEST(rank/select directory EWAH) {
+  // Build a bitstream with long fills, dense dirty blocks, and sparse bits.
+  ewah_bitstream ebs;
+  auto x = uint32_t{42};
+  auto rand = [&] { return x = x * 1103515245 + 12345; };
+  for (auto i = 0; i < 300; ++i) {
+    switch (rand() % 4) {
+      case 0:
+        ebs.append(rand() % 1000, rand() % 2 == 0);
+        break;
+      case 1:
+        for (auto j = rand() % 200; j > 0; --j)
+          ebs.push_back(rand() % 2 == 0);
+        break;
+      case 2:
+        ebs.append(64 * (rand() % 20), true);
+        break;
+      default:
+        ebs.append_block(rand(), rand() % 64 + 1);
+    }
+  }
+  auto dir = ebs;
+  dir.attach_directory(4);
+  REQUIRE(dir == ebs);
+  CHECK(dir.count() == ebs.count());
+  CHECK(dir.find_first() == ebs.find_first());
+  CHECK(dir.find_last() == ebs.find_last());
+  auto failures = 0;
+  auto n = ebs.size();
+  auto rank = ewah_bitstream::size_type{0};
+  auto one = ebs.begin();
+  for (ewah_bitstream::size_type i = 0; i < n; i += rand() % 97 + 1) {
+    if (dir.find_next(i) != ebs.find_next(i))
+      ++failures;
+    if (dir.find_prev(i) != ebs.find_prev(i))
+      ++failures;
+    while (one != ebs.end() && *one < i) {
+      ++one;
+      ++rank;
+    }
+    if (dir.rank(i) != rank)
+      ++failures;
+  }
+  CHECK(failures == 0);
+  CHECK(dir.rank(n) == ebs.count());
+  // The directory catches up with appended bits.
+  dir.append(1000, false);
+  dir.push_back(true);
+  ebs.append(1000, false);
+  ebs.push_back(true);
+  CHECK(dir.find_last() == ebs.size() - 1);
+  CHECK(dir.find_prev(ebs.size() - 1) == ebs.find_prev(ebs.size() - 1));
+  CHECK(dir.count() == ebs.count());
+  dir.append(5000, true);
+  ebs.append(5000, true);
+  CHECK(dir.find_next(n + 500) == n + 1000);
+  CHECK(dir.find_next(n + 1000) == ebs.find_next(n + 1000));
+  CHECK(dir.find_prev(n + 1000) == ebs.find_prev(n + 1000));
+  CHECK(dir.count() == ebs.count());
+  // Rewriting operations rebuild the directory.
+  dir.trim();
+  ebs.trim();
+  CHECK(dir.find_last() == ebs.find_last());
+  ewah_bitstream mask{n / 2, true};
+  dir &= mask;
+  ebs &= mask;
+  CHECK(dir.count() == ebs.count());
+  CHECK(dir.find_last() == ebs.find_last());
+  CHECK(dir.find_next(n / 4) == ebs.find_next(n / 4));
+  dir.flip();
+  ebs.flip();
+  CHECK(dir.count() == ebs.count());
+  CHECK(dir.find_prev(n / 2) == ebs.find_prev(n / 2));
+  // Deserialization rebuilds the directory.
+  ewah_bitstream shifted;
+  shifted.append(333, false);
+  shifted.append(ebs);
+  std::vector<uint8_t> buf;
+  save(buf, shifted);
+  load(buf, dir);
+  REQUIRE(dir == shifted);
+  failures = 0;
+  for (ewah_bitstream::size_type i = 0; i < n; i += rand() % 97 + 1) {
+    if (dir.find_next(i) != shifted.find_next(i))
+      ++failures;
+    if (dir.rank(i) != shifted.rank(i))
+      ++failures;
+  }
+  CHECK(failures == 0);
+}
+
 TEST(bitwise NOT EWAH) {
   ewah_bitstream ebs;
   ebs.push_back(true);
@@ -1,4 +1,5 @@
 #include "vast/chunk.hpp"
+#include "vast/chunk_cache.hpp"
 #include "vast/event.hpp"
 
 #include "test.hpp"
@@ -90,3 +91,48 @@ TEST(chunk_event_extraction) {
   REQUIRE(e);
   CHECK(*get<integer>(*e) == 2000);
 }
+
+TEST(chunk_cache) {
+  auto t = type::integer{};
+  REQUIRE(t.name("test"));
+  std::vector<event> es;
+  for (auto i = 0; i < 100; ++i) {
+    es.push_back(event::make(integer{i}, t));
+    es.back().id(100 + i);
+  }
+  chunk x{es};
+  for (auto& e : es)
+    e.id(e.id() + 100);
+  chunk y{es};
+  // The decoded events take more memory than their serialized form.
+  auto bytes = chunk_cache::footprint(es);
+  CHECK(bytes > x.uncompressed_bytes());
+
+  // The cache has room for one of the two chunks.
+  chunk_cache cache{bytes + bytes / 2};
+  auto a = cache.lookup(x);
+  REQUIRE(a);
+  auto& xs = a->get_as<std::vector<event>>(0);
+  REQUIRE(xs.size() == 100);
+  CHECK(xs[42].id() == 142);
+  CHECK(*get<integer>(xs[42]) == 42);
+  CHECK(cache.size() == bytes);
+
+  MESSAGE("hit");
+  auto b = cache.lookup(x);
+  REQUIRE(b);
+  CHECK(&b->get_as<std::vector<event>>(0) == &xs);
+  CHECK(cache.hits() == 1);
+  CHECK(cache.misses() == 1);
+
+  MESSAGE("eviction");
+  auto c = cache.lookup(y);
+  REQUIRE(c);
+  CHECK(c->get_as<std::vector<event>>(0).front().id() == 200);
+  CHECK(cache.size() == bytes);
+  CHECK(xs.size() == 100);
+  REQUIRE(cache.lookup(x));
+  CHECK(cache.misses() == 3);
+  cache.capacity(0);
+  CHECK(cache.size() == 0);
+}
@@ -122,6 +122,36 @@ TEST(patterns) {
   CHECK(p.search(str));
 
   CHECK(to_string(p) == "/(\\w+ )/");
+
+  MESSAGE("literal prefix");
+  CHECK(pattern("foo.*").literal_prefix() == "foo");
+  CHECK(pattern("^foo\\.bar").literal_prefix() == "foo.bar");
+  CHECK(pattern("foo?").literal_prefix() == "fo");
+  CHECK(pattern("foo+").literal_prefix() == "foo");
+  CHECK(pattern("ab\\d").literal_prefix() == "ab");
+  CHECK(pattern("ab(c|d)").literal_prefix() == "ab");
+  CHECK(pattern("ab|cd").literal_prefix() == "");
+  CHECK(pattern("[ab]c").literal_prefix() == "");
+
+  MESSAGE("automaton");
+  CHECK(pattern("a(b$|c)").match("ac"));
+  CHECK(pattern("(^a|b)c").search("xbc"));
+  CHECK(!pattern("(^a|b)c").search("xac"));
+  CHECK(pattern("ab\\x63").search("xxabc"));
+  CHECK(!pattern("foo$").search("foofoox"));
+  CHECK(pattern("(ab){2,3}").match("ababab"));
+  CHECK(!pattern("(ab){2,3}").match("abababab"));
+  CHECK(pattern("").match(""));
+  CHECK(pattern("x*").search("foo"));
+  // No exponential backtracking.
+  auto as = std::string(10000, 'a');
+  CHECK(!pattern("(a*)*b").match(as));
+  CHECK(!pattern("(a|aa)+c").search(as));
+
+  MESSAGE("fallback");
+  CHECK(pattern("\\bbar").search("foo bar"));
+  CHECK(!pattern("\\bbar").search("foobar"));
+  CHECK(pattern("(a)\\1").match("aa"));
 }
 
 TEST(addresses IPv4) {
@@ -409,6 +439,24 @@ TEST(predicate_evaluation) {
   rhs = real{4.2};
   CHECK(!data::evaluate(lhs, equal, rhs));
   CHECK(data::evaluate(lhs, not_equal, rhs));
+
+  lhs = count{42};
+  rhs = table{{count{42}, "foo"}, {count{43}, "bar"}};
+  CHECK(data::evaluate(lhs, in, rhs));
+  CHECK(data::evaluate(rhs, ni, lhs));
+  CHECK(!data::evaluate(data{"foo"}, in, rhs));
+}
+
+TEST(hashing) {
+  std::hash<data> h;
+  CHECK(h(data{real{0.0}}) == h(data{real{-0.0}}));
+  CHECK(h(data{vector{1u, 2u}}) == h(data{vector{1u, 2u}}));
+  CHECK(h(data{vector{1u, 2u}}) != h(data{vector{2u, 1u}}));
+  CHECK(h(data{vector{1u, 2u}}) != h(data{record{1u, 2u}}));
+  CHECK(h(data{set{1u, 2u}}) != h(data{set{1u, 3u}}));
+  CHECK(h(data{table{{1u, "foo"}}}) != h(data{table{{1u, "bar"}}}));
+  CHECK(h(data{pattern{"foo"}}) != h(data{pattern{"bar"}}));
+  CHECK(h(data{vector{}}) != h(data{vector{vector{}}}));
 }
 
 TEST(serialization) {
@@ -1,7 +1,11 @@
+#include "vast/aggregation.hpp"
 #include "vast/event.hpp"
 #include "vast/json.hpp"
+#include "vast/projection.hpp"
 #include "vast/concept/convertible/vast/event.hpp"
 #include "vast/concept/convertible/to.hpp"
+#include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/address.hpp"
 #include "vast/concept/serializable/vast/value.hpp"
 #include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/event.hpp"
@@ -90,3 +94,149 @@ TEST(event) {
 })json";
   CHECK(to_string(to_json(e)) == expected);
 }
+
+TEST(projection) {
+  auto inner = type::record{
+    {"orig_h", type::address{}},
+    {"resp_h", type::address{}}};
+  auto tr = type::record{
+    {"uid", type::string{}},
+    {"id", inner},
+    {"service", type::string{}}};
+  REQUIRE(tr.name("conn"));
+  auto e = event::make(
+    record{"abc", record{*to<address>("10.0.0.1"), *to<address>("10.0.0.2")},
+           "http"},
+    tr);
+  e.id(42);
+  MESSAGE("keys");
+  projection proj{{"resp_h", "uid"}};
+  auto p = proj(e);
+  CHECK(p.id() == 42);
+  CHECK(p.type().name() == "conn");
+  auto r = get<type::record>(p.type());
+  REQUIRE(r);
+  REQUIRE(r->fields().size() == 2);
+  CHECK(r->fields()[0].name == "id.resp_h");
+  CHECK(r->fields()[1].name == "uid");
+  CHECK(to_string(p) == "conn [42|1970-01-01+00:00:00] (10.0.0.2, \"abc\")");
+  MESSAGE("offsets and patterns");
+  proj = projection{{"1,0", "id.*", "service", "nonexistent"}};
+  p = proj(e);
+  CHECK(to_string(p)
+        == "conn [42|1970-01-01+00:00:00] (10.0.0.1, 10.0.0.2, \"http\")");
+  MESSAGE("empty projection");
+  CHECK(projection{}(e) == e);
+}
+
+TEST(aggregation) {
+  auto tr = type::record{
+    {"host", type::address{}},
+    {"port", type::count{}},
+    {"bytes", type::count{}}};
+  REQUIRE(tr.name("flow"));
+  std::vector<event> events;
+  auto make = [&](std::string const& host, count port, count bytes) {
+    record r{*to<address>(host), port, bytes};
+    events.push_back(event::make(std::move(r), tr));
+  };
+  make("10.0.0.1", 80, 100);
+  make("10.0.0.1", 443, 200);
+  make("10.0.0.2", 80, 300);
+  make("10.0.0.2", 80, 400);
+  make("10.0.0.3", 22, 500);
+  auto run = [&](std::string const& str) {
+    auto a = aggregation::parse(str);
+    REQUIRE(a);
+    for (auto& e : events)
+      a->add(e);
+    std::vector<std::string> rows;
+    for (auto& e : a->results())
+      rows.push_back(to_string(e.data()));
+    return rows;
+  };
+  MESSAGE("count");
+  auto rows = run("count");
+  REQUIRE(rows.size() == 1);
+  CHECK(rows[0] == "(5)");
+  MESSAGE("group by");
+  rows = run("count by port");
+  REQUIRE(rows.size() == 3);
+  CHECK(rows[0] == "(22, 1)");
+  CHECK(rows[1] == "(80, 3)");
+  CHECK(rows[2] == "(443, 1)");
+  MESSAGE("top-k");
+  rows = run("count by host top 2");
+  REQUIRE(rows.size() == 2);
+  CHECK(rows[0] == "(10.0.0.1, 2)");
+  CHECK(rows[1] == "(10.0.0.2, 2)");
+  MESSAGE("sum, min, max, distinct");
+  rows = run("sum bytes by host");
+  REQUIRE(rows.size() == 3);
+  CHECK(rows[1] == "(10.0.0.2, 700)");
+  CHECK(run("min bytes")[0] == "(100)");
+  CHECK(run("max 2")[0] == "(500)");
+  CHECK(run("distinct port by host")[0] == "(10.0.0.1, 2)");
+  MESSAGE("result type");
+  auto a = aggregation::parse("max bytes by host");
+  REQUIRE(a);
+  a->add(events[0]);
+  auto results = a->results();
+  REQUIRE(results.size() == 1);
+  CHECK(results[0].type().name() == "aggregate");
+  auto r = get<type::record>(results[0].type());
+  REQUIRE(r);
+  REQUIRE(r->fields().size() == 2);
+  CHECK(r->fields()[0].name == "host");
+  CHECK(r->fields()[1].name == "max");
+  CHECK(r->fields()[1].type == type::count{});
+  MESSAGE("multiple event types");
+  auto tr2 = type::record{
+    {"host", type::string{}},
+    {"bytes", type::count{}}};
+  REQUIRE(tr2.name("dns"));
+  a = aggregation::parse("sum bytes by host");
+  REQUIRE(a);
+  a->add(events[0]);
+  a->add(event::make(record{"10.0.0.1", 42u}, tr2));
+  a->add(event::make(record{"10.0.0.4", 42u}, tr2));
+  a->add(events[1]);
+  results = a->results();
+  REQUIRE(results.size() == 1);
+  CHECK(to_string(results[0].data()) == "(10.0.0.1, 300)");
+  r = get<type::record>(results[0].type());
+  REQUIRE(r);
+  CHECK(r->fields()[0].type == type::address{});
+  a = aggregation::parse("sum bytes");
+  REQUIRE(a);
+  a->add(events[0]);
+  a->add(event::make(record{"10.0.0.1", 42u}, tr2));
+  CHECK(to_string(a->results()[0].data()) == "(142)");
+  MESSAGE("types with clashing groups leave the value type open");
+  auto tr3 = type::record{{"host", type::address{}}};
+  REQUIRE(tr3.name("conn"));
+  auto tr4 = type::record{
+    {"host", type::string{}},
+    {"bytes", type::real{}}};
+  REQUIRE(tr4.name("http"));
+  a = aggregation::parse("sum bytes by host");
+  REQUIRE(a);
+  a->add(event::make(record{*to<address>("10.0.0.1")}, tr3));
+  a->add(event::make(record{"10.0.0.1", 4.2}, tr4));
+  a->add(events[0]);
+  results = a->results();
+  REQUIRE(results.size() == 1);
+  CHECK(to_string(results[0].data()) == "(10.0.0.1, 100)");
+  r = get<type::record>(results[0].type());
+  REQUIRE(r);
+  CHECK(r->fields()[1].type == type::count{});
+  MESSAGE("parse errors");
+  CHECK(!aggregation::parse(""));
+  CHECK(!aggregation::parse("median bytes"));
+  CHECK(!aggregation::parse("sum by host"));
+  CHECK(!aggregation::parse("count by"));
+  CHECK(!aggregation::parse("count top x"));
+  CHECK(!aggregation::parse("count top -1"));
+  CHECK(!aggregation::parse("count top 2x"));
+  CHECK(!aggregation::parse("count top 99999999999999999999999"));
+}
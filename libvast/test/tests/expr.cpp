@@ -1,15 +1,22 @@
+#include <map>
+
+#include "vast/bitstream.hpp"
 #include "vast/event.hpp"
 #include "vast/expression.hpp"
 #include "vast/logger.hpp"
 #include "vast/schema.hpp"
+#include "vast/expr/checker.hpp"
 #include "vast/expr/evaluator.hpp"
+#include "vast/expr/matcher.hpp"
 #include "vast/expr/resolver.hpp"
 #include "vast/expr/normalize.hpp"
 #include "vast/concept/parseable/to.hpp"
+#include "vast/concept/parseable/vast/address.hpp"
 #include "vast/concept/parseable/vast/expression.hpp"
 #include "vast/concept/parseable/vast/schema.hpp"
 #include "vast/concept/parseable/vast/time.hpp"
 #include "vast/concept/printable/to_string.hpp"
+#include "vast/concept/printable/vast/bitstream.hpp"
 #include "vast/concept/printable/vast/expression.hpp"
 #include "vast/concept/serializable/vast/expression.hpp"
 #include "vast/concept/serializable/io.hpp"
@@ -46,6 +53,38 @@ TEST(serialization) {
   CHECK(to_string(expr), str);
 }
 
+TEST(interning) {
+  auto x = to<expression>(":addr == 1.2.3.4 && &type == \"foo\"");
+  auto y = to<expression>(":addr == 1.2.3.4 && &type == \"foo\"");
+  auto z = to<expression>(":addr == 1.2.3.5 && &type == \"foo\"");
+  REQUIRE(x && y && z);
+  CHECK(std::hash<expression>{}(*x) == std::hash<expression>{}(*y));
+  interned_expression a{*x};
+  interned_expression b{*y};
+  interned_expression c{*z};
+  CHECK(a == b);
+  CHECK(a != c);
+  CHECK(a.id() == b.id());
+  CHECK(a.hash() == std::hash<expression>{}(*x));
+  CHECK(*a == *x);
+  CHECK(interned_expression::find(*y) == a);
+
+  MESSAGE("IDs are stable only while some instance is alive");
+  auto id = a.id();
+  a = {};
+  b = {};
+  CHECK(!interned_expression::find(*x));
+  CHECK(interned_expression{*x}.id() != id);
+
+  MESSAGE("serialization");
+  std::vector<uint8_t> buf;
+  save(buf, c);
+  interned_expression d;
+  load(buf, d);
+  CHECK(c == d);
+  CHECK(to_string(d) == to_string(*z));
+}
+
 TEST(event evaluation) {
   std::string str = R"__(
     type foo = record{
@@ -162,6 +201,206 @@ TEST(event evaluation) {
   CHECK(is<none>(*schema_resolved));
 }
 
+TEST(candidate checking) {
+  std::string str = R"__(
+    type foo = record{s: string, c: count, r: real, a: addr, p: port}
+    type bar = record{s: string, r: record{b: bool, c: count}}
+  )__";
+  auto sch = to<schema>(str);
+  REQUIRE(sch);
+  auto foo = sch->find("foo");
+  auto bar = sch->find("bar");
+  REQUIRE(foo && bar);
+  auto addr = [](std::string const& s) { return *to<address>(s); };
+  std::vector<event> events;
+  events.push_back(event::make(
+    record{"foo", 42u, 4.2, addr("10.0.0.1"), port{80, port::tcp}}, *foo));
+  events.push_back(event::make(
+    record{"bar", 7u, -1.0, addr("192.168.1.1"), port{53, port::udp}}, *foo));
+  events.push_back(event::make(record{"foobar", nil, nil, nil, nil}, *foo));
+  events.push_back(event::make(record{"baz", record{true, 42u}}, *bar));
+  events.push_back(event::make(record{"qux", record{false, nil}}, *bar));
+  auto tp = to<time::point>("2014-01-16+05:30:12");
+  REQUIRE(tp);
+  for (auto& e : events)
+    e.timestamp(*tp);
+  std::vector<std::string> queries = {
+    ":count == 42",
+    ":count != 42",
+    ":count > 7 || :real < 0.0",
+    "c >= 7 && ! r > 4.0",
+    "s ni \"foo\"",
+    "s in [\"bar\",\"baz\"]",
+    ":addr in 10.0.0.0/8",
+    ":addr !in 10.0.0.0/8",
+    ":port == 53/udp",
+    ":string ~ /ba./",
+    "42 == c",
+    "&type == \"foo\" && :count == 42",
+    "&type != \"foo\" || r.b == T",
+    "&time > 2014-01-01+00:00:00 && r.c == 42",
+    "! (s == \"foo\" || s == \"bar\")",
+    "r.b == F && r.c == 42",
+  };
+  for (auto& q : queries) {
+    auto expr = to<expression>(q);
+    REQUIRE(expr);
+    for (auto& e : events) {
+      auto resolved = visit(expr::schema_resolver{e.type()}, *expr);
+      REQUIRE(resolved);
+      auto x = visit(expr::type_resolver{e.type()}, *resolved);
+      expr::checker check{x, e.type()};
+      CHECK(check(e) == visit(expr::event_evaluator{e}, x));
+    }
+  }
+  MESSAGE("constant folding");
+  auto expr = to<expression>("&type == \"foo\" && :count == 42");
+  REQUIRE(expr);
+  auto x = visit(expr::type_resolver{*foo}, *expr);
+  CHECK(expr::checker(x, *foo).size() == 1);
+  CHECK(expr::checker(x, *bar).size() == 1);
+  CHECK(!expr::checker(x, *bar)(events[3]));
+}
+
+TEST(continuous matching) {
+  std::string str = R"__(
+    type foo = record{s: string, c: count, r: real, a: addr, p: port}
+    type bar = record{s: string, r: record{b: bool, c: count}}
+  )__";
+  auto sch = to<schema>(str);
+  REQUIRE(sch);
+  auto foo = sch->find("foo");
+  auto bar = sch->find("bar");
+  REQUIRE(foo);
+  REQUIRE(bar);
+  auto addr = [](std::string const& str) { return *to<address>(str); };
+  std::vector<event> events{
+    event::make(record{"babba", 42u, 1.5, addr("10.0.0.1"),
+                       port{53, port::udp}}, *foo),
+    event::make(record{"yadda", 7u, -4.8, addr("192.168.1.1"),
+                       port{80, port::tcp}}, *foo),
+    event::make(record{"babba", 0u, 0.0, addr("2001:db8::1"),
+                       port{443, port::tcp}}, *foo),
+    event::make(record{"yadda", record{true, 42u}}, *bar),
+    event::make(record{"babba", nil}, *bar)};
+  for (size_t i = 0; i < events.size(); ++i)
+    events[i].timestamp(time::point::utc(2015, 1, 1 + i));
+  std::vector<std::string> queries{
+    "s == \"babba\"",
+    ":count == 42",
+    ":count in {7,42}",
+    ":count > 0 && :count <= 42",
+    "c >= 7 || r < 0.0",
+    ":real > -5.0 && ! :real >= 1.5",
+    ":addr in 10.0.0.0/8",
+    ":addr in 192.168.0.0/16 || :addr in 2001:db8::/32",
+    ":addr !in 10.0.0.0/8",
+    ":port == 53/udp || :port == 80/tcp",
+    ":string ~ /y.*a/",
+    ":string != \"yadda\"",
+    "r.c != 42",
+    "r.b == T && s in \"xyaddax\"",
+    "&type == \"bar\"",
+    "&time > 2015-01-02+00:00:00 && &time < 2015-01-05+00:00:00",
+    ":bool == T || :count == 0"};
+  expr::matcher m;
+  CHECK(m.empty());
+  for (auto& q : queries) {
+    auto ast = to<expression>(q);
+    REQUIRE(ast);
+    CHECK(m.add(*ast));
+  }
+  CHECK(!m.add(m.expressions().front()));
+  MESSAGE("agreement with the event evaluator");
+  auto expected = [&](event const& e) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < m.expressions().size(); ++i) {
+      auto resolved = visit(expr::schema_resolver{e.type()},
+                            m.expressions()[i]);
+      REQUIRE(resolved);
+      auto checker = visit(expr::type_resolver{e.type()}, *resolved);
+      if (visit(expr::event_evaluator{e}, checker))
+        result.push_back(i);
+    }
+    return result;
+  };
+  size_t total = 0;
+  for (auto& e : events) {
+    auto x = expected(e);
+    total += x.size();
+    CHECK(m.match(e) == x);
+  }
+  CHECK(total > events.size());
+  MESSAGE("registration changes");
+  auto ast = to<expression>(":count == 42");
+  REQUIRE(ast);
+  CHECK(m.remove(*ast));
+  CHECK(!m.remove(*ast));
+  for (auto& e : events)
+    CHECK(m.match(e) == expected(e));
+  for (auto& q : queries)
+    m.remove(*to<expression>(q));
+  CHECK(m.empty());
+  CHECK(m.match(events[0]).empty());
+}
+
+namespace {
+
+using hits_map = std::map<predicate, null_bitstream>;
+
+struct hits_evaluator
+  : expr::bitstream_evaluator<hits_evaluator, null_bitstream> {
+  hits_evaluator(hits_map const& hits, size_t& lookups)
+    : hits_{hits}, lookups_{lookups} {
+  }
+
+  null_bitstream const* lookup(predicate const& pred) const {
+    ++lookups_;
+    auto i = hits_.find(pred);
+    return i == hits_.end() ? nullptr : &i->second;
+  }
+
+  hits_map const& hits_;
+  size_t& lookups_;
+};
+
+null_bitstream make_hits(std::string const& str) {
+  null_bitstream bs;
+  for (auto c : str)
+    bs.push_back(c == '1');
+  return bs;
+}
+
+} // namespace <anonymous>
+
+TEST(bitstream evaluation) {
+  auto a = to<expression>(":addr == 1.2.3.4");
+  auto b = to<expression>("&type == \"foo\"");
+  auto c = to<expression>(":count > 42");
+  REQUIRE(a && b && c);
+  hits_map hits;
+  hits[*get<predicate>(*a)] = make_hits("0100");
+  hits[*get<predicate>(*b)] = make_hits("1111");
+  hits[*get<predicate>(*c)] = make_hits("0110");
+  size_t lookups = 0;
+  auto eval = [&](std::string const& str) {
+    auto expr = to<expression>(str);
+    if (!expr)
+      return std::string{"invalid expression"};
+    lookups = 0;
+    return to_string(visit(hits_evaluator{hits, lookups}, *expr));
+  };
+  CHECK(eval(":addr == 1.2.3.4 && &type == \"foo\"") == "0100");
+  CHECK(eval("&type == \"foo\" && ! :count > 42") == "1001");
+  CHECK(eval(":count > 42 || :addr == 1.2.3.4") == "0110");
+  MESSAGE("skip compound operands once predicates yield no hits");
+  hits[*get<predicate>(*a)] = make_hits("0000");
+  CHECK(eval("(&type == \"foo\" || :count > 42) && :addr == 1.2.3.4") == "");
+  CHECK(lookups == 1);
+  CHECK(eval(":count > 42 && :addr == 1.2.3.4 && &type == \"foo\"") == "");
+  CHECK(lookups == 2);
+}
+
 TEST(AST normalization) {
   VAST_INFO("ensuring extractor position on LHS");
   auto expr = to<expression>("\"foo\" in bar");
@@ -308,6 +308,12 @@ TEST(attributes) {
   CHECK(a->value == "");
   // Attributes are part of the type signature.
   CHECK(v != type::vector{type::integer{}});
+  // Some attributes carry a value.
+  type::string s{{{type::attribute::index, "dictionary"}}};
+  a = s.find_attribute(type::attribute::index);
+  REQUIRE(a);
+  CHECK(a->value == "dictionary");
+  CHECK(to_string(s) == "string &index=\"dictionary\"");
 }
 
 TEST(json conversion) {
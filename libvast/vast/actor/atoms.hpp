@@ -22,6 +22,7 @@ using caf::leave_atom;
 using accept_atom = atom_constant<atom("accept")>;
 using announce_atom = atom_constant<atom("announce")>;
 using batch_atom = atom_constant<atom("batch")>;
+using check_atom = atom_constant<atom("check")>;
 using connect_atom = atom_constant<atom("connect")>;
 using continuous_atom = atom_constant<atom("continuous")>;
 using data_atom = atom_constant<atom("data")>;
@@ -30,7 +31,9 @@ using disconnect_atom = atom_constant<atom("disconnect")>;
 using done_atom = atom_constant<atom("done")>;
 using empty_atom = atom_constant<atom("empty")>;
 using enable_atom = atom_constant<atom("enable")>;
+using estimate_atom = atom_constant<atom("estimate")>;
 using exists_atom = atom_constant<atom("exists")>;
+using explain_atom = atom_constant<atom("explain")>;
 using extract_atom = atom_constant<atom("extract")>;
 using historical_atom = atom_constant<atom("historical")>;
 using id_atom = atom_constant<atom("id")>;
@@ -74,6 +77,7 @@ using candidate_atom = atom_constant<atom("candidate")>;
 using controller_atom = atom_constant<atom("controller")>;
 using deflector_atom = atom_constant<atom("deflector")>;
 using identifier_atom = atom_constant<atom("identifier")>;
+using importer_atom = atom_constant<atom("importer")>;
 using index_atom = atom_constant<atom("index")>;
 using follower_atom = atom_constant<atom("follower")>;
 using leader_atom = atom_constant<atom("leader")>;
@@ -1,36 +1,92 @@
 #ifndef VAST_ACTOR_EXPORTER_HPP
 #define VAST_ACTOR_EXPORTER_HPP
 
+#include <map>
 #include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "vast/aggregation.hpp"
 #include "vast/aliases.hpp"
 #include "vast/bitstream.hpp"
 #include "vast/chunk.hpp"
+#include "vast/chunk_cache.hpp"
+#include "vast/event.hpp"
 #include "vast/expression.hpp"
+#include "vast/json.hpp"
+#include "vast/projection.hpp"
 #include "vast/query_options.hpp"
+#include "vast/time.hpp"
 #include "vast/uuid.hpp"
 #include "vast/actor/accountant.hpp"
 #include "vast/actor/archive.hpp"
 #include "vast/actor/basic_state.hpp"
+#include "vast/expr/checker.hpp"
 #include "vast/util/flat_set.hpp"
 
 namespace vast {
 
 /// Receives index hits, looks up the corresponding chunks in the archive, and
 /// filters out results which it then sends to a sink.
+///
+/// EXPORTER keeps a window of chunks ahead of the one it currently processes:
+/// as soon as a chunk arrives, it requests the chunk of the next unprocessed
+/// hit and hands the new chunk to a decoder, so that archive lookups and
+/// decompression overlap with candidate checking. EXPORTER processes the
+/// chunks in the window in ID order. If a chunk has many hits, EXPORTER
+/// splits them into contiguous ranges and has a checker per range perform
+/// the candidate checks in parallel. It then merges the results of the
+/// ranges in ID order, so that SINKs see the same results as with a
+/// sequential check. Decoders obtain the events of a chunk
+/// from a cache which all EXPORTERs of a node share. If the query comes with
+/// a projection, EXPORTER sends only the selected fields of each result. If
+/// it comes with an aggregation, EXPORTER aggregates the results instead and
+/// sends the aggregated rows at the end.
+/// When EXPORTER terminates, e.g., after having drained the requested number
+/// of results or having lost all SINKs, it tells INDEX to stop the lookup.
+///
+/// For *newest-first* queries, EXPORTER processes the chunks in descending ID
+/// order and retains the requested number of results with the youngest
+/// timestamps. It sends a retained result, newest first, as soon as INDEX
+/// reports that no pending hit can refer to a younger event.
+///
+/// For queries with the *explain* option, EXPORTER merges the explanations
+/// of INDEX with its own statistics and sends SINKs the result as JSON in
+/// `(uuid, explain_atom, std::string)` before the DONE message.
 struct exporter {
   using bitstream_type = decltype(chunk::meta_data::ids);
 
+  /// A chunk in the prefetch window.
+  struct slot {
+    /// Retrieves an event from the decoded chunk.
+    /// @param id The ID of the event to retrieve.
+    /// @returns The event with ID *id*.
+    /// @pre `decoded`
+    result<event> read(event_id id) const;
+
+    chunk chk;
+    event_id last;
+    bool decoded = false;
+    message events; // std::vector<event>
+  };
+
   struct state : basic_state {
     state(local_actor* self);
 
+    interned_expression query;
+    vast::projection projection;
+    std::shared_ptr<vast::aggregation> aggregation;
     util::flat_set<archive::type> archives;
     util::flat_set<actor> indexes;
     util::flat_set<actor> sinks;
     accountant::type accountant;
     bool draining = false;
     bool inflight = false;
+    bool newest_first = false;
+    bool explain = false;
+    size_t prefetch = 1;
+    size_t parallelism = 1;
     double progress = 0.0;
     uint64_t requested = 0;
     uint64_t total_hits = 0;
@@ -39,21 +95,45 @@ struct exporter {
     uint64_t chunk_candidates = 0;
     uint64_t chunk_results = 0;
     uint64_t chunk_events = 0;
+    uint64_t total_candidates = 0;
+    uint64_t total_positives = 0;
     bitstream_type hits;
     bitstream_type unprocessed;
-    std::unordered_map<type, expression> checkers;
-    std::unique_ptr<chunk::reader> reader;
-    chunk current_chunk;
+    std::unordered_map<type, expr::checker> checkers;
+    std::map<event_id, slot> window;
+    std::vector<std::vector<event>> ranges;
+    size_t pending_ranges = 0;
+    std::map<std::pair<time::point, event_id>, event> newest;
+    time::point horizon = time::duration::max();
+    std::shared_ptr<chunk_cache> cache;
+    json::array plans;
     uuid const id;
     time::moment start_time;
+    time::moment first_hit;
+    time::moment wait_start;
+    time::moment check_start;
+    time::extent chunk_wait = time::extent::zero();
+    time::extent total_wait = time::extent::zero();
+    time::extent index_time = time::extent::zero();
+    time::extent check_time = time::extent::zero();
   };
 
   /// Spawns an EXPORTER.
   /// @param self The actor handle.
   /// @param ast The AST of query.
   /// @param qos The query options.
+  /// @param prefetch The maximum number of chunks in the prefetch window.
+  /// @param parallelism The maximum number of checkers per chunk.
+  /// @param cache The cache of decoded chunks to share with other EXPORTERs.
+  /// @param proj The fields of the results to send to SINKs.
+  /// @param agg The aggregation of the results, or `nullptr` to send the
+  ///            results themselves.
+  /// @pre `prefetch > 0 && parallelism > 0 && cache != nullptr`
   static behavior make(stateful_actor<state>* self, expression expr,
-                       query_options opts);
+                       query_options opts, size_t prefetch,
+                       size_t parallelism,
+                       std::shared_ptr<chunk_cache> cache,
+                       projection proj, std::shared_ptr<aggregation> agg);
 };
 
 } // namespace vast
@@ -7,11 +7,13 @@
 #include "vast/event.hpp"
 #include "vast/actor/archive.hpp"
 #include "vast/actor/basic_state.hpp"
+#include "vast/expr/matcher.hpp"
 
 namespace vast {
 
 /// Receives chunks from SOURCEs, imbues them with an ID, and relays them to
-/// ARCHIVE and INDEX.
+/// ARCHIVE and INDEX. Continuous queries which INDEX registers get evaluated
+/// directly on the events passing through, and their hits go back to INDEX.
 struct importer {
   struct state : basic_state {
     state(event_based_actor* self);
@@ -21,6 +23,8 @@ struct importer {
     actor index;
     event_id got = 0;
     std::vector<event> batch;
+    expr::matcher matcher;
+    std::vector<interned_expression> queries; // Parallel to the matcher.
   };
 
   /// Spawns an IMPORTER.
@@ -4,10 +4,14 @@
 #include <list>
 #include <map>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "vast/bitstream.hpp"
 #include "vast/expression.hpp"
 #include "vast/filesystem.hpp"
+#include "vast/json.hpp"
+#include "vast/query_options.hpp"
 #include "vast/uuid.hpp"
 #include "vast/schema.hpp"
 #include "vast/time.hpp"
@@ -30,7 +34,9 @@ namespace vast {
 /// Arriving chunks get load-balanced across the set of active partitions. If a
 /// partition becomes full, it will get evicted and replaced with a new one.
 ///
-/// A query expression always comes with a sink actor receiving the hits. The
+/// A query expression always comes with a sink actor receiving the hits.
+/// Queries travel as interned expressions, so that INDEX and PARTITIONs key
+/// their state by identity rather than by comparing expression trees. The
 /// sink will receive messages in the following order:
 ///
 ///   (1) A task representing the progress of the evaluation
@@ -38,13 +44,36 @@ namespace vast {
 ///   (3) A DONE atom
 ///
 /// After receiving the DONE atom the sink will not receive any further hits.
-/// This sequence applies both to continuous and historical queries.
+/// This sequence applies both to continuous and historical queries. A sink
+/// which needs no further hits sends `(expression, disable_atom)` or
+/// terminates. Once a query has no more sinks, INDEX disables its continuous
+/// part and cancels its historical part: partitions waiting in the schedule
+/// no longer get loaded for it and partitions evaluating it skip their
+/// remaining lookups. A sink subscribing to a query during its cancellation
+/// waits until the cancelled query completes and then starts it anew. The
+/// same holds for a sink asking for a different order or explanation than
+/// the running historical query with the same expression.
+///
+/// A historical query with the *newest-first* option visits the partitions
+/// in descending order of their youngest event. After each partition, the
+/// sinks receive `(historical_atom, time::point)`: all hits for events with
+/// a timestamp after this point have been delivered.
+///
+/// For a historical query with the *explain* option, INDEX records which
+/// partitions it considers and how the query resolves against their types,
+/// and collects a description of the lookup from each partition. The sinks
+/// receive `(explain_atom, json)` right before the DONE atom.
+///
+/// IMPORTERs register themselves with the index to evaluate continuous queries
+/// on the events passing through, before they reach the bitmap indexes. Only
+/// in the absence of IMPORTERs do the active partitions evaluate continuous
+/// queries over their indexers.
 struct index {
   using bitstream_type = default_bitstream;
 
   struct schedule_state {
     uuid part;
-    util::flat_set<expression> queries;
+    util::flat_set<interned_expression> queries;
   };
 
   struct partition_state {
@@ -64,6 +93,12 @@ struct index {
     bitstream_type hits;
     actor task;
     std::map<actor_addr, uuid> parts;
+    bool cancelled = false;
+    bool newest_first = false;
+    bool explain = false;
+    json::object plan;
+    json::array lookups;
+    std::vector<std::pair<actor, query_options>> deferred;
   };
 
   struct query_state {
@@ -77,12 +112,13 @@ struct index {
 
     path dir;
     accountant::type accountant;
-    std::map<expression, query_state> queries;
+    std::unordered_map<interned_expression, query_state> queries;
     std::unordered_map<uuid, partition_state> partitions;
     std::list<schedule_state> schedule;
     util::cache<uuid, actor, util::mru> passive;
     std::vector<std::pair<uuid, actor>> active;
     size_t next_active = 0;
+    std::vector<actor> importers;
   };
 
   /// Spawns the index.
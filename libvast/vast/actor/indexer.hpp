@@ -1,6 +1,12 @@
 #ifndef VAST_ACTOR_INDEXER_HPP
 #define VAST_ACTOR_INDEXER_HPP
 
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
 #include <caf/all.hpp>
 
 #include "vast/bitmap_index_polymorphic.hpp"
@@ -11,54 +17,205 @@
 #include "vast/actor/atoms.hpp"
 #include "vast/actor/basic_state.hpp"
 #include "vast/concept/serializable/io.hpp"
+#include "vast/concept/serializable/std/pair.hpp"
+#include "vast/concept/serializable/std/vector.hpp"
 #include "vast/concept/serializable/vast/bitmap_index_polymorphic.hpp"
+#include "vast/concept/serializable/vast/data.hpp"
 #include "vast/concept/serializable/vast/type.hpp"
 #include "vast/util/assert.hpp"
 
 namespace vast {
+
+/// A contiguous array of values for a single bitmap index, each paired with
+/// the ID of the event it stems from.
+using indexer_column = std::vector<std::pair<data, event_id>>;
+
 namespace detail {
 
+// Identifies the snapshot files of bitmap indexers. The version changes
+// whenever the serialized layout of bitmap indexes changes, e.g., when
+// bitvectors began to write their blocks as raw little-endian words.
+constexpr uint32_t snapshot_magic = 0x56424d49; // "VBMI"
+constexpr uint32_t snapshot_version = 1;
+
 /// Wraps a bitmap index into an actor.
+///
+/// The indexer persists its bitmap index as a snapshot plus an append-only
+/// delta log. A regular flush appends only the values which arrived since the
+/// last flush to the log, so that flush I/O remains proportional to the number
+/// of new events. Loading replays the log on top of the snapshot. Sealing the
+/// indexer, or the log outgrowing the snapshot, compacts both into a new
+/// snapshot.
 template <typename BitmapIndex>
 struct bitmap_indexer {
+  using delta = indexer_column;
+
   struct state : basic_state {
     state(local_actor* self, std::string name)
       : basic_state{self, std::move(name)} {
     }
 
-    virtual bool push_back(BitmapIndex& bmi, event const& e) = 0;
+    /// Appends a value to the bitmap index and records it for the next flush.
+    /// @param x The value to append.
+    /// @param id The event ID of *x*.
+    /// @returns `true` on success.
+    bool append(data const& x, event_id id) {
+      if (!bmi.push_back(x, id))
+        return false;
+      delta_.emplace_back(x, id);
+      return true;
+    }
 
     vast::path path;
     BitmapIndex bmi;
     uint64_t last_flush_ = 0;
+    uint64_t last_snapshot_ = 0;
+    delta delta_;
   };
 
+  static path log_path(path const& p) {
+    return p.str() + ".log";
+  }
+
+  // Checks that a snapshot file has the format we can read, before we
+  // interpret its contents.
+  static trial<void> check_snapshot(path const& p) {
+    uint32_t magic = 0;
+    uint32_t version = 0;
+    auto t = load(p, magic, version);
+    if (!t)
+      return t;
+    if (magic != snapshot_magic)
+      return error{"not a bitmap index snapshot: ", p};
+    if (version != snapshot_version)
+      return error{"bitmap index format version mismatch in ", p,
+                   ": expected ", snapshot_version, ", got ", version};
+    return nothing;
+  }
+
+  // Appends one record to the delta log. Each record contains the index size
+  // at the time of the previous flush, so that replaying can skip records
+  // which a later snapshot already contains.
+  static trial<void> append_log(path const& log, uint64_t from,
+                                delta const& values) {
+    std::vector<uint8_t> record;
+    auto t = save(record, from, values);
+    if (!t)
+      return t;
+    std::vector<uint8_t> frame;
+    t = save(frame, record);
+    if (!t)
+      return t;
+    file f{log};
+    t = f.open(file::write_only, true);
+    if (!t)
+      return t;
+    if (!f.write(frame.data(), frame.size()))
+      return error{"failed to append to ", log};
+    return nothing;
+  }
+
+  // Replays the delta log on top of a bitmap index. A torn record at the end
+  // of the log, e.g., from a crash during flushing, gets ignored, whether
+  // the log ends inside its length prefix or inside its body.
+  static trial<void> replay_log(path const& log, BitmapIndex& bmi) {
+    auto contents = load_contents(log);
+    if (!contents)
+      return contents.error();
+    auto source = io::make_array_input_stream(*contents);
+    binary_deserializer d{source};
+    while (d.bytes() < contents->size()) {
+      auto start = d.bytes();
+      std::vector<uint8_t> record;
+      d >> record;
+      // An unreadable length prefix leaves the position unchanged, and a
+      // truncated body extends beyond the end of the log.
+      if (d.bytes() == start || d.bytes() > contents->size())
+        break;
+      uint64_t from = 0;
+      delta values;
+      auto record_source = io::make_array_input_stream(record);
+      binary_deserializer rd{record_source};
+      rd >> from >> values;
+      if (rd.bytes() != record.size())
+        return error{"corrupt delta log record at offset ", start};
+      if (from < bmi.size())
+        continue;
+      for (auto& v : values)
+        if (!bmi.push_back(v.first, v.second))
+          return error{"failed to replay value ", v.first};
+    }
+    return nothing;
+  }
+
   template <typename State>
   static behavior make(stateful_actor<State>* self, path p, BitmapIndex bmi) {
     self->state.path = std::move(p);
     self->state.bmi = std::move(bmi);
     self->trap_exit(true);
-    // Materialize an existing index.
+    // Map an existing index into memory. Its bitstreams reference the mapped
+    // file until new events arrive.
     if (exists(self->state.path)) {
-      auto t = load(self->state.path, self->state.last_flush_,
-                    self->state.bmi);
+      uint32_t magic;
+      uint32_t version;
+      auto t = check_snapshot(self->state.path);
+      if (t)
+        t = load_mapped(self->state.path, magic, version,
+                        self->state.last_flush_, self->state.bmi);
       if (!t) {
-        VAST_ERROR_AT(self, "failed to load bitmap index");
+        VAST_ERROR_AT(self, "failed to load bitmap index:", t.error());
         self->quit(exit::error);
         return {};
       }
+      self->state.last_snapshot_ = self->state.last_flush_;
       VAST_DEBUG_AT(self, "loaded bitmap index of size",
                     self->state.bmi.size());
     }
+    auto log = log_path(self->state.path);
+    if (exists(log)) {
+      auto t = replay_log(log, self->state.bmi);
+      if (!t) {
+        VAST_ERROR_AT(self, "failed to replay delta log:", t.error());
+        self->quit(exit::error);
+        return {};
+      }
+      self->state.last_flush_ = self->state.bmi.size();
+      VAST_DEBUG_AT(self, "replayed delta log up to size",
+                    self->state.bmi.size());
+    }
     // Flush bitmap index to disk.
-    auto flush = [=] {
-      if (self->state.bmi.size() == self->state.last_flush_)
+    auto flush = [=](bool seal) -> trial<void> {
+      auto& st = self->state;
+      auto size = st.bmi.size();
+      if (size == st.last_flush_ && (!seal || size == st.last_snapshot_))
         return nothing;
-      VAST_DEBUG_AT(self, "flushes bitmap index",
-                    "(" << (self->state.bmi.size() - self->state.last_flush_)
-                      << '/' << self->state.bmi.size(), "new/total bits)");
-      self->state.last_flush_ = self->state.bmi.size();
-      return save(self->state.path, self->state.last_flush_, self->state.bmi);
+      // Compacting whenever the log outgrows the snapshot keeps the total
+      // write volume linear in the number of events.
+      if (seal || size - st.last_snapshot_ > st.last_snapshot_) {
+        VAST_DEBUG_AT(self, "compacts bitmap index of size", size);
+        // Bitstreams may still reference the mapped index file, so we must
+        // not overwrite it in place but replace it atomically.
+        auto tmp = path{st.path.str() + ".tmp"};
+        auto t = save(tmp, snapshot_magic, snapshot_version, size, st.bmi);
+        if (!t)
+          return t;
+        if (!mv(tmp, st.path))
+          return error{"failed to replace ", st.path};
+        if (exists(log) && !rm(log))
+          return error{"failed to remove ", log};
+        st.last_snapshot_ = size;
+      } else {
+        VAST_DEBUG_AT(self, "appends", st.delta_.size(),
+                      "values to delta log",
+                      "(" << (size - st.last_flush_) << '/' << size,
+                      "new/total bits)");
+        auto t = append_log(log, st.last_flush_, st.delta_);
+        if (!t)
+          return t;
+      }
+      st.last_flush_ = size;
+      st.delta_.clear();
+      return nothing;
     };
     return {
       [=](exit_msg const& msg) {
@@ -66,45 +223,56 @@ struct bitmap_indexer {
           self->quit(exit::kill);
           return;
         }
-        auto t = flush();
+        auto t = flush(true);
         if (!t)
           VAST_ERROR_AT(self, "failed to flush:", t.error());
         self->quit(msg.reason);
       },
       [=](flush_atom, actor const& task) {
-        auto t = flush();
+        auto t = flush(false);
         self->send(task, done_atom::value);
         if (!t) {
           VAST_ERROR_AT(self, "failed to flush:", t.error());
           self->quit(exit::error);
         }
       },
-      [=](std::vector<event> const& events, actor const& task) {
-        VAST_DEBUG_AT(self, "got", events.size(), "events");
-        for (auto& e : events)
-          if (e.id() == invalid_event_id) {
-            VAST_ERROR_AT(self, "ignores event with invalid ID:", e);
-          } else if (!self->state.push_back(self->state.bmi, e)) {
-            VAST_ERROR_AT(self, "failed to append event", e);
+      [=](indexer_column const& column, actor const& task) {
+        VAST_DEBUG_AT(self, "got", column.size(), "values");
+        for (auto& x : column)
+          if (x.second == invalid_event_id) {
+            VAST_ERROR_AT(self, "ignores value with invalid ID:", x.first);
+          } else if (!self->state.append(x.first, x.second)) {
+            VAST_ERROR_AT(self, "failed to append value", x.first);
             self->quit(exit::error);
             return;
           }
         self->send(task, done_atom::value);
       },
-      [=](expression const& pred, actor const& sink, actor const& task) {
+      [=](interned_predicate const& pred, actor const& sink,
+          actor const& task) {
         VAST_DEBUG_AT(self, "looks up predicate:", pred);
-        auto p = get<predicate>(pred);
-        VAST_ASSERT(p);
-        auto d = get<data>(p->rhs);
+        auto d = get<data>(pred->rhs);
         VAST_ASSERT(d);
-        auto r = self->state.bmi.lookup(p->op, *d);
+        auto r = self->state.bmi.lookup(pred->op, *d);
         if (r) {
           self->send(sink, pred, std::move(*r));
         } else {
           VAST_ERROR_AT(self, "failed to lookup:", pred,
                         '(' << r.error() << ')');
+          // The sink may count on our reply.
+          self->send(sink, pred, typename BitmapIndex::bitstream_type{});
           self->quit(exit::error);
         }
+        if (task)
+          self->send(task, done_atom::value);
+      },
+      [=](estimate_atom, interned_predicate const& pred, actor const& sink,
+          actor const& task) {
+        auto d = get<data>(pred->rhs);
+        VAST_ASSERT(d);
+        auto n = self->state.bmi.estimate(pred->op, *d);
+        VAST_DEBUG_AT(self, "estimates", n, "hits for predicate:", pred);
+        self->send(sink, estimate_atom::value, pred, n);
         self->send(task, done_atom::value);
       }
     };
@@ -120,10 +288,6 @@ struct event_name_state
     : bitmap_indexer<bitmap_index_type>::state {
         self, "event-name-indexer"} {
   }
-
-  bool push_back(bitmap_index_type& bmi, event const& e) override {
-    return bmi.push_back(e.type().name(), e.id());
-  }
 };
 
 template <typename Bitstream>
@@ -135,17 +299,13 @@ behavior event_name_indexer(stateful_actor<event_name_state<Bitstream>>* self,
 
 template <typename Bitstream>
 struct event_time_state
-  : bitmap_indexer<arithmetic_bitmap_index<Bitstream, time::point>>::state {
-  using bitmap_index_type = arithmetic_bitmap_index<Bitstream, time::point>;
+  : bitmap_indexer<time_bitmap_index<Bitstream>>::state {
+  using bitmap_index_type = time_bitmap_index<Bitstream>;
 
   event_time_state(local_actor* self)
     : bitmap_indexer<bitmap_index_type>::state {
         self, "event-time-indexer"} {
   }
-
-  bool push_back(bitmap_index_type& bmi, event const& e) override {
-    return bmi.push_back(e.timestamp(), e.id());
-  }
 };
 
 template <typename Bitstream>
@@ -160,48 +320,21 @@ struct event_data_state : bitmap_indexer<BitmapIndex>::state {
   event_data_state(local_actor* self)
     : bitmap_indexer<BitmapIndex>::state{self, "event-data-indexer"} {
   }
-
-  bool push_back(BitmapIndex& bmi, event const& e) override {
-    // Because chunks may contain events of different types, we may end up with
-    // an event that's not intended for us. self is not an error but rather
-    // occurrs by design: the events from a single chunk arrive at multiple
-    // indexers, each of which pick their relevant subset.
-    if (e.type() != event_type)
-      return true;
-    auto r = get<record>(e);
-    if (!r)
-      return bmi.push_back(e.data(), e.id());
-    if (auto d = r->at(offset))
-      return bmi.push_back(*d, e.id());
-    // If there is no data at a given offset, it means that an intermediate
-    // record is nil but we're trying to access a deeper field.
-    return bmi.push_back(nil, e.id());
-  }
-
-  type event_type;
-  vast::offset offset;
 };
 
 template <typename Bitstream>
 struct event_data_indexer_factory {
-  event_data_indexer_factory(path const& p, offset const& o, type const& t)
-    : dir_{p},
-      off_{o},
-      event_type_{t} {
+  event_data_indexer_factory(path const& p) : dir_{p} {
   }
 
   template <typename BitmapIndex, typename... Ts>
   actor make(Ts&&... xs) const {
     using state_type = event_data_state<BitmapIndex>;
     static auto indexer = [](stateful_actor<state_type>* self, path const& dir,
-                             type const& event_type, offset const& off,
                              BitmapIndex bmi) -> behavior {
-      self->state.offset = off;
-      self->state.event_type = event_type;
       return bitmap_indexer<BitmapIndex>::make(self, dir, std::move(bmi));
     };
-    return spawn(indexer, dir_, event_type_, off_,
-                 BitmapIndex{std::forward<Ts>(xs)...});
+    return spawn(indexer, dir_, BitmapIndex{std::forward<Ts>(xs)...});
   }
 
   template <typename T>
@@ -221,7 +354,9 @@ struct event_data_indexer_factory {
     return make<port_bitmap_index<Bitstream>>();
   }
 
-  actor operator()(type::string const&) const {
+  actor operator()(type::string const& t) const {
+    if (has_dictionary_index(t))
+      return make<dictionary_bitmap_index<Bitstream>>();
     return make<string_bitmap_index<Bitstream>>();
   }
 
@@ -242,11 +377,11 @@ struct event_data_indexer_factory {
   }
 
   actor operator()(type::pattern const&) const {
-    die("regular expressions not yet supported");
+    return make<dictionary_bitmap_index<Bitstream>>();
   }
 
-  actor operator()(type::table const&) const {
-    die("tables not yet supported");
+  actor operator()(type::table const& t) const {
+    return make<table_bitmap_index<Bitstream>>(t.key());
   }
 
   actor operator()(type::record const&) const {
@@ -258,19 +393,115 @@ struct event_data_indexer_factory {
   }
 
   path const& dir_;
-  offset const& off_;
-  type const& event_type_;
 };
 
 template <typename Bitstream>
-actor spawn_data_bitmap_indexer(type const& data_type,
-                                path const& dir,
-                                offset const& off,
-                                type const& event_type) {
-  return visit(event_data_indexer_factory<Bitstream>{dir, off, event_type},
-               data_type);
+actor spawn_data_bitmap_indexer(type const& data_type, path const& dir) {
+  return visit(event_data_indexer_factory<Bitstream>{dir}, data_type);
 }
 
+// Collects pointers to the leaves of a record value in the order of
+// type::record::each, in a single traversal. Leaves below a nil record are
+// nullptr.
+inline void flatten(type::record const& t, record const* r,
+                    std::vector<data const*>& leaves) {
+  auto& fields = t.fields();
+  for (size_t i = 0; i < fields.size(); ++i) {
+    auto x = r && i < r->size() ? &(*r)[i] : nullptr;
+    if (auto nested = get<type::record>(fields[i].type))
+      flatten(*nested, x ? get<record>(*x) : nullptr, leaves);
+    else
+      leaves.push_back(x);
+  }
+}
+
+// The INDEXERs of an EVENT-INDEXER which can answer a predicate.
+struct indexer_targets {
+  size_t size() const {
+    return name + time + data.size();
+  }
+
+  bool name = false;
+  bool time = false;
+  std::vector<offset> data;
+};
+
+// Determines the INDEXERs of an EVENT-INDEXER which can answer a predicate.
+// Since this is a pure function of the event type, it also allows for routing
+// predicates before sending them to an EVENT-INDEXER.
+struct indexer_router {
+  indexer_router(type const& event_type) : event_type_{event_type} {
+  }
+
+  template <typename T>
+  indexer_targets operator()(T const&) {
+    return {};
+  }
+
+  template <typename T, typename U>
+  indexer_targets operator()(T const&, U const&) {
+    return {};
+  }
+
+  indexer_targets operator()(predicate const& p) {
+    op_ = p.op;
+    return visit(*this, p.lhs, p.rhs);
+  }
+
+  indexer_targets operator()(event_extractor const&, data const&) {
+    indexer_targets result;
+    result.name = true;
+    return result;
+  }
+
+  indexer_targets operator()(time_extractor const&, data const&) {
+    indexer_targets result;
+    result.time = true;
+    return result;
+  }
+
+  indexer_targets operator()(type_extractor const& e, data const&) {
+    indexer_targets result;
+    if (auto r = get<type::record>(event_type_)) {
+      for (auto& i : type::record::each{*r})
+        if (i.trace.back()->type == e.type)
+          result.data.push_back(i.offset);
+    } else if (event_type_ == e.type) {
+      result.data.emplace_back();
+    }
+    return result;
+  }
+
+  indexer_targets operator()(schema_extractor const& e, data const& d) {
+    indexer_targets result;
+    if (auto r = get<type::record>(event_type_)) {
+      for (auto& pair : r->find_suffix(e.key)) {
+        auto& o = pair.first;
+        auto lhs = r->at(o);
+        VAST_ASSERT(lhs);
+        if (!compatible(*lhs, op_, type::derive(d))) {
+          VAST_WARN("encountered type clash: LHS =", *lhs, "<=> RHS =",
+                    type::derive(d));
+          return {};
+        }
+        result.data.push_back(o);
+      }
+    } else if (e.key.size() == 1) {
+      if (pattern::glob(e.key[0]).match(event_type_.name()))
+        result.data.emplace_back();
+    }
+    return result;
+  }
+
+  template <typename T>
+  indexer_targets operator()(data const& d, T const& e) {
+    return (*this)(e, d);
+  }
+
+  type const& event_type_;
+  relational_operator op_;
+};
+
 } // namespace detail
 
 /// Indexes events of a fixed type.
@@ -325,8 +556,9 @@ struct event_indexer {
           t = x;
         else
           return error{"invalid offset for event ", event_type.name(), ": ", o};
-        a = detail::spawn_data_bitmap_indexer<Bitstream>(*t, p, o, event_type);
+        a = detail::spawn_data_bitmap_indexer<Bitstream>(*t, p);
         self->monitor(a);
+        data_indexers[o] = a;
       }
       return a;
     };
@@ -357,96 +589,41 @@ struct event_indexer {
 
     path dir;
     type event_type;
+    std::vector<offset> leaves;
     std::map<path, actor> indexers;
+    std::map<offset, actor> data_indexers;
+    // Continuous lookups in flight, per INDEXER and in request order.
+    std::map<actor_addr, std::deque<std::pair<interned_predicate, actor>>>
+      continuous;
   };
 
+  // Spawns the INDEXERs which can answer a predicate and counts the targets
+  // it failed to spawn.
   struct loader {
     loader(state& s) : state_{s} { }
 
-    template <typename T>
-    std::vector<actor> operator()(T const&) {
-      return {};
-    }
-
-    template <typename T, typename U>
-    std::vector<actor> operator()(T const&, U const&) {
-      return {};
-    }
-
     std::vector<actor> operator()(predicate const& p) {
-      op_ = p.op;
-      return visit(*this, p.lhs, p.rhs);
-    }
-
-    std::vector<actor> operator()(event_extractor const&, data const&) {
-      return {state_.spawn_name_indexer()};
-    }
-
-    std::vector<actor> operator()(time_extractor const&, data const&) {
-      return {state_.spawn_time_indexer()};
-    }
-
-    std::vector<actor> operator()(type_extractor const& e, data const&) {
+      auto targets = detail::indexer_router{state_.event_type}(p);
       std::vector<actor> result;
-      if (auto r = get<type::record>(state_.event_type)) {
-        for (auto& i : type::record::each{*r})
-          if (i.trace.back()->type == e.type) {
-            auto a = state_.spawn_data_indexer(i.offset);
-            if (a) {
-              result.push_back(std::move(*a));
-            } else {
-              VAST_ERROR(a.error());
-              return {};
-            }
-          }
-      } else if (state_.event_type == e.type) {
-        auto a = state_.spawn_data_indexer({});
-        if (a)
+      result.reserve(targets.size());
+      if (targets.name)
+        result.push_back(state_.spawn_name_indexer());
+      if (targets.time)
+        result.push_back(state_.spawn_time_indexer());
+      for (auto& o : targets.data) {
+        auto a = state_.spawn_data_indexer(o);
+        if (a) {
           result.push_back(std::move(*a));
-        else
+        } else {
           VAST_ERROR(a.error());
-      }
-      return result;
-    }
-
-    std::vector<actor> operator()(schema_extractor const& e,
-                                       data const& d) {
-      std::vector<actor> result;
-      if (auto r = get<type::record>(state_.event_type)) {
-        for (auto& pair : r->find_suffix(e.key)) {
-          auto& o = pair.first;
-          auto lhs = r->at(o);
-          VAST_ASSERT(lhs);
-          if (!compatible(*lhs, op_, type::derive(d))) {
-            VAST_WARN_AT(state_.self, "encountered type clash: LHS =",
-                         *lhs, "<=> RHS =", type::derive(d));
-            return {};
-          }
-          auto a = state_.spawn_data_indexer(o);
-          if (!a)
-            VAST_ERROR(a.error());
-          else
-            result.push_back(std::move(*a));
-        }
-      } else if (e.key.size() == 1) {
-        if (pattern::glob(e.key[0]).match(state_.event_type.name())) {
-          auto a = state_.spawn_data_indexer({});
-          if (a)
-            result.push_back(std::move(*a));
-          else
-            VAST_ERROR(a.error());
+          ++failed;
         }
       }
       return result;
     }
 
-    template <typename T>
-    std::vector<actor> operator()(data const& d, T const& e) {
-      return (*this)(e, d);
-    }
-
-    relational_operator op_;
     state& state_;
+    size_t failed = 0;
   };
 
   /// Spawns an event indexer.
@@ -455,18 +632,34 @@ struct event_indexer {
   static behavior make(stateful_actor<state>* self, path dir, type event_type) {
     self->state.dir = std::move(dir);
     self->state.event_type = std::move(event_type);
+    if (auto r = get<type::record>(self->state.event_type))
+      for (auto& i : type::record::each{*r})
+        self->state.leaves.push_back(i.offset);
     self->trap_exit(true);
     // If the directory doesn't exist yet, we're in "construction" mode,
     // spawning all bitmap indexer to be able to handle new events directly.
     // Otherwise we just load the indexers specified in the query.
     if (!exists(self->state.dir))
       self->state.spawn_bitmap_indexers();
+    // Removes a terminated INDEXER and answers the continuous lookups it will
+    // never reply to, because their sinks count the replies.
     auto remove_indexer = [=](actor_addr const& a) {
+      auto c = self->state.continuous.find(a);
+      if (c != self->state.continuous.end()) {
+        for (auto& pending : c->second)
+          self->send(pending.second, pending.first, Bitstream{});
+        self->state.continuous.erase(c);
+      }
       auto i = std::find_if(self->state.indexers.begin(),
                             self->state.indexers.end(),
                             [=](auto& pair) { return pair.second == a; });
       if (i != self->state.indexers.end())
         self->state.indexers.erase(i);
+      auto j = std::find_if(self->state.data_indexers.begin(),
+                            self->state.data_indexers.end(),
+                            [=](auto& pair) { return pair.second == a; });
+      if (j != self->state.data_indexers.end())
+        self->state.data_indexers.erase(j);
     };
     return {
       [=](exit_msg const& msg) {
@@ -490,11 +683,62 @@ struct event_indexer {
         self->state.spawn_bitmap_indexers();
         VAST_DEBUG_AT(self, "spawned", self->state.indexers.size(), "indexers");
       },
-      [=](std::vector<event> const&, actor const& task) {
-        for (auto& i : self->state.indexers) {
-          self->send(task, i.second);
-          self->send(i.second, self->current_message());
+      [=](std::vector<event> const& events, actor const& task) {
+        auto& st = self->state;
+        auto name = st.indexers.find(st.dir / "meta" / "name");
+        auto time = st.indexers.find(st.dir / "meta" / "time");
+        // Locate the leaf of each data indexer in a flattened record.
+        std::vector<size_t> positions;
+        std::vector<actor> data_indexers;
+        for (auto& x : st.data_indexers) {
+          auto i = std::find(st.leaves.begin(), st.leaves.end(), x.first);
+          positions.push_back(i - st.leaves.begin());
+          data_indexers.push_back(x.second);
         }
+        // Filter the batch and split it into one column per bitmap indexer in
+        // a single pass, instead of having each indexer sift through all
+        // events on its own.
+        indexer_column names;
+        indexer_column times;
+        std::vector<indexer_column> columns(data_indexers.size());
+        auto r = get<type::record>(st.event_type);
+        std::vector<data const*> leaves;
+        for (auto& e : events) {
+          if (e.type() != st.event_type)
+            continue;
+          if (name != st.indexers.end())
+            names.emplace_back(e.type().name(), e.id());
+          if (time != st.indexers.end())
+            times.emplace_back(e.timestamp(), e.id());
+          if (columns.empty())
+            continue;
+          if (!r) {
+            columns[0].emplace_back(e.data(), e.id());
+            continue;
+          }
+          leaves.clear();
+          detail::flatten(*r, get<record>(e), leaves);
+          for (size_t i = 0; i < columns.size(); ++i) {
+            auto leaf = positions[i] < leaves.size() ? leaves[positions[i]]
+                                                     : nullptr;
+            // If there is no leaf, an intermediate record is nil.
+            columns[i].emplace_back(leaf ? *leaf : data{nil}, e.id());
+          }
+        }
+        // Each bitmap indexer builds its part of the index concurrently on the
+        // scheduler's worker threads.
+        auto relay = [&](actor const& indexer, indexer_column& column) {
+          if (column.empty())
+            return;
+          self->send(task, indexer);
+          self->send(indexer, std::move(column), task);
+        };
+        if (name != st.indexers.end())
+          relay(name->second, names);
+        if (time != st.indexers.end())
+          relay(time->second, times);
+        for (size_t i = 0; i < columns.size(); ++i)
+          relay(data_indexers[i], columns[i]);
         self->send(task, done_atom::value);
       },
       [=](flush_atom, actor const& task) {
@@ -505,13 +749,45 @@ struct event_indexer {
         }
         self->send(task, done_atom::value);
       },
-      [=](expression const& pred, actor const&, actor const& task) {
-        auto p = get<predicate>(pred);
-        VAST_ASSERT(p);
-        auto indexers = loader{self->state}(*p);
+      [=](interned_predicate const& pred, actor const& sink,
+          actor const& task) {
+        loader load{self->state};
+        auto indexers = load(*pred);
         if (indexers.empty())
           VAST_DEBUG_AT(self, "did not find matching indexers for", pred);
+        if (task) {
+          for (auto& i : indexers) {
+            self->send(task, i);
+            self->send(i, self->current_message());
+          }
+          self->send(task, done_atom::value);
+          return;
+        }
+        // Continuous queries come without a task, because their sink knows
+        // how many replies to expect. We relay the replies so that the sink
+        // gets one per target, even if an INDEXER fails.
+        for (size_t i = 0; i < load.failed; ++i)
+          self->send(sink, pred, Bitstream{});
         for (auto& i : indexers) {
+          self->state.continuous[i.address()].emplace_back(pred, sink);
+          self->send(i, pred, self, actor{invalid_actor});
+        }
+      },
+      [=](interned_predicate const& pred, Bitstream& hits) {
+        auto c = self->state.continuous.find(self->current_sender());
+        if (c == self->state.continuous.end() || c->second.empty()) {
+          VAST_WARN_AT(self, "got unexpected hits for", pred);
+          return;
+        }
+        VAST_ASSERT(c->second.front().first == pred);
+        self->send(c->second.front().second, pred, std::move(hits));
+        c->second.pop_front();
+        if (c->second.empty())
+          self->state.continuous.erase(c);
+      },
+      [=](estimate_atom, interned_predicate const& pred, actor const&,
+          actor const& task) {
+        for (auto& i : loader{self->state}(*pred)) {
           self->send(task, i);
           self->send(i, self->current_message());
         }
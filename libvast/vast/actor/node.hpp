@@ -2,8 +2,10 @@
 #define VAST_ACTOR_NODE_HPP
 
 #include <map>
+#include <memory>
 #include <string>
 
+#include "vast/chunk_cache.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/trial.hpp"
 #include "vast/actor/basic_state.hpp"
@@ -31,6 +33,7 @@ struct node  {
     std::string desc;
     accountant::type accountant;
     actor store;
+    std::shared_ptr<chunk_cache> chunks;
   };
 
   /// Returns the path of the log directory relative to the base directory.
@@ -3,6 +3,8 @@
 
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <vector>
 #include "vast/expression.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/schema.hpp"
@@ -25,12 +27,26 @@ struct partition {
     actor task;
     bitstream_type hits;
     util::flat_set<event_id> cache;
-    util::flat_set<expression const*> queries;
+    util::flat_set<interned_expression> queries;
+    uint64_t estimate = 0;
+    util::flat_set<event_id> estimated;
   };
 
+  /// A historical query which is a conjunction proceeds in *stages*, one per
+  /// operand, ordered by the estimated number of hits. PARTITION dispatches
+  /// the next stage only if the stages so far still yield hits. A cancelled
+  /// query skips its remaining stages. If INDEX asks for an explanation of a
+  /// query, PARTITION reports the INDEXERs it contacted per predicate and the
+  /// hits after each operator once the lookup completes.
   struct query_state {
     actor task;
     bitstream_type hits;
+    std::vector<expression> stages;
+    size_t stage = 0;
+    bool explain = false;
+    size_t total_stages = 0;
+    size_t skipped_stages = 0;
+    std::unordered_map<interned_predicate, uint64_t> contacted;
   };
 
   struct state : basic_state {
@@ -41,8 +57,8 @@ struct partition {
     vast::schema schema;
     size_t pending_events = 0;
     std::multimap<event_id, actor> indexers;
-    std::map<expression, query_state> queries;
-    std::map<predicate, predicate_state> predicates;
+    std::unordered_map<interned_expression, query_state> queries;
+    std::unordered_map<interned_predicate, predicate_state> predicates;
   };
 
   /// Spawns a partition.
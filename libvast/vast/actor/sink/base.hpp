@@ -80,6 +80,9 @@ behavior make(stateful_actor<State>* self) {
       VAST_VERBOSE_AT(self, "got progress from query ", id << ':', total_hits,
                       "hits (" << size_t(progress * 100) << "%)");
     },
+    [=](uuid const& id, explain_atom, std::string const& plan) {
+      VAST_VERBOSE_AT(self, "got explanation of query", id << ':', plan);
+    },
     [=](uuid const& id, done_atom, time::extent runtime) {
       VAST_VERBOSE_AT(self, "got DONE from query", id << ", took", runtime);
     },
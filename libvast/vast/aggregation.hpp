@@ -0,0 +1,109 @@
+#ifndef VAST_AGGREGATION_HPP
+#define VAST_AGGREGATION_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "vast/data.hpp"
+#include "vast/key.hpp"
+#include "vast/offset.hpp"
+#include "vast/trial.hpp"
+#include "vast/type.hpp"
+#include "vast/util/variant.hpp"
+
+namespace vast {
+
+class event;
+
+/// Aggregates events into one row per group. An aggregation applies a
+/// function to a field of the events, grouped by the values of other fields,
+/// and keeps only the running state of each group in a hash table. Fields
+/// are key suffixes or offsets, as with ::projection. The textual form is
+///
+///     function [field] [by field...] [top k]
+///
+/// where *function* is one of `count`, `sum`, `min`, `max`, and `distinct`.
+/// All functions but `count` require a field. The function `distinct`
+/// counts the distinct values of its field. With `top k`, only the *k*
+/// groups with the largest aggregate remain. The first event type that has a
+/// field fixes its type in the result; events of types whose fields are not
+/// congruent to it do not contribute.
+class aggregation {
+public:
+  enum function_type { count, sum, min, max, distinct };
+
+  /// Parses an aggregation from its textual form.
+  /// @param str The string to parse.
+  /// @returns The aggregation described by *str*.
+  static trial<aggregation> parse(std::string const& str);
+
+  /// Constructs an aggregation which counts all events.
+  aggregation() = default;
+
+  /// Constructs an aggregation.
+  /// @param fun The aggregate function.
+  /// @param field The field to aggregate, ignored for `count`.
+  /// @param groups The fields to group by.
+  /// @param top The number of largest groups to keep; 0 keeps all.
+  aggregation(function_type fun, std::string field,
+              std::vector<std::string> groups, size_t top = 0);
+
+  /// Incorporates an event into its group.
+  /// @param e The event to aggregate.
+  void add(event const& e);
+
+  /// Retrieves the aggregated rows, ordered by group, or by descending
+  /// aggregate if the aggregation keeps only the top groups.
+  /// @returns One event of type `aggregate` per group.
+  std::vector<event> results() const;
+
+  /// Retrieves the number of groups.
+  /// @returns The number of groups.
+  size_t groups() const;
+
+private:
+  using field = util::variant<key, offset>;
+
+  struct column {
+    bool resolved = false;
+    offset off;
+    vast::type type;
+  };
+
+  struct plan {
+    bool congruent = true;
+    column value;
+    std::vector<column> groups;
+  };
+
+  struct group_state {
+    uint64_t events = 0;
+    data value;
+    std::unordered_set<data> values;
+  };
+
+  struct group_hash {
+    size_t operator()(vector const& xs) const;
+  };
+
+  static field make_field(std::string const& str);
+
+  plan const& lookup(type const& t);
+
+  function_type function_ = count;
+  std::vector<std::string> names_;
+  bool valued_ = false;
+  field value_;
+  std::vector<field> groups_;
+  size_t top_ = 0;
+  std::unordered_map<type, plan> plans_;
+  std::unordered_map<vector, group_state, group_hash> table_;
+  std::vector<vast::type> group_types_;
+  vast::type value_type_;
+};
+
+} // namespace vast
+
+#endif
@@ -61,7 +61,7 @@ public:
   /// @returns `true` on success and `false` if the bitmap is full, i.e., has
   ///          `std::numeric_limits<size_t>::max() - 1` elements.
   bool push_back(value_type x, size_t n = 1) {
-    return coder_.encode(order(binner_type::bin(x)), n);
+    return coder_.encode(transform(x), n);
   }
 
   /// Aritifically increases the bitmap size, i.e., the number of rows.
@@ -83,7 +83,7 @@ public:
   /// @param x The value to find the bitstream for.
   /// @returns The bitstream for all values *v* where *op(v,x)* is `true`.
   bitstream_type lookup(relational_operator op, value_type x) const {
-    return coder_.decode(op, order(binner_type::bin(x)));
+    return coder_.decode(op, transform(x));
   }
 
   /// Retrieves the bitmap size.
@@ -98,6 +98,14 @@ public:
     return size() == 0;
   }
 
+  /// Computes the value that the coder stores for a given value, i.e., the
+  /// binned value mapped into an unsigned domain that preserves its order.
+  /// @param x The value to transform.
+  /// @returns The coder representation of *x*.
+  static auto transform(value_type x) {
+    return order(binner_type::bin(x));
+  }
+
   /// Accesses the underlying coder of the bitmap.
   /// @returns The coder of this bitmap.
   coder_type const& coder() const {
@@ -1,15 +1,23 @@
 #ifndef VAST_BITMAP_INDEX_HPP
 #define VAST_BITMAP_INDEX_HPP
 
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
 #include "vast/bitmap.hpp"
 #include "vast/operator.hpp"
 #include "vast/maybe.hpp"
 #include "vast/trial.hpp"
 #include "vast/value.hpp"
+#include "vast/concept/printable/to_string.hpp"
 #include "vast/concept/printable/vast/data.hpp"
 #include "vast/concept/printable/vast/operator.hpp"
 #include "vast/util/assert.hpp"
 #include "vast/util/operators.hpp"
+#include "vast/util/hash/xxhash.hpp"
+#include "vast/util/hyperloglog.hpp"
 
 namespace vast {
 
@@ -19,6 +27,14 @@ template <typename>
 struct bitmap_index_model;
 }
 
+/// Summary statistics of a bitmap index which are cheap to obtain, i.e., do
+/// not require a lookup.
+struct bitmap_index_statistics {
+  uint64_t rows = 0;     ///< The number of rows.
+  uint64_t nils = 0;     ///< The number of rows with nil values.
+  uint64_t distinct = 0; ///< Estimated number of distinct values (0 = unknown).
+};
+
 /// The base class for bitmap indexes.
 template <typename Derived, typename Bitstream>
 class bitmap_index_base
@@ -99,6 +115,39 @@ public:
     return size() == 0;
   }
 
+  /// Retrieves summary statistics about the indexed values.
+  /// @returns The statistics of this bitmap index.
+  bitmap_index_statistics statistics() const {
+    bitmap_index_statistics stats;
+    stats.rows = mask_.count();
+    stats.nils = nil_.count();
+    stats.distinct = derived()->cardinality_impl();
+    return stats;
+  }
+
+  /// Estimates the number of rows a lookup would yield without performing
+  /// it. Indexes with per-value bins answer exactly, the others derive an
+  /// estimate from statistics() and err on the side of too many rows.
+  /// @param op The relation operator.
+  /// @param d The value to lookup.
+  /// @returns The estimated number of rows satisfying *op* with *d*.
+  uint64_t estimate(relational_operator op, data const& d) const {
+    auto stats = statistics();
+    if (is<none>(d))
+      return op == equal ? stats.nils : stats.rows - stats.nils;
+    if (auto n = derived()->estimate_impl(op, d))
+      return std::min(*n, stats.rows);
+    auto values = stats.rows - stats.nils;
+    if (stats.distinct == 0)
+      return stats.rows;
+    auto per_value = (values + stats.distinct - 1) / stats.distinct;
+    if (op == equal)
+      return per_value;
+    if (op == not_equal)
+      return stats.rows - std::min(per_value, stats.rows);
+    return stats.rows;
+  }
+
   /// Appends invalid bits to bring the bitmap index up to a given size. Given
   /// an ID of *n*, the function stretches the index up to size *n* with
   /// invalid bits.
@@ -125,11 +174,31 @@ private:
     return static_cast<Derived const*>(this);
   }
 
+  // Defaults for indexes which cannot provide statistics on their own.
+  uint64_t cardinality_impl() const {
+    return 0;
+  }
+
+  maybe<uint64_t> estimate_impl(relational_operator, data const&) const {
+    return {};
+  }
+
   Bitstream mask_;
   Bitstream nil_;
 };
 
-/// A bitmap index for arithmetic values.
+/// The coding an arithmetic bitmap index settles on after sampling its input.
+enum class arithmetic_coding : uint8_t {
+  undecided, ///< Still sampling values.
+  equality,  ///< One bitstream per distinct value.
+  range,     ///< Multi-level range coding with base 10 (singleton for bools).
+  bitslice   ///< One bitstream per bit, i.e., range coding with base 2.
+};
+
+/// A bitmap index for arithmetic values. The index buffers the first values it
+/// sees and then picks a coding based on the observed cardinality: equality
+/// coding for few distinct values, bit-slicing for mostly unique values, and
+/// multi-level range coding otherwise. Booleans always use a singleton coder.
 template <typename Bitstream, typename T, typename Binner = void>
 class arithmetic_bitmap_index
   : public bitmap_index_base<
@@ -185,19 +254,65 @@ class arithmetic_bitmap_index
   using bitmap_type =
     bitmap<bitmap_value_type, bitmap_coder, bitmap_binner>;
 
+  using bitslice_bitmap_type =
+    std::conditional_t<
+      std::is_same<T, boolean>{},
+      bitmap<uint8_t, bitslice_coder<Bitstream>>, // unused
+      bitmap<bitmap_value_type, bitslice_coder<Bitstream>, bitmap_binner>
+    >;
+
+  using key_type =
+    decltype(bitmap_type::transform(std::declval<bitmap_value_type>()));
+
+  using code_type = uint32_t;
+
+  using sample_type = std::vector<std::pair<uint64_t, bitmap_value_type>>;
+
+  // Avoids std::vector<bool>, which we cannot serialize.
+  using value_type =
+    std::conditional_t<std::is_same<T, boolean>{}, uint8_t, bitmap_value_type>;
+
 public:
   using bitstream_type = Bitstream;
 
+  /// The default number of values to sample before choosing a coding.
+  static constexpr size_t default_sample_size = 1024;
+
+  /// The maximum number of distinct sample values for equality coding.
+  static constexpr size_t max_equality_cardinality = 32;
+
+  /// The number of distinct values beyond which an equality-coded index
+  /// converts itself to range coding.
+  static constexpr size_t max_dictionary_size = 256;
+
   arithmetic_bitmap_index() = default;
 
+  /// Constructs an arithmetic bitmap index with a custom sample size.
+  /// @param sample_size The number of values to observe before settling on a
+  ///                    coding. A value of 0 selects range coding upfront.
+  explicit arithmetic_bitmap_index(size_t sample_size)
+    : sample_size_{sample_size} {
+    if (sample_size == 0)
+      coding_ = arithmetic_coding::range;
+  }
+
   friend bool operator==(arithmetic_bitmap_index const& x,
                          arithmetic_bitmap_index const& y) {
-    return x.bitmap_ == y.bitmap_;
+    return x.coding_ == y.coding_ && x.rows_ == y.rows_
+           && x.sample_ == y.sample_ && x.bitmap_ == y.bitmap_
+           && x.bitslice_ == y.bitslice_ && x.dictionary_ == y.dictionary_
+           && x.codes_ == y.codes_;
+  }
+
+  /// Retrieves the coding of the index.
+  /// @returns The coding chosen after sampling.
+  arithmetic_coding coding() const {
+    return coding_;
   }
 
 private:
   struct pusher {
-    pusher(bitmap_type& bm) : bm_{bm} {
+    pusher(arithmetic_bitmap_index& bmi) : bmi_{bmi} {
     }
 
     template <typename U>
@@ -206,7 +321,7 @@ private:
     }
 
     bool operator()(bitmap_value_type x) const {
-      return bm_.push_back(x);
+      return bmi_.push_value(x);
     }
 
     bool operator()(time::point x) const {
@@ -217,11 +332,12 @@ private:
       return (*this)(x.count());
     }
 
-    bitmap_type& bm_;
+    arithmetic_bitmap_index& bmi_;
   };
 
   struct looker {
-    looker(bitmap_type const& bm, relational_operator op) : bm_{bm}, op_{op} {
+    looker(arithmetic_bitmap_index const& bmi, relational_operator op)
+      : bmi_{bmi}, op_{op} {
     }
 
     template <typename U>
@@ -230,7 +346,7 @@ private:
     }
 
     trial<Bitstream> operator()(bitmap_value_type x) const {
-      return bm_.lookup(op_, x);
+      return bmi_.lookup_value(op_, x);
     }
 
     trial<Bitstream> operator()(time::point x) const {
@@ -241,39 +357,517 @@ private:
       return (*this)(x.count());
     }
 
-    bitmap_type const& bm_;
+    arithmetic_bitmap_index const& bmi_;
     relational_operator op_;
   };
 
+  struct estimator {
+    estimator(arithmetic_bitmap_index const& bmi, relational_operator op)
+      : bmi_{bmi}, op_{op} {
+    }
+
+    template <typename U>
+    maybe<uint64_t> operator()(U const&) const {
+      return {};
+    }
+
+    maybe<uint64_t> operator()(bitmap_value_type x) const {
+      return bmi_.estimate_value(op_, x);
+    }
+
+    maybe<uint64_t> operator()(time::point x) const {
+      return (*this)(x.time_since_epoch().count());
+    }
+
+    maybe<uint64_t> operator()(time::duration x) const {
+      return (*this)(x.count());
+    }
+
+    arithmetic_bitmap_index const& bmi_;
+    relational_operator op_;
+  };
+
+  template <typename Bitmap>
+  static bool replay(Bitmap& bm, sample_type const& xs, uint64_t rows) {
+    for (auto& x : xs)
+      if (!bm.stretch(x.first - bm.size()) || !bm.push_back(x.second))
+        return false;
+    return bm.stretch(rows - bm.size());
+  }
+
+  static bool compare(key_type x, relational_operator op, key_type y) {
+    switch (op) {
+      default:
+        return false;
+      case less:
+        return x < y;
+      case less_equal:
+        return x <= y;
+      case equal:
+        return x == y;
+      case not_equal:
+        return x != y;
+      case greater_equal:
+        return x >= y;
+      case greater:
+        return x > y;
+    }
+  }
+
+  // Counts the distinct keys among the sampled values.
+  size_t distinct_sample_keys() const {
+    std::vector<key_type> keys;
+    keys.reserve(sample_.size());
+    for (auto& x : sample_)
+      keys.push_back(bitmap_type::transform(x.second));
+    std::sort(keys.begin(), keys.end());
+    return std::unique(keys.begin(), keys.end()) - keys.begin();
+  }
+
+  // Picks a coding based on the cardinality of the sampled values and moves
+  // the sample into the chosen representation.
+  bool decide() {
+    auto distinct = distinct_sample_keys();
+    if (distinct <= max_equality_cardinality) {
+      coding_ = arithmetic_coding::equality;
+    } else if (distinct > sample_.size() / 2) {
+      coding_ = arithmetic_coding::bitslice;
+      bitslice_ = bitslice_bitmap_type{sizeof(key_type) * 8};
+    } else {
+      coding_ = arithmetic_coding::range;
+    }
+    auto xs = std::move(sample_);
+    sample_.clear();
+    auto rows = rows_;
+    rows_ = 0;
+    for (auto& x : xs)
+      if (!stretch_impl(x.first - size_impl()) || !push_value(x.second))
+        return false;
+    return stretch_impl(rows - size_impl());
+  }
+
+  // Converts an equality-coded index whose cardinality outgrew the
+  // dictionary into a range-coded one.
+  bool convert_to_range() {
+    VAST_ASSERT(coding_ == arithmetic_coding::equality);
+    sample_type xs;
+    for (auto& entry : dictionary_)
+      for (auto row : codes_[entry.second])
+        xs.emplace_back(row, values_[entry.second]);
+    std::sort(xs.begin(), xs.end(), [](auto& x, auto& y) {
+      return x.first < y.first;
+    });
+    auto rows = codes_.rows();
+    dictionary_.clear();
+    values_.clear();
+    codes_ = {};
+    coding_ = arithmetic_coding::range;
+    return replay(bitmap_, xs, rows);
+  }
+
+  bool push_value(bitmap_value_type x) {
+    switch (coding_) {
+      case arithmetic_coding::undecided:
+        sample_.emplace_back(rows_++, x);
+        return sample_.size() < sample_size_ || decide();
+      case arithmetic_coding::equality: {
+        auto key = bitmap_type::transform(x);
+        auto i = dictionary_.find(key);
+        if (i == dictionary_.end()) {
+          if (dictionary_.size() == max_dictionary_size)
+            return convert_to_range() && push_value(x);
+          auto code = static_cast<code_type>(values_.size());
+          i = dictionary_.emplace(key, code).first;
+          values_.push_back(x);
+          codes_.resize(values_.size());
+        }
+        return codes_.encode(i->second);
+      }
+      case arithmetic_coding::range:
+        return bitmap_.push_back(x);
+      case arithmetic_coding::bitslice:
+        return bitslice_.push_back(x);
+    }
+    return false;
+  }
+
+  trial<Bitstream> lookup_value(relational_operator op,
+                                bitmap_value_type x) const {
+    switch (coding_) {
+      case arithmetic_coding::undecided: {
+        bitmap_type bm;
+        if (!replay(bm, sample_, rows_))
+          return error{"failed to construct bitmap from sample"};
+        return bm.lookup(op, x);
+      }
+      case arithmetic_coding::equality: {
+        auto key = bitmap_type::transform(x);
+        if (op == not_equal) {
+          auto result = lookup_value(equal, x);
+          if (result)
+            result->flip();
+          return result;
+        }
+        Bitstream result{codes_.rows(), false};
+        for (auto& entry : dictionary_)
+          if (compare(entry.first, op, key))
+            result |= codes_[entry.second];
+        return std::move(result);
+      }
+      case arithmetic_coding::range:
+        return bitmap_.lookup(op, x);
+      case arithmetic_coding::bitslice:
+        return bitslice_.lookup(op, x);
+    }
+    return error{"invalid arithmetic coding"};
+  }
+
+  // While sampling and under equality coding, we know the frequency of every
+  // value and can thus count the matching rows exactly.
+  maybe<uint64_t> estimate_value(relational_operator op,
+                                 bitmap_value_type x) const {
+    auto key = bitmap_type::transform(x);
+    uint64_t n = 0;
+    switch (coding_) {
+      default:
+        return {};
+      case arithmetic_coding::undecided:
+        for (auto& y : sample_)
+          if (compare(bitmap_type::transform(y.second), op, key))
+            ++n;
+        return n;
+      case arithmetic_coding::equality:
+        for (auto& entry : dictionary_)
+          if (compare(entry.first, op, key))
+            n += codes_[entry.second].count();
+        return n;
+    }
+  }
+
   bool push_back_impl(data const& d) {
-    return visit(pusher{bitmap_}, d);
+    return visit(pusher{*this}, d);
   }
 
   bool push_back_impl(T x) {
-    return pusher{bitmap_}(x);
+    return pusher{*this}(x);
   }
 
   bool stretch_impl(size_t n) {
-    return bitmap_.stretch(n);
+    switch (coding_) {
+      case arithmetic_coding::undecided:
+        rows_ += n;
+        return true;
+      case arithmetic_coding::equality:
+        return codes_.stretch(n);
+      case arithmetic_coding::range:
+        return bitmap_.stretch(n);
+      case arithmetic_coding::bitslice:
+        return bitslice_.stretch(n);
+    }
+    return false;
   }
 
   trial<Bitstream> lookup_impl(relational_operator op, data const& d) const {
     if (op == in || op == not_in)
       return error{"unsupported relational operator: ", op};
-    return visit(looker{bitmap_, op}, d);
+    return visit(looker{*this, op}, d);
   };
 
   trial<Bitstream> lookup_impl(relational_operator op, T x) const {
     if (op == in || op == not_in)
       return error{"unsupported relational operator: ", op};
-    return looker{bitmap_, op}(x);
+    return looker{*this, op}(x);
   };
 
+  uint64_t cardinality_impl() const {
+    if (coding_ == arithmetic_coding::equality)
+      return dictionary_.size();
+    if (coding_ != arithmetic_coding::undecided)
+      return 0;
+    return distinct_sample_keys();
+  }
+
+  maybe<uint64_t> estimate_impl(relational_operator op, data const& d) const {
+    if (op == in || op == not_in)
+      return {};
+    return visit(estimator{*this, op}, d);
+  }
+
   uint64_t size_impl() const {
-    return bitmap_.size();
+    switch (coding_) {
+      case arithmetic_coding::undecided:
+        return rows_;
+      case arithmetic_coding::equality:
+        return codes_.rows();
+      case arithmetic_coding::range:
+        return bitmap_.size();
+      case arithmetic_coding::bitslice:
+        return bitslice_.size();
+    }
+    return 0;
   }
 
+  arithmetic_coding coding_ = std::is_same<T, boolean>{}
+    ? arithmetic_coding::range : arithmetic_coding::undecided;
+  uint64_t sample_size_ = default_sample_size;
+  uint64_t rows_ = 0;
+  sample_type sample_;
   bitmap_type bitmap_;
+  bitslice_bitmap_type bitslice_;
+  std::map<key_type, code_type> dictionary_;
+  std::vector<value_type> values_;
+  equality_coder<Bitstream> codes_;
+};
+
+namespace detail {
+
+/// Summarizes a block of consecutive values in a time_bitmap_index.
+struct time_block {
+  int64_t min;        ///< The smallest timestamp in the block.
+  int64_t max;        ///< The largest timestamp in the block.
+  uint64_t first_row; ///< The row of the first timestamp in the block.
+  uint64_t last_row;  ///< The row of the last timestamp in the block.
+  bool sorted;        ///< Whether the timestamps are in ascending order.
+
+  friend bool operator==(time_block const& x, time_block const& y) {
+    return x.min == y.min && x.max == y.max && x.first_row == y.first_row
+           && x.last_row == y.last_row && x.sorted == y.sorted;
+  }
+};
+
+} // namespace detail
+
+/// A bitmap index for timestamps which exploits that events arrive in nearly
+/// chronological order. The index stores the exact timestamps and summarizes
+/// each block of consecutive timestamps by its minimum and maximum, i.e., it
+/// maintains a zone map over the rows. A lookup accepts or rejects entire
+/// blocks by their bounds and only inspects the blocks which straddle the
+/// value: via binary search if the block is sorted, and via a scan otherwise.
+/// Lookups are therefore exact at nanosecond resolution.
+template <typename Bitstream>
+class time_bitmap_index
+  : public bitmap_index_base<time_bitmap_index<Bitstream>, Bitstream> {
+  using super = bitmap_index_base<time_bitmap_index<Bitstream>, Bitstream>;
+  friend super;
+  friend access;
+  template <typename>
+  friend struct detail::bitmap_index_model;
+
+public:
+  using bitstream_type = Bitstream;
+
+  /// The default number of timestamps per block.
+  static constexpr size_t default_block_size = 1024;
+
+  time_bitmap_index() = default;
+
+  /// Constructs a time bitmap index with a custom block size.
+  /// @param block_size The number of timestamps per block.
+  /// @pre `block_size > 0`
+  explicit time_bitmap_index(size_t block_size) : block_size_{block_size} {
+    VAST_ASSERT(block_size > 0);
+  }
+
+  friend bool operator==(time_bitmap_index const& x,
+                         time_bitmap_index const& y) {
+    return x.block_size_ == y.block_size_ && x.values_ == y.values_
+           && x.blocks_ == y.blocks_ && x.rows_ == y.rows_;
+  }
+
+private:
+  static bool compare(int64_t x, relational_operator op, int64_t y) {
+    switch (op) {
+      default:
+        return false;
+      case less:
+        return x < y;
+      case less_equal:
+        return x <= y;
+      case equal:
+        return x == y;
+      case not_equal:
+        return x != y;
+      case greater_equal:
+        return x >= y;
+      case greater:
+        return x > y;
+    }
+  }
+
+  size_t block_length(size_t i) const {
+    return std::min<size_t>(block_size_, values_.size() - i * block_size_);
+  }
+
+  // Invokes f(i, first, last) for each non-empty range [first, last) of
+  // timestamps in block i which satisfy *op* with respect to *x*.
+  template <typename F>
+  void each_run(relational_operator op, int64_t x, F f) const {
+    for (size_t i = 0; i < blocks_.size(); ++i) {
+      auto& b = blocks_[i];
+      auto n = block_length(i);
+      auto begin = values_.begin() + i * block_size_;
+      auto end = begin + n;
+      auto run = [&](size_t first, size_t last) {
+        if (first < last)
+          f(i, first, last);
+      };
+      if (op == equal || op == not_equal) {
+        auto outside = x < b.min || x > b.max;
+        if (outside || b.min == b.max) {
+          if (outside == (op == not_equal))
+            run(0, n);
+          continue;
+        }
+      } else {
+        // The remaining operators are monotone, so the bounds decide if no
+        // or all timestamps of the block qualify.
+        auto lo = compare(b.min, op, x);
+        auto hi = compare(b.max, op, x);
+        if (lo && hi)
+          run(0, n);
+        if (lo == hi)
+          continue;
+      }
+      if (b.sorted) {
+        size_t first = std::lower_bound(begin, end, x) - begin;
+        size_t last = std::upper_bound(begin, end, x) - begin;
+        switch (op) {
+          default:
+            break;
+          case less:
+            run(0, first);
+            break;
+          case less_equal:
+            run(0, last);
+            break;
+          case equal:
+            run(first, last);
+            break;
+          case not_equal:
+            run(0, first);
+            run(last, n);
+            break;
+          case greater_equal:
+            run(first, n);
+            break;
+          case greater:
+            run(last, n);
+            break;
+        }
+      } else {
+        size_t j = 0;
+        while (j < n) {
+          while (j < n && !compare(begin[j], op, x))
+            ++j;
+          auto k = j;
+          while (k < n && compare(begin[k], op, x))
+            ++k;
+          run(j, k);
+          j = k;
+        }
+      }
+    }
+  }
+
+  bool push_value(int64_t x) {
+    auto row = rows_.size();
+    if (values_.size() % block_size_ == 0) {
+      blocks_.push_back({x, x, row, row, true});
+    } else {
+      auto& b = blocks_.back();
+      b.sorted = b.sorted && values_.back() <= x;
+      b.min = std::min(b.min, x);
+      b.max = std::max(b.max, x);
+      b.last_row = row;
+    }
+    values_.push_back(x);
+    return rows_.push_back(true);
+  }
+
+  bool push_back_impl(time::point x) {
+    return push_value(x.time_since_epoch().count());
+  }
+
+  bool push_back_impl(data const& d) {
+    auto t = get<time::point>(d);
+    return t && push_back_impl(*t);
+  }
+
+  bool stretch_impl(size_t n) {
+    return rows_.append(n, false);
+  }
+
+  static bool supports(relational_operator op) {
+    switch (op) {
+      default:
+        return false;
+      case less:
+      case less_equal:
+      case equal:
+      case not_equal:
+      case greater_equal:
+      case greater:
+        return true;
+    }
+  }
+
+  trial<Bitstream> lookup_impl(relational_operator op, time::point x) const {
+    if (!supports(op))
+      return error{"unsupported relational operator: ", op};
+    Bitstream result;
+    std::vector<uint64_t> rows;
+    auto rows_block = blocks_.size();
+    each_run(op, x.time_since_epoch().count(),
+             [&](size_t i, size_t first, size_t last) {
+      auto& b = blocks_[i];
+      auto n = block_length(i);
+      if (b.last_row - b.first_row + 1 == n) {
+        // The rows of the block have no gaps.
+        auto row = b.first_row + first;
+        result.append(row - result.size(), false);
+        result.append(last - first, true);
+        return;
+      }
+      if (rows_block != i) {
+        rows.clear();
+        for (auto r = b.first_row; rows.size() < n; r = rows_.find_next(r))
+          rows.push_back(r);
+        rows_block = i;
+      }
+      for (auto j = first; j < last; ++j) {
+        result.append(rows[j] - result.size(), false);
+        result.push_back(true);
+      }
+    });
+    result.append(rows_.size() - result.size(), false);
+    return std::move(result);
+  }
+
+  trial<Bitstream> lookup_impl(relational_operator op, data const& d) const {
+    if (auto t = get<time::point>(d))
+      return lookup_impl(op, *t);
+    return error{"not a time point: ", d};
+  }
+
+  // The zone map yields the exact number of hits without materializing them.
+  maybe<uint64_t> estimate_impl(relational_operator op, data const& d) const {
+    auto t = get<time::point>(d);
+    if (!t || !supports(op))
+      return {};
+    uint64_t n = 0;
+    each_run(op, t->time_since_epoch().count(),
+             [&](size_t, size_t first, size_t last) { n += last - first; });
+    return n;
+  }
+
+  uint64_t size_impl() const {
+    return rows_.size();
+  }
+
+  uint64_t block_size_ = default_block_size;
+  std::vector<int64_t> values_;
+  std::vector<detail::time_block> blocks_;
+  Bitstream rows_;
 };
 
 /// A bitmap index for strings.
@@ -317,6 +911,8 @@ private:
       if (!bitmaps_[i].push_back(static_cast<uint8_t>(begin[i])))
         return false;
     }
+    distinct_.add(util::xxhash64::digest_bytes(length > 0 ? &*begin : "",
+                                               length));
     return length_.push_back(length);
   }
 
@@ -394,9 +990,10 @@ private:
   }
 
   trial<Bitstream> lookup_impl(relational_operator op, data const& d) const {
-    auto s = get<std::string>(d);
-    if (s)
+    if (auto s = get<std::string>(d))
       return lookup_impl(op, *s);
+    if (auto p = get<pattern>(d))
+      return lookup_impl(op, *p);
     return error{"not string data: ", d};
   }
 
@@ -405,18 +1002,288 @@ private:
     return lookup_string(op, str.begin(), str.end());
   }
 
+  trial<Bitstream> lookup_impl(relational_operator op,
+                               pattern const& pat) const {
+    if (!(op == match || op == not_match))
+      return error{"unsupported relational operator: ", op};
+    // We cannot evaluate a regular expression on the character slices, but
+    // we can restrict the candidates to the strings beginning with the
+    // literal prefix of the pattern. The result may thus contain false
+    // positives, and for a negated match every row remains a candidate.
+    if (op == not_match)
+      return Bitstream{this->size(), true};
+    auto prefix = pat.literal_prefix();
+    if (prefix.size() > bitmaps_.size())
+      return Bitstream{this->size(), false};
+    auto r = length_.lookup(greater_equal, prefix.size());
+    for (size_t i = 0; i < prefix.size() && !r.all_zeros(); ++i)
+      r &= bitmaps_[i].lookup(equal, static_cast<uint8_t>(prefix[i]));
+    return std::move(r);
+  }
+
   template <size_t N>
   trial<Bitstream> lookup_impl(relational_operator op,
                                char const(&str)[N]) const {
     return lookup_string(op, str, str + N - 1);
   }
 
+  uint64_t cardinality_impl() const {
+    return distinct_.estimate();
+  }
+
   uint64_t size_impl() const {
     return length_.size();
   }
 
   std::vector<char_bitmap_type> bitmaps_;
   length_bitmap_type length_;
+  util::hyperloglog<> distinct_;
+};
+
+/// A bitmap index for strings which maps each distinct string to a dense code
+/// and maintains one bitstream per code. Exact-match lookups thus require a
+/// single bitstream, independent of the string length. Strings longer than
+/// a threshold do not enter the dictionary; their hash digest acts as key.
+template <typename Bitstream>
+class dictionary_bitmap_index
+  : public bitmap_index_base<dictionary_bitmap_index<Bitstream>, Bitstream> {
+  using super =
+    bitmap_index_base<dictionary_bitmap_index<Bitstream>, Bitstream>;
+  friend super;
+  friend access;
+  template <typename>
+  friend struct detail::bitmap_index_model;
+
+public:
+  using bitstream_type = Bitstream;
+  using code_type = uint32_t;
+  using digest_type = util::xxhash64::digest_type;
+
+  /// Strings exceeding this length get hashed instead of stored verbatim.
+  static constexpr size_t max_dictionary_string_length = 64;
+
+  dictionary_bitmap_index() = default;
+
+  friend bool operator==(dictionary_bitmap_index const& x,
+                         dictionary_bitmap_index const& y) {
+    return x.dictionary_ == y.dictionary_ && x.digests_ == y.digests_
+           && x.codes_ == y.codes_ && x.patterns_ == y.patterns_;
+  }
+
+  /// Retrieves the number of distinct values in the index.
+  /// @returns The number of codes.
+  size_t cardinality() const {
+    return codes_.size();
+  }
+
+private:
+  template <typename Map, typename Key>
+  code_type intern(Map& map, Key&& key) {
+    VAST_ASSERT(codes_.size() < std::numeric_limits<code_type>::max());
+    auto next = static_cast<code_type>(codes_.size());
+    auto i = map.emplace(std::forward<Key>(key), next);
+    if (i.second)
+      codes_.resize(next + 1);
+    return i.first->second;
+  }
+
+  maybe<code_type> find(char const* str, size_t length) const {
+    if (length > max_dictionary_string_length) {
+      auto i = digests_.find(util::xxhash64::digest_bytes(str, length));
+      if (i != digests_.end())
+        return i->second;
+    } else {
+      auto i = dictionary_.find(std::string{str, length});
+      if (i != dictionary_.end())
+        return i->second;
+    }
+    return nil;
+  }
+
+  bool push_back_string(char const* str, size_t length) {
+    auto code = length > max_dictionary_string_length
+      ? intern(digests_, util::xxhash64::digest_bytes(str, length))
+      : intern(dictionary_, std::string{str, length});
+    return codes_.encode(code);
+  }
+
+  bool push_back_impl(data const& d) {
+    if (auto str = get<std::string>(d))
+      return push_back_impl(*str);
+    if (auto pat = get<pattern>(d))
+      return push_back_impl(*pat);
+    return false;
+  }
+
+  bool push_back_impl(std::string const& str) {
+    return push_back_string(str.data(), str.size());
+  }
+
+  bool push_back_impl(pattern const& pat) {
+    patterns_ = true;
+    auto str = to_string(pat);
+    return push_back_string(str.data(), str.size());
+  }
+
+  template <size_t N>
+  bool push_back_impl(char const(&str)[N]) {
+    return push_back_string(str, N - 1);
+  }
+
+  bool stretch_impl(size_t n) {
+    return codes_.stretch(n);
+  }
+
+  trial<Bitstream> lookup_string(relational_operator op, char const* str,
+                                 size_t length) const {
+    switch (op) {
+      default:
+        return error{"unsupported relational operator: ", op};
+      case equal:
+      case not_equal:
+        if (patterns_)
+          return lookup_none(op);
+        return lookup_code(op, str, length);
+      case match:
+      case not_match:
+        if (!patterns_)
+          return error{"unsupported relational operator: ", op};
+        return lookup_none(op);
+      case ni:
+      case not_ni: {
+        // We can only inspect strings in the dictionary. Since we cannot tell
+        // whether a hashed string matches, we conservatively include all of
+        // them. The result may thus contain false positives. For a column of
+        // patterns, a string lies in a value if the pattern finds it.
+        Bitstream r{this->size(), false};
+        auto needle = std::string{str, length};
+        for (auto& p : dictionary_) {
+          auto contained = patterns_
+            ? unprint_pattern(p.first).search(needle)
+            : p.first.find(needle) != std::string::npos;
+          if (contained == (op == ni))
+            r |= codes_[p.second];
+        }
+        for (auto& p : digests_)
+          r |= codes_[p.second];
+        return std::move(r);
+      }
+    }
+  }
+
+  trial<Bitstream> lookup_code(relational_operator op, char const* str,
+                               size_t length) const {
+    auto code = find(str, length);
+    if (!code)
+      return Bitstream{this->size(), op == not_equal};
+    return codes_.decode(op, *code);
+  }
+
+  // Answers a predicate that no indexed value can satisfy, e.g., a regular
+  // expression match on a column of patterns, which never matches in
+  // data::evaluate either.
+  trial<Bitstream> lookup_none(relational_operator op) const {
+    auto negated = op == not_equal || op == not_ni || op == not_match;
+    return Bitstream{this->size(), negated};
+  }
+
+  // Recovers a pattern from its dictionary key, i.e., its printed form.
+  static pattern unprint_pattern(std::string const& str) {
+    VAST_ASSERT(str.size() >= 2);
+    return pattern{str.substr(1, str.size() - 2)};
+  }
+
+  trial<Bitstream> lookup_pattern(relational_operator op,
+                                  pattern const& pat) const {
+    // Running the pattern once per distinct value makes the cost independent
+    // of the number of rows. As above, hashed strings remain candidates.
+    Bitstream r{this->size(), false};
+    auto prefix = pat.literal_prefix();
+    for (auto& p : dictionary_) {
+      auto matches = p.first.compare(0, prefix.size(), prefix) == 0
+                     && pat.match(p.first);
+      if (matches == (op == match))
+        r |= codes_[p.second];
+    }
+    for (auto& p : digests_)
+      r |= codes_[p.second];
+    return std::move(r);
+  }
+
+  trial<Bitstream> lookup_impl(relational_operator op, data const& d) const {
+    if (auto s = get<std::string>(d))
+      return lookup_impl(op, *s);
+    if (auto p = get<pattern>(d))
+      return lookup_impl(op, *p);
+    return error{"not string data: ", d};
+  }
+
+  trial<Bitstream> lookup_impl(relational_operator op,
+                               pattern const& pat) const {
+    switch (op) {
+      default:
+        return error{"unsupported relational operator: ", op};
+      case equal:
+      case not_equal: {
+        if (!patterns_)
+          return lookup_none(op);
+        // Indexed patterns support equality lookups via their string form.
+        auto str = to_string(pat);
+        return lookup_code(op, str.data(), str.size());
+      }
+      case match:
+      case not_match:
+        if (patterns_)
+          return lookup_none(op);
+        return lookup_pattern(op, pat);
+      case ni:
+      case not_ni:
+        return lookup_none(op);
+    }
+  }
+
+  trial<Bitstream> lookup_impl(relational_operator op,
+                               std::string const& str) const {
+    return lookup_string(op, str.data(), str.size());
+  }
+
+  template <size_t N>
+  trial<Bitstream> lookup_impl(relational_operator op,
+                               char const(&str)[N]) const {
+    return lookup_string(op, str, N - 1);
+  }
+
+  uint64_t cardinality_impl() const {
+    return codes_.size();
+  }
+
+  maybe<uint64_t> estimate_impl(relational_operator op, data const& d) const {
+    if (!(op == equal || op == not_equal))
+      return {};
+    maybe<code_type> code;
+    if (auto s = get<std::string>(d)) {
+      if (!patterns_)
+        code = find(s->data(), s->size());
+    } else if (auto p = get<pattern>(d)) {
+      if (!patterns_)
+        return op == equal ? 0 : this->size();
+      auto str = to_string(*p);
+      code = find(str.data(), str.size());
+    } else {
+      return {};
+    }
+    auto n = code ? codes_[*code].count() : 0;
+    return op == equal ? n : this->size() - n;
+  }
+
+  uint64_t size_impl() const {
+    return codes_.rows();
+  }
+
+  std::unordered_map<std::string, code_type> dictionary_;
+  std::unordered_map<digest_type, code_type> digests_;
+  equality_coder<Bitstream> codes_;
+  bool patterns_ = false;
 };
 
 /// A bitmap index for IP addresses.
@@ -439,19 +1306,30 @@ public:
 
   friend bool operator==(address_bitmap_index const& x,
                          address_bitmap_index const& y) {
-    return x.bitmaps_ == y.bitmaps_;
+    return x.bitmaps_ == y.bitmaps_ && x.v4_ == y.v4_;
   }
 
 private:
+  // IPv4 and IPv6 addresses share the byte-slices of the last four bytes. The
+  // byte-slices of the first twelve bytes only receive IPv6 addresses and
+  // remain empty until the first one arrives.
+  static constexpr size_t v4_offset = 12;
+
   bool push_back_impl(address const& a) {
     auto& bytes = a.data();
-    size_t start = a.is_v4() ? 12 : 0;
-    if (!v4_.push_back(start == 12))
+    auto is_v4 = a.is_v4();
+    auto row = v4_.size();
+    if (!v4_.push_back(is_v4))
       return false;
-    for (size_t i = 0; i < 16; ++i)
-      // TODO: be lazy and push_back only where needed.
-      if (!bitmaps_[i].push_back(i < start ? 0x00 : bytes[i]))
+    if (!is_v4)
+      for (size_t i = 0; i < v4_offset; ++i)
+        if (!bitmaps_[i].stretch(row - bitmaps_[i].size())
+            || !bitmaps_[i].push_back(bytes[i]))
+          return false;
+    for (size_t i = v4_offset; i < 16; ++i)
+      if (!bitmaps_[i].push_back(bytes[i]))
         return false;
+    distinct_.add(util::xxhash64::digest_bytes(bytes.data(), bytes.size()));
     return true;
   }
 
@@ -465,7 +1343,7 @@ private:
   }
 
   bool stretch_impl(size_t n) {
-    for (size_t i = 0; i < 16; ++i)
+    for (size_t i = v4_offset; i < 16; ++i)
       if (!bitmaps_[i].stretch(n))
         return false;
     return v4_.append(n, false);
@@ -489,17 +1367,10 @@ private:
   trial<Bitstream> lookup_impl(relational_operator op, address const& a) const {
     if (!(op == equal || op == not_equal))
       return error{"unsupported relational operator: ", op};
-    auto& bytes = a.data();
-    auto is_v4 = a.is_v4();
-    auto result = is_v4 ? v4_ : Bitstream{this->size(), true};
-    for (size_t i = is_v4 ? 12 : 0; i < 16; ++i) {
-      auto bs = bitmaps_[i].lookup(equal, bytes[i]);
-      if (!bs.all_zeros())
-        result &= bs;
-      else
-        return Bitstream{this->size(), op == not_equal};
-    }
-    return std::move(op == equal ? result : result.flip());
+    auto result = a.is_v4() ? match_v4(a, 32) : match_v6(a, 128);
+    if (op == not_equal)
+      result.flip();
+    return std::move(result);
   }
 
   trial<Bitstream> lookup_impl(relational_operator op, subnet const& s) const {
@@ -508,35 +1379,78 @@ private:
     auto topk = s.length();
     if (topk == 0)
       return error{"invalid IP subnet length: ", topk};
-    auto net = s.network();
-    auto is_v4 = net.is_v4();
-    if ((is_v4 ? topk + 96 : topk) == 128)
-      // Asking for /32 or /128 membership is equivalent to equality.
-      return lookup_impl(op == in ? equal : not_equal, s.network());
-    auto result = is_v4 ? v4_ : Bitstream{this->size(), true};
-    auto& bytes = net.data();
-    size_t i = is_v4 ? 12 : 0;
-    while (i < 16 && topk >= 8) {
-      result &= bitmaps_[i].lookup(equal, bytes[i]);
-      ++i;
-      topk -= 8;
-    }
-    for (auto j = 0u; j < topk; ++j) {
-      auto bit = 7 - j;
-      auto& bs = bitmaps_[i].coder()[bit];
-      result &= (bytes[i] >> bit) & 1 ? ~bs : bs;
+    auto& net = s.network();
+    auto result = Bitstream{};
+    if (net.is_v4()) {
+      result = match_v4(net, topk);
+    } else {
+      // An IPv6 prefix may still cover the IPv4-mapped address space.
+      result = match_v6(net, topk);
+      auto zero = uint32_t{0};
+      auto v4 = address{&zero, address::ipv4, address::network};
+      auto v4_bits = std::min(topk, uint8_t{96});
+      if (common_prefix(net.data(), v4.data(), v4_bits))
+        result |= match_v4(net, topk - v4_bits);
     }
     if (op == not_in)
       result.flip();
+    return std::move(result);
+  }
+
+  // Checks whether two byte sequences agree in their top *bits* bits.
+  static bool common_prefix(std::array<uint8_t, 16> const& x,
+                            std::array<uint8_t, 16> const& y, size_t bits) {
+    for (size_t i = 0; i < bits; ++i) {
+      auto bit = 7 - i % 8;
+      if (((x[i / 8] ^ y[i / 8]) >> bit) & 1)
+        return false;
+    }
+    return true;
+  }
+
+  // Computes the IPv4 rows whose top *bits* bits equal the ones of *a*.
+  Bitstream match_v4(address const& a, size_t bits) const {
+    auto result = v4_;
+    match_prefix(result, a.data(), v4_offset, bits);
+    return result;
+  }
+
+  // Computes the IPv6 rows whose top *bits* bits equal the ones of *a*.
+  Bitstream match_v6(address const& a, size_t bits) const {
+    auto result = v4_;
+    result.flip();
+    match_prefix(result, a.data(), 0, bits);
     return result;
   }
 
+  // Restricts a bitstream to the rows whose *bits* leading bits, starting at
+  // byte *first*, equal the ones in *bytes*. Since each step can only remove
+  // rows, we stop as soon as no row remains.
+  void match_prefix(Bitstream& result, std::array<uint8_t, 16> const& bytes,
+                    size_t first, size_t bits) const {
+    for (size_t i = 0; i < bits && !result.all_zeros(); ++i) {
+      auto byte = first + i / 8;
+      auto bit = 7 - i % 8;
+      // The bitslice coder stores the complement of each bit.
+      auto& bs = bitmaps_[byte].coder()[bit];
+      if ((bytes[byte] >> bit) & 1)
+        result -= bs;
+      else
+        result &= bs;
+    }
+  }
+
+  uint64_t cardinality_impl() const {
+    return distinct_.estimate();
+  }
+
   uint64_t size_impl() const {
     return v4_.size();
   }
 
   std::array<bitmap_type, 16> bitmaps_;
   Bitstream v4_;
+  util::hyperloglog<> distinct_;
 };
 
 /// A bitmap index for IP prefixes.
@@ -18,6 +18,8 @@ struct bitmap_index_concept {
   virtual trial<Bitstream> lookup(relational_operator op,
                                   data const& d) const = 0;
   virtual uint64_t size() const = 0;
+  virtual bitmap_index_statistics statistics() const = 0;
+  virtual uint64_t estimate(relational_operator op, data const& d) const = 0;
   virtual std::unique_ptr<bitmap_index_concept> copy() const = 0;
   virtual bool equals(bitmap_index_concept const& other) const = 0;
 };
@@ -52,6 +54,15 @@ struct bitmap_index_model
     return bmi_.size();
   }
 
+  virtual bitmap_index_statistics statistics() const final {
+    return bmi_.statistics();
+  }
+
+  virtual uint64_t estimate(relational_operator op,
+                            data const& d) const final {
+    return bmi_.estimate(op, d);
+  }
+
   BitmapIndex const& cast(bmi_concept const& c) const {
     if (typeid(c) != typeid(*this))
       throw std::bad_cast();
@@ -140,6 +151,16 @@ public:
     return concept_->size();
   }
 
+  bitmap_index_statistics statistics() const {
+    VAST_ASSERT(concept_);
+    return concept_->statistics();
+  }
+
+  uint64_t estimate(relational_operator op, data const& d) const {
+    VAST_ASSERT(concept_);
+    return concept_->estimate(op, d);
+  }
+
   uint64_t empty() const {
     VAST_ASSERT(concept_);
     return concept_->empty();
@@ -151,8 +172,8 @@ public:
   }
 
   friend bool operator==(bitmap_index const& x, bitmap_index const& y) {
-    VAST_ASSERT(x.concept_);
-    VAST_ASSERT(y.concept_);
+    if (!x.concept_ || !y.concept_)
+      return !x.concept_ && !y.concept_;
     return x.concept_->equals(*y.concept_);
   }
 
@@ -165,7 +186,45 @@ enum type_tag : uint8_t;
 template <typename Bitstream>
 bitmap_index<Bitstream> make_bitmap_index(type_tag t);
 
-/// A bitmap index for sets, vectors, and tuples.
+namespace detail {
+
+/// Maps a bitstream over the elements of containers to a bitstream over the
+/// containers.
+/// @param hits The bitstream over element rows to project.
+/// @param starts Marks the first element of each container.
+/// @param rows Marks the rows with a non-empty container.
+/// @returns A bitstream of size `rows.size()` with a 1-bit for each container
+///          having at least one element in *hits*.
+template <typename Bitstream>
+Bitstream project_elements(Bitstream const& hits, Bitstream const& starts,
+                           Bitstream const& rows) {
+  Bitstream result;
+  auto next = starts.begin();
+  auto last = starts.end();
+  auto row = rows.begin();
+  if (next != last)
+    ++next;
+  for (auto e : hits) {
+    // Advance to the container holding element *e*.
+    while (next != last && *next <= e) {
+      ++next;
+      ++row;
+    }
+    if (*row >= result.size()) {
+      result.append(*row - result.size(), false);
+      result.push_back(true);
+    }
+  }
+  result.append(rows.size() - result.size(), false);
+  return result;
+}
+
+} // namespace detail
+
+/// A bitmap index for sets, vectors, and tuples. Instead of maintaining one
+/// bitmap index per element position, the index stores all elements in a
+/// single inner index and maps element rows back to container rows. Memory and
+/// lookup costs therefore do not depend on the longest container.
 template <typename Bitstream>
 class sequence_bitmap_index
   : public bitmap_index_base<sequence_bitmap_index<Bitstream>, Bitstream> {
@@ -175,20 +234,43 @@ class sequence_bitmap_index
   template <typename>
   friend struct detail::bitmap_index_model;
 
-  static constexpr size_t max_container_length = 4096;
-
 public:
   using bitstream_type = Bitstream;
 
   sequence_bitmap_index() = default;
 
-  sequence_bitmap_index(type t) : elem_type_{std::move(t)} {
+  /// Constructs a sequence bitmap index.
+  /// @param t The type of the container elements.
+  /// @param positions Whether to index the position of each element as well.
+  sequence_bitmap_index(type t, bool positions = false)
+    : elem_type_{std::move(t)},
+      positional_{positions} {
   }
 
   friend bool operator==(sequence_bitmap_index const& x,
                          sequence_bitmap_index const& y) {
-    return x.elem_type_ == y.elem_type_ && x.bmis_ == y.bmis_
-           && x.size_ == y.size_;
+    return x.elem_type_ == y.elem_type_ && x.positional_ == y.positional_
+           && x.elements_ == y.elements_ && x.starts_ == y.starts_
+           && x.positions_ == y.positions_ && x.rows_ == y.rows_;
+  }
+
+  /// Looks up a value at a given position in the containers.
+  /// @param i The element position to consider.
+  /// @param op The relational operator.
+  /// @param d The value to compare the elements at position *i* with.
+  /// @returns The rows of the containers whose *i*-th element satisfies
+  ///          *op* with respect to *d*.
+  trial<Bitstream> lookup_position(size_t i, relational_operator op,
+                                   data const& d) const {
+    if (!positional_)
+      return error{"sequence index without positions"};
+    if (!elements_)
+      return Bitstream{this->size(), false};
+    auto hits = elements_.lookup(op, d);
+    if (!hits)
+      return hits;
+    *hits &= positions_.lookup(equal, i);
+    return detail::project_elements(*hits, starts_, rows_);
   }
 
 private:
@@ -206,25 +288,21 @@ private:
   template <typename Container>
   bool push_back_impl(Container const& c) {
     if (c.empty())
-      return size_.stretch(1);
-    if (c.size() > max_container_length)
-      return false;
-    if (bmis_.size() < c.size()) {
-      auto old = bmis_.size();
-      bmis_.resize(c.size());
-      for (auto i = old; i < bmis_.size(); ++i) {
-        bmis_[i] = make_bitmap_index<Bitstream>(elem_type_);
-        VAST_ASSERT(bmis_[i]);
-      }
+      return rows_.push_back(false);
+    if (!elements_) {
+      elements_ = make_bitmap_index<Bitstream>(elem_type_);
+      if (!elements_)
+        return false;
     }
     for (size_t i = 0; i < c.size(); ++i)
-      if (!bmis_[i].push_back(c[i], this->size()))
+      if (!elements_.push_back(c[i]) || !starts_.push_back(i == 0)
+          || (positional_ && !positions_.push_back(i)))
         return false;
-    return size_.push_back(c.size());
+    return rows_.push_back(true);
   }
 
   bool stretch_impl(size_t n) {
-    return size_.stretch(n);
+    return rows_.append(n, false);
   }
 
   trial<Bitstream> lookup_impl(relational_operator op, data const& d) const {
@@ -236,37 +314,122 @@ private:
       return error{"unsupported relational operator: ", op};
     if (this->empty())
       return Bitstream{};
-    Bitstream r;
-    auto t = bmis_.front().lookup(equal, d);
-    if (t)
-      r |= *t;
-    else
-      return t;
-    for (size_t i = 1; i < bmis_.size(); ++i) {
-      auto bs = bmis_[i].lookup(equal, d);
-      if (bs)
-        r |= *bs;
-      else
-        return bs;
-    }
-    if (r.size() < this->size())
-      r.append(this->size() - r.size(), false);
+    if (!elements_)
+      return Bitstream{this->size(), op == not_in};
+    auto hits = elements_.lookup(equal, d);
+    if (!hits)
+      return hits;
+    auto r = detail::project_elements(*hits, starts_, rows_);
     if (op == not_in)
       r.flip();
     return std::move(r);
   }
 
   uint64_t size_impl() const {
-    return size_.size();
+    return rows_.size();
   }
 
   type elem_type_;
-  std::vector<bitmap_index<Bitstream>> bmis_;
+  bool positional_ = false;
+  bitmap_index<Bitstream> elements_;
+  Bitstream starts_;
   bitmap<
-    uint32_t, multi_level_coder<uniform_base<10, 4>, range_coder<Bitstream>>
-  > size_;
+    uint32_t, multi_level_coder<uniform_base<10, 10>, equality_coder<Bitstream>>
+  > positions_;
+  Bitstream rows_;
+};
+
+/// A bitmap index for tables. It indexes the keys of all tables in a single
+/// index over all elements. Only key membership (`T ni x`) narrows down rows;
+/// every other operator yields all rows and leaves the decision to the
+/// candidate check, which evaluates the full table.
+template <typename Bitstream>
+class table_bitmap_index
+  : public bitmap_index_base<table_bitmap_index<Bitstream>, Bitstream> {
+  using super = bitmap_index_base<table_bitmap_index<Bitstream>, Bitstream>;
+  friend super;
+  friend access;
+  template <typename>
+  friend struct detail::bitmap_index_model;
+
+public:
+  using bitstream_type = Bitstream;
+
+  table_bitmap_index() = default;
+
+  /// Constructs a table bitmap index.
+  /// @param key The type of the table keys.
+  explicit table_bitmap_index(type key) : key_type_{std::move(key)} {
+  }
+
+  friend bool operator==(table_bitmap_index const& x,
+                         table_bitmap_index const& y) {
+    return x.key_type_ == y.key_type_ && x.keys_ == y.keys_
+           && x.starts_ == y.starts_ && x.rows_ == y.rows_;
+  }
+
+private:
+  bool push_back_impl(data const& d) {
+    auto t = get<table>(d);
+    return t && push_back_impl(*t);
+  }
+
+  bool push_back_impl(table const& t) {
+    if (t.empty())
+      return rows_.push_back(false);
+    if (!keys_) {
+      keys_ = make_bitmap_index<Bitstream>(key_type_);
+      if (!keys_)
+        return false;
+    }
+    auto first = true;
+    for (auto& pair : t) {
+      if (!keys_.push_back(pair.first) || !starts_.push_back(first))
+        return false;
+      first = false;
+    }
+    return rows_.push_back(true);
+  }
+
+  bool stretch_impl(size_t n) {
+    return rows_.append(n, false);
+  }
+
+  trial<Bitstream> lookup_impl(relational_operator op, data const& d) const {
+    if (!(op == ni || op == not_ni))
+      return Bitstream{this->size(), true};
+    if (this->empty())
+      return Bitstream{};
+    if (!keys_)
+      return Bitstream{this->size(), op == not_ni};
+    auto hits = keys_.lookup(equal, d);
+    if (!hits)
+      return hits;
+    auto r = detail::project_elements(*hits, starts_, rows_);
+    if (op == not_ni)
+      r.flip();
+    return std::move(r);
+  }
+
+  uint64_t size_impl() const {
+    return rows_.size();
+  }
+
+  type key_type_;
+  bitmap_index<Bitstream> keys_;
+  Bitstream starts_;
+  Bitstream rows_;
 };
 
+/// Checks whether a string type asks for a dictionary-encoded index, which the
+/// type attribute `&index="dictionary"` specifies.
+/// @param t The string type to check.
+/// @returns `true` if *t* should be indexed with a dictionary_bitmap_index.
+inline bool has_dictionary_index(type::string const& t) {
+  auto a = t.find_attribute(type::attribute::index);
+  return a && a->value == "dictionary";
+}
+
 namespace detail {
 
 template <typename Bitstream>
@@ -285,10 +448,28 @@ struct bitmap_index_factory {
     return arithmetic_bitmap_index<Bitstream, type::to_data<T>>{};
   }
 
-  result_type operator()(type::string const&) const {
+  result_type operator()(type::string const& t) const {
+    if (has_dictionary_index(t))
+      return dictionary_bitmap_index<Bitstream>{};
     return string_bitmap_index<Bitstream>{};
   }
 
+  result_type operator()(type::pattern const&) const {
+    return dictionary_bitmap_index<Bitstream>{};
+  }
+
+  result_type operator()(type::vector const& t) const {
+    return sequence_bitmap_index<Bitstream>{t.elem()};
+  }
+
+  result_type operator()(type::set const& t) const {
+    return sequence_bitmap_index<Bitstream>{t.elem()};
+  }
+
+  result_type operator()(type::table const& t) const {
+    return table_bitmap_index<Bitstream>{t.key()};
+  }
+
   result_type operator()(type::address const&) const {
     return address_bitmap_index<Bitstream>{};
   }
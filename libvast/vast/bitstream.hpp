@@ -2,6 +2,8 @@
 #define VAST_BITSTREAM_HPP
 
 #include <algorithm>
+#include <memory>
+#include <vector>
 
 #include "vast/bitvector.hpp"
 #include "vast/util/assert.hpp"
@@ -297,14 +299,14 @@ protected:
     return static_cast<Derived*>(this)->next_sequence(seq_);
   }
 
+  bitseq seq_;
+
 private:
   friend util::range_facade<sequence_range_base<Derived>>;
 
   bitseq const& state() const {
     return seq_;
   }
-
-  bitseq seq_;
 };
 
 template <typename>
@@ -466,8 +468,20 @@ public:
     explicit sequence_range(ewah_bitstream const& bs);
 
   private:
+    friend ewah_bitstream;
     friend detail::sequence_range_base<sequence_range>;
 
+    // A position in the compressed blocks where iteration can resume.
+    struct sample {
+      size_type block = 0;  // The index of the next block to process.
+      size_type marker = 0; // The index of the marker governing the block.
+      size_type offset = 0; // The bit position where the block begins.
+      size_type rank = 0;   // The number of 1-bits in [0, offset).
+    };
+
+    // Resumes iteration at a sample of the rank/select directory.
+    sequence_range(ewah_bitstream const& bs, sample const& s);
+
     bool next_sequence(bitseq& seq);
 
     bitvector const* bits_;
@@ -478,11 +492,30 @@ public:
 
   ewah_bitstream() = default;
   ewah_bitstream(size_type n, bool bit);
-  ewah_bitstream(ewah_bitstream const&) = default;
+  ewah_bitstream(ewah_bitstream const& other);
   ewah_bitstream(ewah_bitstream&&) = default;
-  ewah_bitstream& operator=(ewah_bitstream const&) = default;
+  ewah_bitstream& operator=(ewah_bitstream const& other);
   ewah_bitstream& operator=(ewah_bitstream&&) = default;
 
+  /// Attaches a sampled rank/select directory which records the bit offset
+  /// and the number of preceding 1-bits every *k* compressed blocks. With a
+  /// directory, `find_*`, `count`, and `rank` perform a binary search over the
+  /// samples followed by a scan of at most *k* blocks, instead of scanning the
+  /// entire bitstream. Every modification brings the directory up to date, so
+  /// that lookups never change it and concurrent readers can share a
+  /// bitstream. The directory is transient state: neither compared nor
+  /// serialized, but rebuilt after deserialization.
+  /// @param k The sampling interval in blocks.
+  void attach_directory(size_type k = 64);
+
+  /// Removes the rank/select directory, if one exists.
+  void detach_directory();
+
+  /// Computes the number of 1-bits in the prefix `[0, i)`.
+  /// @param i The end of the prefix.
+  /// @returns The number of 1-bits before position *i*.
+  size_type rank(size_type i) const;
+
 private:
   bool equals(ewah_bitstream const& other) const;
   void bitwise_not();
@@ -575,12 +608,41 @@ private:
   /// @pre `num_bits_ % block_width == 0`
   void bump_dirty_count();
 
+  size_type find_forward(sequence_range range, size_type i) const;
+  size_type find_backward(sequence_range range, size_type i) const;
   size_type find_forward(size_type i) const;
   size_type find_backward(size_type i) const;
 
+  /// Replaces the bitstream contents while keeping an attached directory.
+  void assign(ewah_bitstream&& other);
+
+  /// Advances an attached directory up to the last block whose position and
+  /// rank can no longer change through appending.
+  void catch_up();
+
+  /// Locates the last directory sample at or before a given position.
+  /// @pre `directory_ && !bits_.empty()`
+  size_t locate(size_type i) const;
+
+  struct directory {
+    explicit directory(size_type k) : interval{k} {
+      reset();
+    }
+
+    void reset() {
+      cursor = {};
+      samples.assign(1, cursor);
+    }
+
+    size_type interval;
+    std::vector<sequence_range::sample> samples;
+    sequence_range::sample cursor;
+  };
+
   bitvector bits_;
   size_type num_bits_ = 0;
   size_type last_marker_ = 0;
+  std::unique_ptr<directory> directory_;
 };
 
 /// Applies a bitwise operation on two bitstreams.
@@ -9,12 +9,15 @@
 #include "vast/util/assert.hpp"
 #include "vast/util/operators.hpp"
 #include "vast/util/iterator.hpp"
+#include "vast/util/mapped_vector.hpp"
 
 namespace vast {
 
 struct access;
 
-/// A vector of bits having similar semantics as a `std::vector<bool>`.
+/// A vector of bits having similar semantics as a `std::vector<bool>`. After
+/// deserialization from a memory-mapped file, the blocks reference the
+/// mapped memory until the first modification copies them.
 class bitvector : util::totally_ordered<bitvector> {
   friend access;
 
@@ -413,6 +416,11 @@ public:
     } while (first != last);
   }
 
+  /// Checks whether the blocks still reside in read-only, mapped memory.
+  /// @returns `true` iff the bit vector has not been modified since
+  ///          deserializing it from a mapped file.
+  bool mapped() const;
+
   /// Counts the number of 1-bits in the bit vector.
   /// Also known as *population count* or *Hamming weight*.
   /// @returns The number of bits set to 1.
@@ -527,7 +535,7 @@ private:
   ///          `bitvector::npos` if no 1-bit exists.
   size_type find_backward(size_type i) const;
 
-  std::vector<block_type> bits_;
+  util::mapped_vector<block_type> bits_;
   size_type num_bits_;
 };
 
@@ -118,6 +118,10 @@ public:
   /// @returns The number of bytes the chunk takes up in memory.
   uint64_t bytes() const;
 
+  /// Retrieves the size of the uncompressed chunk in bytes.
+  /// @returns The number of bytes of the serialized events.
+  uint64_t uncompressed_bytes() const;
+
   /// Retrieves the number of events in the chunk.
   /// @returns The number of events in the chunk.
   uint64_t events() const;
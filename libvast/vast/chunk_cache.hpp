@@ -0,0 +1,82 @@
+#ifndef VAST_CHUNK_CACHE_HPP
+#define VAST_CHUNK_CACHE_HPP
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <caf/message.hpp>
+
+#include "vast/aliases.hpp"
+#include "vast/trial.hpp"
+
+namespace vast {
+
+class chunk;
+class event;
+
+/// A cache of decoded chunks which all EXPORTERs of a node share. The cache
+/// holds the events of a chunk in a message, so that users of the events
+/// share them by reference counting, even after the cache has evicted the
+/// chunk. When the estimated memory of all decoded events exceeds the
+/// capacity, the cache evicts the least recently used chunks. Multiple
+/// threads can access the cache concurrently.
+class chunk_cache {
+public:
+  /// Constructs a chunk cache.
+  /// @param capacity The maximum number of bytes of decoded events to hold.
+  explicit chunk_cache(uint64_t capacity);
+
+  /// Estimates the memory that decoded events occupy, including the heap
+  /// memory of their data but not their shared types.
+  /// @param events The events to estimate the memory of.
+  /// @returns The estimated number of bytes *events* occupy.
+  static uint64_t footprint(std::vector<event> const& events);
+
+  /// Retrieves the events of a chunk, decoding the chunk on a cache miss.
+  /// @param chk The chunk to retrieve the events of.
+  /// @returns A message with the `std::vector<event>` of *chk* in ID order.
+  trial<caf::message> lookup(chunk const& chk);
+
+  /// Retrieves the capacity of the cache.
+  /// @returns The maximum number of bytes of decoded events the cache holds.
+  uint64_t capacity() const;
+
+  /// Adjusts the capacity of the cache and evicts chunks if necessary.
+  /// @param bytes The maximum number of bytes of decoded events to hold.
+  void capacity(uint64_t bytes);
+
+  /// Retrieves the estimated memory of all cached events.
+  /// @returns The number of bytes the decoded events in the cache occupy.
+  uint64_t size() const;
+
+  /// Retrieves the number of lookups the cache answered without decoding.
+  /// @returns The number of cache hits.
+  uint64_t hits() const;
+
+  /// Retrieves the number of lookups which required decoding.
+  /// @returns The number of cache misses.
+  uint64_t misses() const;
+
+private:
+  struct entry {
+    caf::message events;
+    uint64_t bytes;
+    std::list<event_id>::iterator position;
+  };
+
+  void shrink(uint64_t bytes);
+
+  mutable std::mutex mutex_;
+  std::list<event_id> lru_;
+  std::unordered_map<event_id, entry> entries_;
+  uint64_t capacity_;
+  uint64_t size_ = 0;
+  uint64_t hits_ = 0;
+  uint64_t misses_ = 0;
+};
+
+} // namespace vast
+
+#endif
@@ -62,6 +62,7 @@ struct type_parser : parser<type_parser> {
       = "invalid"_p ->* [] { return type::attribute::invalid; }
       | "skip"_p    ->* [] { return type::attribute::skip; }
       | "default"_p ->* [] { return type::attribute::default_; }
+      | "index"_p   ->* [] { return type::attribute::index; }
       ;
     static auto to_attr =
       [](std::tuple<type::attribute::key_type, std::string> t) {
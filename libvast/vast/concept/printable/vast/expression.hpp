@@ -8,6 +8,7 @@
 #include "vast/concept/printable/print.hpp"
 #include "vast/concept/printable/core/printer.hpp"
 #include "vast/concept/printable/vast/data.hpp"
+#include "vast/concept/printable/vast/interned.hpp"
 #include "vast/concept/printable/vast/key.hpp"
 #include "vast/concept/printable/vast/none.hpp"
 #include "vast/concept/printable/vast/offset.hpp"
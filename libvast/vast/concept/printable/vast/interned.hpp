@@ -0,0 +1,29 @@
+#ifndef VAST_CONCEPT_PRINTABLE_VAST_INTERNED_HPP
+#define VAST_CONCEPT_PRINTABLE_VAST_INTERNED_HPP
+
+#include "vast/util/interned.hpp"
+#include "vast/concept/printable/core/printer.hpp"
+#include "vast/concept/printable/vast/none.hpp"
+
+namespace vast {
+
+template <typename T>
+struct interned_printer : printer<interned_printer<T>> {
+  using attribute = util::interned<T>;
+
+  template <typename Iterator>
+  bool print(Iterator& out, util::interned<T> const& x) const {
+    static auto p = make_printer<T>{};
+    static auto n = make_printer<none>{};
+    return x ? p.print(out, *x) : n.print(out, nil);
+  }
+};
+
+template <typename T>
+struct printer_registry<util::interned<T>, std::enable_if_t<has_printer<T>{}>> {
+  using type = interned_printer<T>;
+};
+
+} // namespace vast
+
+#endif
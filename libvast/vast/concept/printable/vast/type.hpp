@@ -105,6 +105,9 @@ struct type_attribute_printer : printer<type_attribute_printer> {
       case type::attribute::default_:
         return str.print(out, "default=\"") && str.print(out, attr.value)
                && any.print(out, '"');
+      case type::attribute::index:
+        return str.print(out, "index=\"") && str.print(out, attr.value)
+               && any.print(out, '"');
     }
   }
 };
@@ -1,6 +1,8 @@
 #ifndef VAST_CONCEPT_SERIALIZABLE_BINARY_DESERIALIZER_HPP
 #define VAST_CONCEPT_SERIALIZABLE_BINARY_DESERIALIZER_HPP
 
+#include <memory>
+
 #include "vast/concept/serializable/deserializer.hpp"
 #include "vast/io/coded_stream.hpp"
 
@@ -14,6 +16,17 @@ public:
   binary_deserializer(io::input_stream& source) : source_{source} {
   }
 
+  /// Constructs a deserializer which reads from memory that stays alive for
+  /// as long as a given owner exists, e.g., a memory-mapped file. Such a
+  /// deserializer can hand out views into *source* instead of copying.
+  /// @param source The input stream to read from.
+  /// @param owner The owner of the memory underlying *source*.
+  binary_deserializer(io::input_stream& source,
+                      std::shared_ptr<void const> owner)
+    : source_{source},
+      owner_{std::move(owner)} {
+  }
+
   uint64_t begin_sequence() {
     uint64_t size;
     if (!source_.read_varbyte(&size))
@@ -33,12 +46,29 @@ public:
     bytes_ += size;
   }
 
+  void align(size_t alignment) {
+    auto padding = (alignment - bytes_ % alignment) % alignment;
+    source_.skip(padding);
+    bytes_ += padding;
+  }
+
+  std::shared_ptr<void const> view(size_t size) {
+    void const* data;
+    size_t available;
+    if (!owner_ || !source_.raw(&data, &available) || available < size)
+      return {};
+    source_.skip(size);
+    bytes_ += size;
+    return {owner_, data};
+  }
+
   uint64_t bytes() const {
     return bytes_;
   }
 
 private:
   io::coded_input_stream source_;
+  std::shared_ptr<void const> owner_;
   uint64_t bytes_ = 0;
 };
 
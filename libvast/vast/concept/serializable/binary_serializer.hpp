@@ -3,6 +3,7 @@
 
 #include "vast/concept/serializable/serializer.hpp"
 #include "vast/io/coded_stream.hpp"
+#include "vast/util/assert.hpp"
 
 namespace vast {
 
@@ -30,6 +31,14 @@ public:
     bytes_ += size;
   }
 
+  void align(size_t alignment) {
+    static constexpr uint8_t zeros[16] = {};
+    auto padding = (alignment - bytes_ % alignment) % alignment;
+    VAST_ASSERT(padding <= sizeof(zeros));
+    if (padding > 0)
+      write(zeros, padding);
+  }
+
   uint64_t bytes() const {
     return bytes_;
   }
@@ -1,7 +1,9 @@
 #ifndef VAST_CONCEPT_SERIALIZABLE_DESERIALIZER_HPP
 #define VAST_CONCEPT_SERIALIZABLE_DESERIALIZER_HPP
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <type_traits>
 
 namespace vast {
@@ -50,6 +52,23 @@ public:
     // nop
   }
 
+  /// Skips the padding written by `serializer::align`.
+  /// @param alignment The alignment in bytes.
+  void align(size_t) {
+    // nop
+  }
+
+  /// Lends out the next bytes of the source without copying them, provided
+  /// that the source resides in memory which outlives the deserializer. On
+  /// success, the deserializer advances past the bytes.
+  /// @param size The number of bytes to view.
+  /// @returns A pointer to *size* bytes that shares ownership of the
+  ///          underlying memory, or `nullptr` if the source cannot lend out
+  ///          its memory.
+  std::shared_ptr<void const> view(size_t) {
+    return {};
+  }
+
   /// Deserializes an instance.
   /// @param x The instance to read into.
   template <typename T>
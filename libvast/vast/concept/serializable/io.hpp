@@ -1,12 +1,16 @@
 #ifndef VAST_CONCEPT_SERIALIZABLE_IO_HPP
 #define VAST_CONCEPT_SERIALIZABLE_IO_HPP
 
+#include <memory>
+
 #include "vast/concept/serializable/binary_serializer.hpp"
 #include "vast/concept/serializable/binary_deserializer.hpp"
 #include "vast/concept/printable/vast/filesystem.hpp"
+#include "vast/io/array_stream.hpp"
 #include "vast/io/container_stream.hpp"
 #include "vast/io/compressed_stream.hpp"
 #include "vast/io/file_stream.hpp"
+#include "vast/io/mapped_file.hpp"
 #include "vast/trial.hpp"
 
 namespace vast {
@@ -61,6 +65,22 @@ trial<void> load(path const& filename, Ts&... xs) {
   return nothing;
 }
 
+/// Deserializes objects from a memory-mapped file. Unlike `load`, objects
+/// which support it reference the mapped contents instead of copying them,
+/// and thereby keep the mapping alive.
+template <typename... Ts>
+trial<void> load_mapped(path const& filename, Ts&... xs) {
+  if (!exists(filename))
+    return error{"no such file: ", filename};
+  auto file = std::make_shared<io::mapped_file>(filename);
+  if (!file->is_open())
+    return error{"failed to map file: ", filename};
+  io::array_input_stream source{file->data(), file->size()};
+  binary_deserializer d{source, file};
+  d.get(xs...);
+  return nothing;
+}
+
 template <typename... Ts, typename Container>
 auto compress(Container& c, io::compression method, Ts const&... xs)
   -> decltype(detail::is_byte_container<Container>(), trial<void>()) {
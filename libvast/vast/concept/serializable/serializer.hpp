@@ -51,6 +51,13 @@ public:
     // nop
   }
 
+  /// Pads the output such that the next write begins at a multiple of a
+  /// given alignment. Serializers without a notion of position ignore it.
+  /// @param alignment The alignment in bytes.
+  void align(size_t) {
+    // nop
+  }
+
   /// Serializes an instance.
   /// @param x The instance to write.
   template <typename T>
@@ -7,6 +7,7 @@
 #include "vast/concept/serializable/std/array.hpp"
 #include "vast/concept/serializable/std/vector.hpp"
 #include "vast/concept/serializable/std/unordered_map.hpp"
+#include "vast/concept/serializable/vast/util/mapped_vector.hpp"
 #include "vast/concept/state/bitmap.hpp"
 
 #endif
@@ -4,6 +4,11 @@
 #include "vast/bitmap_index.hpp"
 #include "vast/concept/serializable/std/array.hpp"
 #include "vast/concept/serializable/std/chrono.hpp"
+#include "vast/concept/serializable/std/map.hpp"
+#include "vast/concept/serializable/std/pair.hpp"
+#include "vast/concept/serializable/std/string.hpp"
+#include "vast/concept/serializable/std/unordered_map.hpp"
+#include "vast/concept/serializable/std/vector.hpp"
 #include "vast/concept/serializable/vast/bitmap.hpp"
 #include "vast/concept/serializable/vast/none.hpp"
 #include "vast/concept/state/bitmap_index.hpp"
@@ -4,6 +4,7 @@
 #include "vast/bitstream.hpp"
 #include "vast/bitstream_polymorphic.hpp"
 #include "vast/concept/serializable/hierarchy.hpp"
+#include "vast/concept/serializable/vast/util/mapped_vector.hpp"
 #include "vast/concept/state/bitstream_polymorphic.hpp"
 
 namespace vast {
@@ -8,6 +8,7 @@
 #include "vast/concept/serializable/std/vector.hpp"
 #include "vast/concept/serializable/vast/schema.hpp"
 #include "vast/concept/serializable/vast/util/flat_set.hpp"
+#include "vast/concept/serializable/vast/util/mapped_vector.hpp"
 #include "vast/concept/serializable/vast/util/range_map.hpp"
 #include "vast/concept/state/chunk.hpp"
 #include "vast/concept/state/uuid.hpp"
@@ -9,6 +9,7 @@
 #include "vast/concept/serializable/std/vector.hpp"
 #include "vast/concept/serializable/vast/data.hpp"
 #include "vast/concept/serializable/vast/type.hpp"
+#include "vast/concept/serializable/vast/util/interned.hpp"
 #include "vast/concept/serializable/vast/util/variant.hpp"
 #include "vast/concept/state/expression.hpp"
 
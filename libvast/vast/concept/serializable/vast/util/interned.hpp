@@ -0,0 +1,33 @@
+#ifndef VAST_CONCEPT_SERIALIZABLE_VAST_UTIL_INTERNED_HPP
+#define VAST_CONCEPT_SERIALIZABLE_VAST_UTIL_INTERNED_HPP
+
+#include "vast/concept/serializable/builtin.hpp"
+#include "vast/util/interned.hpp"
+
+namespace vast {
+
+template <typename Serializer, typename T>
+void serialize(Serializer& sink, util::interned<T> const& x) {
+  if (x)
+    sink << true << *x;
+  else
+    sink << false;
+}
+
+// Re-interns the value, so that it shares the node of existing equal values.
+template <typename Deserializer, typename T>
+void deserialize(Deserializer& source, util::interned<T>& x) {
+  bool flag;
+  source >> flag;
+  if (!flag) {
+    x = {};
+    return;
+  }
+  T value;
+  source >> value;
+  x = util::interned<T>{std::move(value)};
+}
+
+} // namespace vast
+
+#endif
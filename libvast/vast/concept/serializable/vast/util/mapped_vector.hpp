@@ -0,0 +1,68 @@
+#ifndef VAST_CONCEPT_SERIALIZABLE_VAST_UTIL_MAPPED_VECTOR_HPP
+#define VAST_CONCEPT_SERIALIZABLE_VAST_UTIL_MAPPED_VECTOR_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "vast/util/byte_swap.hpp"
+#include "vast/util/mapped_vector.hpp"
+
+namespace vast {
+
+// The elements go out as raw bytes in little-endian byte order, aligned to
+// their natural boundary. This allows for viewing them in place when the
+// deserializer reads from memory-mapped storage on a little-endian host.
+// Big-endian hosts convert the elements instead.
+
+template <typename Serializer, typename T>
+void serialize(Serializer& sink, util::mapped_vector<T> const& v) {
+  static_assert(std::is_arithmetic<T>::value, "T is no arithmetic type");
+  sink.begin_sequence(v.size());
+  sink.align(alignof(T));
+  if (!v.empty()) {
+    if (host_endian == little_endian) {
+      sink.write(v.data(), v.size() * sizeof(T));
+    } else {
+      std::vector<T> xs(v.data(), v.data() + v.size());
+      for (auto& x : xs)
+        x = util::byte_swap<host_endian, little_endian>(x);
+      sink.write(xs.data(), xs.size() * sizeof(T));
+    }
+  }
+  sink.end_sequence();
+}
+
+template <typename Deserializer, typename T>
+void deserialize(Deserializer& source, util::mapped_vector<T>& v) {
+  static_assert(std::is_arithmetic<T>::value, "T is no arithmetic type");
+  auto size = source.begin_sequence();
+  source.align(alignof(T));
+  if (size == 0) {
+    v.clear();
+  } else {
+    auto bytes = size * sizeof(T);
+    auto view = source.view(bytes);
+    auto aligned = reinterpret_cast<uintptr_t>(view.get()) % alignof(T) == 0;
+    if (view && aligned && host_endian == little_endian) {
+      v = {std::static_pointer_cast<T const>(view), size};
+    } else {
+      std::vector<T> xs(size);
+      if (view)
+        std::memcpy(xs.data(), view.get(), bytes);
+      else
+        source.read(xs.data(), bytes);
+      if (host_endian != little_endian)
+        for (auto& x : xs)
+          x = util::byte_swap<little_endian, host_endian>(x);
+      v = util::mapped_vector<T>{std::move(xs)};
+    }
+  }
+  source.end_sequence();
+}
+
+} // namespace vast
+
+#endif
@@ -4,6 +4,7 @@
 #include "vast/bitmap_index.hpp"
 #include "vast/concept/state/bitmap.hpp"
 #include "vast/concept/state/time.hpp"
+#include "vast/concept/state/util/hyperloglog.hpp"
 #include "vast/util/meta.hpp"
 
 namespace vast {
@@ -22,7 +23,26 @@ struct access::state<arithmetic_bitmap_index<Bitstream, Z, Binner>> {
   static void call(T&& x, F f) {
     using super = typename std::decay_t<decltype(x)>::super;
     using base = util::deduce<decltype(x), super>;
-    f(static_cast<base>(x), x.bitmap_);
+    f(static_cast<base>(x), x.coding_, x.sample_size_, x.rows_, x.sample_,
+      x.bitmap_, x.bitslice_, x.dictionary_, x.values_, x.codes_);
+  }
+};
+
+template <>
+struct access::state<detail::time_block> {
+  template <typename T, typename F>
+  static void call(T&& x, F f) {
+    f(x.min, x.max, x.first_row, x.last_row, x.sorted);
+  }
+};
+
+template <typename Bitstream>
+struct access::state<time_bitmap_index<Bitstream>> {
+  template <typename T, typename F>
+  static void call(T&& x, F f) {
+    using super = typename std::decay_t<decltype(x)>::super;
+    using base = util::deduce<decltype(x), super>;
+    f(static_cast<base>(x), x.block_size_, x.values_, x.blocks_, x.rows_);
   }
 };
 
@@ -32,7 +52,18 @@ struct access::state<string_bitmap_index<Bitstream>> {
   static void call(T&& x, F f) {
     using super = typename std::decay_t<decltype(x)>::super;
     using base = util::deduce<decltype(x), super>;
-    f(static_cast<base>(x), x.bitmaps_, x.length_);
+    f(static_cast<base>(x), x.bitmaps_, x.length_, x.distinct_);
+  }
+};
+
+template <typename Bitstream>
+struct access::state<dictionary_bitmap_index<Bitstream>> {
+  template <typename T, typename F>
+  static void call(T&& x, F f) {
+    using super = typename std::decay_t<decltype(x)>::super;
+    using base = util::deduce<decltype(x), super>;
+    f(static_cast<base>(x), x.dictionary_, x.digests_, x.codes_,
+      x.patterns_);
   }
 };
 
@@ -42,7 +73,7 @@ struct access::state<address_bitmap_index<Bitstream>> {
   static void call(T&& x, F f) {
     using super = typename std::decay_t<decltype(x)>::super;
     using base = util::deduce<decltype(x), super>;
-    f(static_cast<base>(x), x.bitmaps_, x.v4_);
+    f(static_cast<base>(x), x.bitmaps_, x.v4_, x.distinct_);
   }
 };
 
@@ -29,7 +29,18 @@ struct access::state<sequence_bitmap_index<Bitstream>> {
   static void call(T&& x, F f) {
     using super = typename std::decay_t<decltype(x)>::super;
     using base = util::deduce<decltype(x), super>;
-    f(static_cast<base>(x), x.elem_type_, x.bmis_, x.size_);
+    f(static_cast<base>(x), x.elem_type_, x.positional_, x.elements_, x.starts_,
+      x.positions_, x.rows_);
+  }
+};
+
+template <typename Bitstream>
+struct access::state<table_bitmap_index<Bitstream>> {
+  template <typename T, typename F>
+  static void call(T&& x, F f) {
+    using super = typename std::decay_t<decltype(x)>::super;
+    using base = util::deduce<decltype(x), super>;
+    f(static_cast<base>(x), x.key_type_, x.keys_, x.starts_, x.rows_);
   }
 };
 
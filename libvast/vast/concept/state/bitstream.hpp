@@ -16,9 +16,19 @@ struct access::state<null_bitstream> {
 
 template <>
 struct access::state<ewah_bitstream> {
-  template <typename Bitstream, typename F>
-  static void call(Bitstream&& bs, F f) {
+  template <typename F>
+  static void call(ewah_bitstream const& bs, F f) {
+    f(bs.num_bits_, bs.last_marker_, bs.bits_);
+  }
+
+  template <typename F>
+  static void call(ewah_bitstream& bs, F f) {
     f(bs.num_bits_, bs.last_marker_, bs.bits_);
+    // The bits may have changed underneath an attached directory.
+    if (bs.directory_) {
+      bs.directory_->reset();
+      bs.catch_up();
+    }
   }
 };
 
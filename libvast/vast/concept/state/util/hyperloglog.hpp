@@ -0,0 +1,19 @@
+#ifndef VAST_CONCEPT_STATE_UTIL_HYPERLOGLOG_HPP
+#define VAST_CONCEPT_STATE_UTIL_HYPERLOGLOG_HPP
+
+#include "vast/access.hpp"
+#include "vast/util/hyperloglog.hpp"
+
+namespace vast {
+
+template <int P>
+struct access::state<util::hyperloglog<P>> {
+  template <typename T, typename F>
+  static void call(T&& x, F f) {
+    f(x.registers_);
+  }
+};
+
+} // namespace vast
+
+#endif
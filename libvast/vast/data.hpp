@@ -280,4 +280,15 @@ private:
 
 } // namespace vast
 
+namespace std {
+
+/// Hashes data consistently with its equality: equal data yields equal
+/// digests. Containers and patterns only contribute their kind.
+template <>
+struct hash<vast::data> {
+  size_t operator()(vast::data const& x) const;
+};
+
+} // namespace std
+
 #endif
@@ -0,0 +1,67 @@
+#ifndef VAST_EXPR_CHECKER_HPP
+#define VAST_EXPR_CHECKER_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "vast/expression.hpp"
+#include "vast/type.hpp"
+
+namespace vast {
+
+class event;
+
+namespace expr {
+
+/// A resolved expression compiled for events of a single type. Compilation
+/// flattens the expression into a sequence of nodes in prefix order and
+/// resolves everything which does not depend on a particular event: the
+/// type checks of data extractors, event name comparisons, and the comparison
+/// function of each predicate, which for scalar operands compares the values
+/// directly instead of dispatching on the variant tags of both sides. The
+/// semantics are the same as applying the ::event_evaluator.
+class checker {
+public:
+  /// Constructs a checker which rejects all events.
+  checker() = default;
+
+  /// Compiles a resolved expression.
+  /// @param expr The expression to compile, resolved for *t*.
+  /// @param t The type of the events to check.
+  checker(expression const& expr, type const& t);
+
+  /// Checks whether an event satisfies the compiled expression.
+  /// @param e The event to check.
+  /// @returns `true` iff *e* satisfies the expression.
+  bool operator()(event const& e) const;
+
+  /// Retrieves the number of nodes of the compiled expression.
+  /// @returns The size of the program.
+  size_t size() const;
+
+private:
+  using comparator = bool (*)(data const&, relational_operator, data const&);
+
+  struct node {
+    enum kind_type : uint8_t { constant, all, any, negation, timestamp, field };
+    kind_type kind;
+    bool value;
+    relational_operator op;
+    uint32_t arity;
+    uint32_t size;
+    comparator compare;
+    vast::offset offset;
+    data rhs;
+  };
+
+  struct compiler;
+
+  bool run(size_t i, event const& e, record const* r) const;
+
+  std::vector<node> nodes_;
+};
+
+} // namespace expr
+} // namespace vast
+
+#endif
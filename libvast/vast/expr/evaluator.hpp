@@ -48,14 +48,28 @@ struct bitstream_evaluator {
   }
 
   Bitstream operator()(conjunction const& con) const {
-    auto hits = visit(*this, con[0]);
-    if (hits.empty() || hits.all_zeros())
-      return {};
-    for (size_t i = 1; i < con.size(); ++i) {
-      hits &= visit(*this, con[i]);
-      if (hits.empty() || hits.all_zeros()) // short-circuit
+    // Predicates merely require a lookup, whereas compound operands require
+    // an evaluation. We therefore intersect all predicates first and only
+    // evaluate the remaining operands if hits are left.
+    Bitstream hits;
+    auto first = true;
+    auto intersect = [&](Bitstream const& bs) {
+      if (first)
+        hits = bs;
+      else
+        hits &= bs;
+      first = false;
+      return !hits.empty() && !hits.all_zeros();
+    };
+    for (auto& op : con)
+      if (auto p = get<predicate>(op)) {
+        auto bs = static_cast<Derived const*>(this)->lookup(*p);
+        if (!bs || !intersect(*bs)) // short-circuit
+          return {};
+      }
+    for (auto& op : con)
+      if (!is<predicate>(op) && !intersect(visit(*this, op)))
         return {};
-    }
     return hits;
   }
 
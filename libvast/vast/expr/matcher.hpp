@@ -0,0 +1,67 @@
+#ifndef VAST_EXPR_MATCHER_HPP
+#define VAST_EXPR_MATCHER_HPP
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/expression.hpp"
+#include "vast/type.hpp"
+
+namespace vast {
+
+class event;
+
+namespace expr {
+
+/// Matches a stream of events against a set of standing expressions without
+/// going through bitmap indexes. For each event type, the matcher compiles
+/// all expressions into a single program that shares the work of predicate
+/// evaluation: every distinct predicate gets evaluated at most once per event,
+/// and predicates on the same field get answered together through a hash
+/// table for equality and set membership, sorted bounds for ranges, and a
+/// prefix trie for subnet membership. The semantics are the same as resolving
+/// an expression for the event type and applying the ::event_evaluator.
+class matcher {
+public:
+  matcher();
+  ~matcher();
+
+  /// Registers an expression.
+  /// @param expr The expression to match.
+  /// @returns `true` iff *expr* was not yet registered.
+  bool add(expression const& expr);
+
+  /// Unregisters an expression.
+  /// @param expr The expression to remove.
+  /// @returns `true` iff *expr* was registered.
+  bool remove(expression const& expr);
+
+  /// Checks whether the matcher has no expressions registered.
+  /// @returns `true` iff no expression is registered.
+  bool empty() const;
+
+  /// Retrieves the registered expressions.
+  /// @returns The expressions in the order of registration.
+  std::vector<expression> const& expressions() const;
+
+  /// Evaluates all registered expressions against an event.
+  /// @param e The event to match.
+  /// @returns The positions of the expressions in ::expressions which *e*
+  ///          satisfies. The result remains valid until the next call.
+  std::vector<size_t> const& match(event const& e);
+
+private:
+  struct program;
+
+  program& compile(type const& t);
+
+  std::vector<expression> exprs_;
+  std::unordered_map<type, std::unique_ptr<program>> programs_;
+  std::vector<size_t> matches_;
+};
+
+} // namespace expr
+} // namespace vast
+
+#endif
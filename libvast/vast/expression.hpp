@@ -9,6 +9,7 @@
 #include "vast/expr/normalize.hpp"
 #include "vast/expr/validator.hpp"
 #include "vast/util/assert.hpp"
+#include "vast/util/interned.hpp"
 #include "vast/util/variant.hpp"
 
 namespace vast {
@@ -188,6 +189,27 @@ private:
   node node_;
 };
 
+/// A hash-consed predicate, e.g., to key per-predicate state.
+using interned_predicate = util::interned<predicate>;
+
+/// A hash-consed expression, e.g., to key per-query state and to pass queries
+/// between actors without copying and comparing entire trees.
+using interned_expression = util::interned<expression>;
+
 } // namespace vast
 
+namespace std {
+
+template <>
+struct hash<vast::predicate> {
+  size_t operator()(vast::predicate const& p) const;
+};
+
+template <>
+struct hash<vast::expression> {
+  size_t operator()(vast::expression const& e) const;
+};
+
+} // namespace std
+
 #endif
@@ -295,6 +295,12 @@ void create_symlink(path const& target, path const& link);
 /// @returns `true` if *p* has been successfully deleted.
 bool rm(path const& p);
 
+/// Moves a file to a new location, atomically replacing an existing file.
+/// @param from The path of the file to move.
+/// @param to The destination path.
+/// @returns `true` on success.
+bool mv(path const& from, path const& to);
+
 /// If the path does not exist, create it as directory.
 /// @param p The path to a directory to create.
 /// @returns `true` on success or if *p* exists already.
@@ -0,0 +1,44 @@
+#ifndef VAST_IO_MAPPED_FILE_HPP
+#define VAST_IO_MAPPED_FILE_HPP
+
+#include <cstddef>
+
+#include "vast/filesystem.hpp"
+
+namespace vast {
+namespace io {
+
+/// A file mapped read-only into memory. The mapping begins at a page
+/// boundary, so that data aligned in the file is aligned in memory as well.
+class mapped_file {
+  mapped_file(mapped_file const&) = delete;
+  mapped_file& operator=(mapped_file const&) = delete;
+
+public:
+  /// Maps a file into memory.
+  /// @param filename The file to map.
+  explicit mapped_file(path const& filename);
+
+  /// Unmaps the file.
+  ~mapped_file();
+
+  /// Checks whether the mapping succeeded.
+  /// @returns `true` if the contents of the file are accessible.
+  bool is_open() const;
+
+  /// @returns A pointer to the beginning of the mapped contents.
+  void const* data() const;
+
+  /// @returns The size of the mapped contents in bytes.
+  size_t size() const;
+
+private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+  bool is_open_ = false;
+};
+
+} // namespace io
+} // namespace vast
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef VAST_PATTERN_HPP
 #define VAST_PATTERN_HPP
 
+#include <memory>
 #include <string>
 
 #include "vast/util/operators.hpp"
@@ -9,7 +10,9 @@ namespace vast {
 
 struct access;
 
-/// A regular expression.
+/// A regular expression. Matching runs on an automaton which a pattern
+/// compiles on first use and shares with all other patterns of the same
+/// expression.
 class pattern : util::totally_ordered<pattern> {
   friend access;
 
@@ -28,6 +31,11 @@ public:
   /// Default-constructs an empty pattern.
   pattern() = default;
 
+  pattern(pattern const& other);
+  pattern(pattern&&) = default;
+  pattern& operator=(pattern const& other);
+  pattern& operator=(pattern&&) = default;
+
   friend bool operator==(pattern const& lhs, pattern const& rhs);
   friend bool operator<(pattern const& lhs, pattern const& rhs);
 
@@ -45,8 +53,20 @@ public:
   /// @returns `true` if the pattern matches inside *str*.
   bool search(std::string const& str) const;
 
+  /// Extracts the literal prefix of the pattern, i.e., the longest string
+  /// that every string matching the pattern exactly must begin with.
+  /// @returns The literal prefix of the pattern, which may be empty.
+  std::string literal_prefix() const;
+
 private:
+  struct compiled;
+
+  static std::shared_ptr<compiled const> compile(std::string const& str);
+
+  std::shared_ptr<compiled const> automaton() const;
+
   std::string str_;
+  mutable std::shared_ptr<compiled const> compiled_;
 };
 
 } // namespace vast
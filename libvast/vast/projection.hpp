@@ -0,0 +1,57 @@
+#ifndef VAST_PROJECTION_HPP
+#define VAST_PROJECTION_HPP
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/key.hpp"
+#include "vast/offset.hpp"
+#include "vast/type.hpp"
+#include "vast/util/variant.hpp"
+
+namespace vast {
+
+class event;
+
+/// Selects a subset of the fields of events. A projection consists of a
+/// sequence of fields, each of which is either a key suffix, possibly with
+/// glob patterns, or an offset. For each event type, the projection derives a
+/// flat record type of the same name whose arguments are the selected fields
+/// in order, named by their full key. Events of a non-record type remain
+/// unchanged.
+class projection {
+public:
+  /// Constructs a projection which selects all fields.
+  projection() = default;
+
+  /// Constructs a projection from a list of fields.
+  /// @param fields The fields to select. A field consisting of
+  ///               comma-separated numbers is an offset, and any other field
+  ///               a dot-separated key.
+  explicit projection(std::vector<std::string> const& fields);
+
+  /// Projects an event onto the selected fields.
+  /// @param e The event to project.
+  /// @returns The projection of *e*, retaining ID and timestamp.
+  event operator()(event const& e);
+
+  /// Checks whether the projection selects all fields.
+  /// @returns `true` iff the projection has no fields.
+  bool empty() const;
+
+private:
+  struct plan {
+    vast::type type;
+    std::vector<offset> offsets;
+  };
+
+  plan const* lookup(type const& t);
+
+  std::vector<util::variant<key, offset>> fields_;
+  std::unordered_map<type, plan> plans_;
+};
+
+} // namespace vast
+
+#endif
@@ -7,7 +7,9 @@ namespace vast {
 enum class query_options : uint32_t {
   none = 0x00,
   historical = 0x01,
-  continuous = 0x02
+  continuous = 0x02,
+  newest_first = 0x04,
+  explain = 0x08
 };
 
 /// Concatenates two query options.
@@ -21,6 +23,8 @@ constexpr query_options no_query_options = query_options::none;
 constexpr query_options historical = query_options::historical;
 constexpr query_options continuous = query_options::continuous;
 constexpr query_options unified = historical + continuous;
+constexpr query_options newest_first = query_options::newest_first;
+constexpr query_options explain = query_options::explain;
 
 constexpr bool has_query_option(query_options haystack, query_options needle) {
   return (static_cast<uint32_t>(haystack) & static_cast<uint32_t>(needle)) != 0;
@@ -34,6 +38,14 @@ constexpr bool has_continuous_option(query_options opts) {
   return has_query_option(opts, continuous);
 }
 
+constexpr bool has_newest_first_option(query_options opts) {
+  return has_query_option(opts, newest_first);
+}
+
+constexpr bool has_explain_option(query_options opts) {
+  return has_query_option(opts, explain);
+}
+
 constexpr bool has_unified_option(query_options opts) {
   return has_query_option(opts, historical)
          && has_query_option(opts, continuous);
@@ -53,7 +53,8 @@ public:
     enum key_type : uint16_t {
       invalid,
       skip,
-      default_
+      default_,
+      index
     };
 
     attribute(key_type k = invalid, std::string v = {});
@@ -0,0 +1,76 @@
+#ifndef VAST_UTIL_HYPERLOGLOG_HPP
+#define VAST_UTIL_HYPERLOGLOG_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "vast/util/operators.hpp"
+
+namespace vast {
+
+struct access;
+
+namespace util {
+
+/// A HyperLogLog sketch which estimates the number of distinct elements in a
+/// stream of hash digests using 2^*P* one-byte registers.
+/// @tparam P The number of bits selecting a register.
+template <int P = 6>
+class hyperloglog : equality_comparable<hyperloglog<P>> {
+  static_assert(P >= 4 && P <= 16, "precision out of range");
+  friend access;
+
+public:
+  static constexpr size_t num_registers = size_t{1} << P;
+
+  /// Adds a hash digest to the sketch.
+  /// @param digest The uniformly distributed hash of an element.
+  void add(uint64_t digest) {
+    if (registers_.empty())
+      registers_.resize(num_registers, 0);
+    auto i = digest >> (64 - P);
+    auto w = digest << P;
+    uint8_t rank = 1;
+    while (rank <= 64 - P && (w & (uint64_t{1} << 63)) == 0) {
+      w <<= 1;
+      ++rank;
+    }
+    if (rank > registers_[i])
+      registers_[i] = rank;
+  }
+
+  /// Estimates the number of distinct digests added so far.
+  /// @returns The estimated cardinality.
+  uint64_t estimate() const {
+    if (registers_.empty())
+      return 0;
+    auto m = static_cast<double>(num_registers);
+    auto sum = 0.0;
+    auto zeros = 0u;
+    for (auto r : registers_) {
+      sum += std::ldexp(1.0, -r);
+      if (r == 0)
+        ++zeros;
+    }
+    auto alpha = P == 4 ? 0.673 : P == 5 ? 0.697 : P == 6 ? 0.709
+                                                          : 0.7213 / (1 + 1.079 / m);
+    auto e = alpha * m * m / sum;
+    // Small-range correction via linear counting.
+    if (e <= 2.5 * m && zeros > 0)
+      e = m * std::log(m / zeros);
+    return static_cast<uint64_t>(e + 0.5);
+  }
+
+  friend bool operator==(hyperloglog const& x, hyperloglog const& y) {
+    return x.registers_ == y.registers_;
+  }
+
+private:
+  std::vector<uint8_t> registers_;
+};
+
+} // namespace util
+} // namespace vast
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef VAST_UTIL_INTERNED_HPP
+#define VAST_UTIL_INTERNED_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "vast/util/assert.hpp"
+#include "vast/util/operators.hpp"
+
+namespace vast {
+namespace util {
+
+/// An immutable, hash-consed value. All structurally equal values which are
+/// alive at the same time share a single node, which carries a unique ID and
+/// the cached hash of the value. Comparing, hashing, and copying an interned
+/// value thus take constant time. The ID of a value remains stable as long as
+/// some instance refers to it. Interning is thread-safe.
+/// @tparam T A type which models `std::hash` and equality comparison.
+template <typename T>
+class interned : totally_ordered<interned<T>> {
+  struct node {
+    T value;
+    size_t hash;
+    uint64_t id;
+  };
+
+  struct table {
+    std::mutex mutex;
+    std::unordered_multimap<size_t, std::weak_ptr<node const>> nodes;
+    uint64_t next_id = 1;
+  };
+
+  static table& instance() {
+    // Leaked deliberately, because values may outlive static destruction.
+    static auto t = new table;
+    return *t;
+  }
+
+public:
+  /// Constructs an empty instance.
+  interned() = default;
+
+  /// Interns a value.
+  /// @param x The value to intern.
+  explicit interned(T x) {
+    auto h = std::hash<T>{}(x);
+    auto& t = instance();
+    // Any node we happen to lock may die with our reference, which must
+    // not occur while holding the lock.
+    std::vector<std::shared_ptr<node const>> locked;
+    std::lock_guard<std::mutex> guard{t.mutex};
+    auto range = t.nodes.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i) {
+      auto n = i->second.lock();
+      if (n && n->value == x) {
+        node_ = std::move(n);
+        return;
+      }
+      if (n)
+        locked.push_back(std::move(n));
+    }
+    auto deleter = [](node const* n) {
+      auto& t = instance();
+      {
+        std::lock_guard<std::mutex> guard{t.mutex};
+        auto range = t.nodes.equal_range(n->hash);
+        for (auto i = range.first; i != range.second; )
+          if (i->second.expired())
+            i = t.nodes.erase(i);
+          else
+            ++i;
+      }
+      delete n;
+    };
+    node_.reset(new node{std::move(x), h, t.next_id++}, deleter);
+    t.nodes.emplace(h, node_);
+  }
+
+  /// Looks up a value without interning it.
+  /// @param x The value to look for.
+  /// @returns The interned instance of *x* or an empty instance if no
+  ///          instance of *x* is alive.
+  static interned find(T const& x) {
+    auto h = std::hash<T>{}(x);
+    auto& t = instance();
+    interned result;
+    std::vector<std::shared_ptr<node const>> locked;
+    std::lock_guard<std::mutex> guard{t.mutex};
+    auto range = t.nodes.equal_range(h);
+    for (auto i = range.first; i != range.second; ++i) {
+      auto n = i->second.lock();
+      if (n && n->value == x) {
+        result.node_ = std::move(n);
+        break;
+      }
+      if (n)
+        locked.push_back(std::move(n));
+    }
+    return result;
+  }
+
+  /// Retrieves the ID of the value.
+  /// @returns The non-zero ID of the value, or 0 if `*this` is empty.
+  uint64_t id() const {
+    return node_ ? node_->id : 0;
+  }
+
+  /// Retrieves the cached hash of the value.
+  /// @returns The hash of the value.
+  size_t hash() const {
+    return node_ ? node_->hash : 0;
+  }
+
+  explicit operator bool() const {
+    return node_ != nullptr;
+  }
+
+  T const& operator*() const {
+    VAST_ASSERT(node_);
+    return node_->value;
+  }
+
+  T const* operator->() const {
+    VAST_ASSERT(node_);
+    return &node_->value;
+  }
+
+  friend bool operator==(interned const& x, interned const& y) {
+    return x.node_ == y.node_;
+  }
+
+  /// Orders values by ID, i.e., by the time of interning.
+  friend bool operator<(interned const& x, interned const& y) {
+    return x.id() < y.id();
+  }
+
+private:
+  std::shared_ptr<node const> node_;
+};
+
+} // namespace util
+} // namespace vast
+
+namespace std {
+
+template <typename T>
+struct hash<vast::util::interned<T>> {
+  size_t operator()(vast::util::interned<T> const& x) const {
+    return x.hash();
+  }
+};
+
+} // namespace std
+
+#endif
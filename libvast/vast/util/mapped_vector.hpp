@@ -0,0 +1,175 @@
+#ifndef VAST_UTIL_MAPPED_VECTOR_HPP
+#define VAST_UTIL_MAPPED_VECTOR_HPP
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "vast/util/assert.hpp"
+#include "vast/util/operators.hpp"
+
+namespace vast {
+namespace util {
+
+/// A contiguous sequence of trivially copyable elements which either owns its
+/// elements on the heap or views read-only memory kept alive by a shared
+/// owner, e.g., a memory-mapped file. Read access never copies. Every
+/// non-const access first promotes a view into an owned copy
+/// (*copy-on-write*), so that the mapped memory never gets modified.
+template <typename T>
+class mapped_vector : equality_comparable<mapped_vector<T>> {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "mapped_vector requires trivially copyable elements");
+
+  friend bool operator==(mapped_vector const& x, mapped_vector const& y) {
+    return x.size() == y.size() && std::equal(x.begin(), x.end(), y.begin());
+  }
+
+public:
+  using vector_type = std::vector<T>;
+  using value_type = T;
+  using size_type = typename vector_type::size_type;
+  using reference = T&;
+  using const_reference = T const&;
+  using iterator = T*;
+  using const_iterator = T const*;
+
+  mapped_vector() = default;
+
+  /// Constructs an owning vector of a given size.
+  /// @param n The number of elements.
+  /// @param x The value of each element.
+  mapped_vector(size_type n, T const& x) : owned_(n, x) {
+  }
+
+  /// Constructs an owning vector by taking over an STL vector.
+  /// @param xs The elements.
+  explicit mapped_vector(vector_type xs) : owned_(std::move(xs)) {
+  }
+
+  /// Constructs a view over read-only memory.
+  /// @param data The first element, whose lifetime *data* controls.
+  /// @param n The number of elements at *data*.
+  mapped_vector(std::shared_ptr<T const> data, size_type n)
+    : view_{std::move(data)},
+      view_size_{n} {
+    VAST_ASSERT(view_ || n == 0);
+  }
+
+  /// Checks whether the vector views foreign memory.
+  /// @returns `true` iff the vector has not yet been promoted to the heap.
+  bool mapped() const {
+    return view_ != nullptr;
+  }
+
+  /// Copies viewed elements to the heap and releases the view.
+  void materialize() {
+    if (!view_)
+      return;
+    owned_.assign(view_.get(), view_.get() + view_size_);
+    view_.reset();
+    view_size_ = 0;
+  }
+
+  // -- access ---------------------------------------------------------------
+
+  T const* data() const {
+    return view_ ? view_.get() : owned_.data();
+  }
+
+  T* data() {
+    materialize();
+    return owned_.data();
+  }
+
+  size_type size() const {
+    return view_ ? view_size_ : owned_.size();
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  const_iterator begin() const {
+    return data();
+  }
+
+  const_iterator end() const {
+    return data() + size();
+  }
+
+  iterator begin() {
+    return data();
+  }
+
+  iterator end() {
+    return data() + size();
+  }
+
+  const_reference operator[](size_type i) const {
+    VAST_ASSERT(i < size());
+    return data()[i];
+  }
+
+  reference operator[](size_type i) {
+    VAST_ASSERT(i < size());
+    return data()[i];
+  }
+
+  const_reference front() const {
+    return (*this)[0];
+  }
+
+  reference front() {
+    return (*this)[0];
+  }
+
+  const_reference back() const {
+    return (*this)[size() - 1];
+  }
+
+  reference back() {
+    return (*this)[size() - 1];
+  }
+
+  // -- modifiers ------------------------------------------------------------
+
+  void push_back(T const& x) {
+    materialize();
+    owned_.push_back(x);
+  }
+
+  template <typename InputIterator>
+  void insert(const_iterator pos, InputIterator first, InputIterator last) {
+    auto offset = pos - static_cast<mapped_vector const&>(*this).data();
+    materialize();
+    owned_.insert(owned_.begin() + offset, first, last);
+  }
+
+  void reserve(size_type n) {
+    materialize();
+    owned_.reserve(n);
+  }
+
+  void resize(size_type n, T const& x = T()) {
+    materialize();
+    owned_.resize(n, x);
+  }
+
+  void clear() {
+    view_.reset();
+    view_size_ = 0;
+    owned_.clear();
+  }
+
+private:
+  vector_type owned_;
+  std::shared_ptr<T const> view_;
+  size_type view_size_ = 0;
+};
+
+} // namespace util
+} // namespace vast
+
+#endif
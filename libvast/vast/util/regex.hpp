@@ -0,0 +1,54 @@
+#ifndef VAST_UTIL_REGEX_HPP
+#define VAST_UTIL_REGEX_HPP
+
+#include <memory>
+#include <string>
+
+namespace vast {
+namespace util {
+
+/// A regular expression in ECMAScript syntax which matches in time linear in
+/// the length of the input. The engine compiles the expression into an NFA
+/// and determinizes it lazily while matching, caching the DFA states it
+/// encounters in a bounded table. Expressions beyond regular languages, such
+/// as backreferences, lookaheads, and word boundaries, fall back to
+/// `std::regex`. A regex can be shared among threads.
+class regex {
+public:
+  /// Compiles a regular expression.
+  /// @param str The regular expression.
+  /// @throws std::regex_error if *str* is not a valid regular expression.
+  explicit regex(std::string const& str);
+
+  ~regex();
+
+  /// Matches an entire string.
+  /// @param first The beginning of the string.
+  /// @param last The end of the string.
+  /// @returns `true` iff the expression matches exactly `[first, last)`.
+  bool match(char const* first, char const* last) const;
+
+  /// Searches for a match inside a string.
+  /// @param first The beginning of the string.
+  /// @param last The end of the string.
+  /// @param at_begin Whether *first* is the beginning of the input, i.e.,
+  ///                 whether `^` can match at *first*.
+  /// @returns `true` iff the expression matches a substring of
+  ///          `[first, last)`.
+  bool search(char const* first, char const* last, bool at_begin = true) const;
+
+  /// Checks whether matching runs on the automaton.
+  /// @returns `false` iff the expression requires the fallback engine.
+  bool linear() const;
+
+private:
+  struct automaton;
+  struct cache;
+  struct impl;
+  std::unique_ptr<impl> impl_;
+};
+
+} // namespace util
+} // namespace vast
+
+#endif
@@ -21,9 +21,11 @@
 #include "vast/announce.hpp"
 #include "vast/banner.hpp"
 #include "vast/caf.hpp"
+#include "vast/event.hpp"
 #include "vast/filesystem.hpp"
 #include "vast/key.hpp"
 #include "vast/logger.hpp"
+#include "vast/time.hpp"
 #include "vast/uuid.hpp"
 #include "vast/actor/accountant.hpp"
 #include "vast/actor/atoms.hpp"
@@ -57,6 +59,7 @@ std::pair<message, message> parse_core_args(message const& input) {
   std::string index_events;
   std::string index_active;
   std::string index_passive;
+  std::string chunk_cache;
   auto r = input.extract_opts({
     {"identifier-batch-size", "initial identifier batch size", id_batch_size},
     {"archive-compression", "archive compression algorithm", archive_comp},
@@ -65,6 +68,7 @@ std::pair<message, message> parse_core_args(message const& input) {
     {"index-events", "maximum number of events per partition", index_events},
     {"index-active", "number of active partitions", index_active},
     {"index-passive", "number of passive partitions", index_passive},
+    {"chunk-cache", "size of the decoded chunk cache (MB)", chunk_cache},
     // FIXME: Because extract_opts unfortunately *always* defines -h, we have
     // to "haul it through" if it was set. :-/
     {"historical,h", "marks a query as historical"},
@@ -83,6 +87,8 @@ std::pair<message, message> parse_core_args(message const& input) {
     result = result + make_message("--index-active=" + index_active);
   if (r.opts.count("index-passive") > 0)
     result = result + make_message("--index-passive=" + index_passive);
+  if (r.opts.count("chunk-cache") > 0)
+    result = result + make_message("--chunk-cache=" + chunk_cache);
   // FIXME: see not above.
   if (r.opts.count("historical") > 0)
     r.remainder = r.remainder + make_message("-h" + index_passive);
@@ -219,11 +225,32 @@ int run_import(actor const& node, message args) {
   return 0;
 }
 
-int run_export(actor const& node, message sink_args, message export_args) {
+// A SINK for "vast explain" which prints the explanation of a query and
+// discards its results.
+behavior explainer(event_based_actor* self) {
+  self->trap_exit(true);
+  return {
+    downgrade_exit_msg(self),
+    [](accountant::type const&) {
+      // Nothing to account for.
+    },
+    [](uuid const&, std::vector<event> const&) {
+      // Explaining a query requires evaluating it, but not its results.
+    },
+    [](uuid const&, progress_atom, double, uint64_t) {
+    },
+    [](uuid const&, explain_atom, std::string const& plan) {
+      std::cout << plan << std::endl;
+    },
+    [](uuid const&, done_atom, time::extent) {
+    }
+  };
+}
+
+int run_export(actor const& node, trial<actor> snk, message export_args) {
   scoped_actor self;
   auto sig_mon = self->spawn<linked>(signal_monitor::make, self);
-  // 1. Spawn a SINK.
-  auto snk = sink::spawn(std::move(sink_args));
+  // 1. Check the SINK.
   if (!snk) {
     VAST_ERROR("failed to spawn sink:", snk.error());
     return 1;
@@ -387,6 +414,7 @@ int main(int argc, char* argv[]) {
   std::vector<std::string> commands = {
     "connect",
     "disconnect",
+    "explain",
     "export",
     "import",
     "quit",
@@ -608,9 +636,22 @@ int main(int argc, char* argv[]) {
       mb.append(*i++);
       while (i != command_line.end())
         mb.append(*i++);
-      return run_export(node, make_message(*(cmd + 1)),
+      return run_export(node, sink::spawn(make_message(*(cmd + 1))),
                         parse_core_args(mb.to_message()).second);
     }
+  } else if (*cmd == "explain") {
+    if (cmd + 1 == command_line.end()) {
+      VAST_ERROR("missing query arguments");
+      return 1;
+    }
+    // Explaining a query means running it historically.
+    message_builder mb;
+    mb.append("-h");
+    mb.append("-x");
+    for (auto i = cmd + 1; i != command_line.end(); ++i)
+      mb.append(*i);
+    return run_export(node, caf::spawn(explainer),
+                      parse_core_args(mb.to_message()).second);
   } else {
     auto args = std::vector<std::string>(cmd + 1, command_line.end());
     auto cmd_line = *cmd + util::join(args, " ");